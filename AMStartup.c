@@ -4,14 +4,35 @@
  * Connects to the host and creates a thread for each avatar in the game.
  * Then it runs the game.
  *
- * Usage: ./AMStartup -h hostname -d difficulty -n number of avatars
+ * Usage: ./AMStartup -h hostname -d difficulty -n number of avatars [-s strategy] [-e] [-q] [-a] [-z zoom] [-f avatar] [-t] [-c capture]
  *
- * Example: ./AMStartup -h flume.cs.dartmouth.edu -d 5 -n 4 
+ * Example: ./AMStartup -h flume.cs.dartmouth.edu -d 5 -n 4 -s incremental -e
+ *
+ * With -e every avatar is played from the main thread by one epoll loop (see eventloop.h)
+ * instead of a thread per avatar.
+ *
+ * With -q nothing is drawn and curses is never started: the only output is one summary line of
+ * key=value pairs (see README.md), and the timing reports go to the log file. Building with
+ * make TESTING=-DHEADLESS leaves the drawing out altogether and always runs as with -q.
+ *
+ * With -a the maze is drawn with ANSI escape sequences written straight to stdout instead of
+ * curses (see framebuffer.h). A maze bigger than the screen is shown through a viewport that
+ * follows avatar 0, or the avatar given with -f; -z n draws each n x n block of tiles as one character.
+ *
+ * With -t the log is written as a compact binary trace, Amazing_<user>_<n>_<d>.trace, instead of
+ * text (see logger.h); ./amtrace turns it back into the text log.
+ *
+ * With -c every message sent to and received from the server is recorded, with its time, into
+ * the capture file given (see capture.h); ./amreplay plays the game back from it without a server.
+ *
+ * The server is resolved once; every avatar connects to that address at the same time.
  * 
  * Connor Davis, Sean Simons, Luca Lit, and Mack Reiferson, Winter 2020.
  *
  */
 
+#define _POSIX_C_SOURCE 200809L   // getaddrinfo
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <curses.h>
@@ -22,90 +43,194 @@
 #include <getopt.h>	      // allows flag parsing
 #include <pthread.h>
 #include <time.h>
+#include <errno.h>
 #include "amazing.h"
 #include "avatar.h"
 #include "mazeSolver.h"
 #include "graphics.h"
+#include "rendezvous.h"
+#include "strategy.h"
+#include "eventloop.h"
+#include "conn.h"
+#include "latency.h"
+#include "render.h"
+#include "logger.h"
+#include "capture.h"
 
 /**************** file-local constants ****************/
 #define BUFSIZE 1024     // read/write buffer size
+#define USAGE "usage: %s -h hostname -d difficulty -n numAvatars [-s strategy] [-e] [-q] [-a] [-z zoom] [-f avatar] [-t] [-c capture]\n"
+
+// how the meeting point of the bfs and incremental strategies is chosen: make TESTING=-DRENDEZVOUS=RENDEZVOUS_MINSUM
+#ifndef RENDEZVOUS
+#define RENDEZVOUS RENDEZVOUS_MINMAX
+#endif
 
 /**************** main() ****************/
 int main(const int argc, char *argv[]) {
 
 	// Initialize necessary variables.
 	char *program;	  // this program's name
-	char *hostName;	  // server hostname
-	int port = 17235;      // server port
-	int difficulty;	  // maze difficulty
-	int avatarNum;	  // number of avatars
+	char *hostName = NULL;	  // server hostname, required
+	char *port = AM_SERVER_PORT;      // server port
+	int difficulty = -1;	  // maze difficulty, required
+	int avatarNum = -1;	  // number of avatars, required
+	char *strategyName = DEFAULT_STRATEGY;	  // how avatars choose their moves
+	bool eventLoop = false;	  // one epoll loop instead of a thread per avatar
+	bool ansi = false;	  // draw with ANSI sequences instead of curses
+	int zoom = 1;	  // tiles per character across, when zoomed out
+	int follow = -1;	  // avatar the view follows, -1 to choose when the maze is too big
+	bool trace = false;	  // write a binary trace instead of the text log
+	char *captureName = NULL;	  // file to record the server's messages into, if any
+#ifdef HEADLESS
+	bool headless = true;	  // no curses window, one summary line on stdout
+#else
+	bool headless = false;	  // no curses window, one summary line on stdout
+#endif
 
-	// Check & parse arguments
+	// Parse arguments
 	program = argv[0];
-	if (argc != 7) {
-		// Invalid number of arguments.
-		fprintf(stderr, "usage: %s -h hostname -d difficulty -n numAvatars\n", program);
-		exit (1);
-	} 
-	else {
-		// Handle flag parsing.
-		int opt;
-		while ((opt = getopt(argc, argv, "h:d:n:")) != -1)
-			switch (opt) {
-				// Handle setting the difficulty.
-				case 'd':
-					difficulty = atoi(optarg);
-					if (difficulty > 9 || difficulty < 0) {
-						fprintf(stderr, "Error, difficulty must be between 1 and 9\n");
-						exit(2);
-					}
-					break;
-				// Handle setting the number of avatars.
-				case 'n':
-					avatarNum = atoi(optarg);
-					if (avatarNum > 10 || avatarNum < 1) {
-						fprintf(stderr, "Error, number of avatars must be between 1 and 4\n");
-						exit(3);
-					}
-					break;
-				// Handle setting the hostname.
-				case 'h':
-					hostName = optarg;
-					break;
-				// Catch all other cases.
-				default:
-					abort();
-			}	
+	int opt;
+	while ((opt = getopt(argc, argv, "h:d:n:s:eqaz:f:tc:")) != -1)
+		switch (opt) {
+			// Handle setting the difficulty.
+			case 'd':
+				difficulty = atoi(optarg);
+				if (difficulty > 9 || difficulty < 0) {
+					fprintf(stderr, "Error, difficulty must be between 1 and 9\n");
+					exit(2);
+				}
+				break;
+			// Handle setting the number of avatars.
+			case 'n':
+				avatarNum = atoi(optarg);
+				if (avatarNum > 10 || avatarNum < 1) {
+					fprintf(stderr, "Error, number of avatars must be between 1 and 4\n");
+					exit(3);
+				}
+				break;
+			// Handle setting the hostname.
+			case 'h':
+				hostName = optarg;
+				break;
+			// Handle choosing the strategy.
+			case 's':
+				strategyName = optarg;
+				break;
+			// Handle choosing the event loop engine.
+			case 'e':
+				eventLoop = true;
+				break;
+			// Handle choosing headless mode.
+			case 'q':
+				headless = true;
+				break;
+			// Handle drawing without curses.
+			case 'a':
+				ansi = true;
+				break;
+			// Handle zooming out.
+			case 'z':
+				zoom = atoi(optarg);
+				if (zoom < 1) {
+					fprintf(stderr, "Error, zoom must be at least 1\n");
+					exit(1);
+				}
+				break;
+			// Handle choosing the avatar to follow.
+			case 'f':
+				follow = atoi(optarg);
+				break;
+			// Handle writing a binary trace.
+			case 't':
+				trace = true;
+				break;
+			// Handle recording a capture.
+			case 'c':
+				captureName = optarg;
+				break;
+			// Catch all other cases.
+			default:
+				fprintf(stderr, USAGE, program);
+				printStrategies(stderr);
+				exit(1);
+		}
+
+	// Check that the game was given in full.
+	const char *missing = hostName == NULL ? "-h hostname" : difficulty < 0 ? "-d difficulty" : avatarNum < 0 ? "-n numAvatars" : NULL;
+	if (missing != NULL || optind != argc) {
+		if (missing != NULL) {
+			fprintf(stderr, "Error, %s is required\n", missing);
+		}
+		fprintf(stderr, USAGE, program);
+		printStrategies(stderr);
+		exit(1);
 	}
 
-	// Create socket and perform safety check.
-	int comm_sock = socket(AF_INET, SOCK_STREAM, 0);
-	if (comm_sock < 0) {
-		perror("opening socket");
-		exit(4);
+	// The followed avatar must be one of the game's.
+	if (follow >= avatarNum) {
+		fprintf(stderr, "Error, can only follow avatars 0 to %d\n", avatarNum - 1);
+		exit(3);
+	}
+
+	// Look up the strategy before connecting, so a typo costs no game.
+	const strategy_t *strategy = findStrategy(strategyName);
+	if (strategy == NULL) {
+		fprintf(stderr, "Error, unknown strategy '%s', choose one of:\n", strategyName);
+		printStrategies(stderr);
+		exit(14);
 	}
 
-	// Initialize the fields of the server address
-	struct sockaddr_in server;  				// address of the server
-	server.sin_family = AF_INET;
-	server.sin_port = htons(port);
+	// Start the capture before connecting, so it holds the whole conversation with the server.
+	FILE *captureFile = NULL;
+	capture_t *capture = NULL;
+	if (captureName != NULL) {
+		captureFile = fopen(captureName, "w");
+		capture = captureFile != NULL ? captureNew(captureFile) : NULL;
+		if (capture == NULL) {
+			fprintf(stderr, "Error when creating capture %s\n", captureName);
+			exit(12);
+		}
+	}
 
-	// Look up the hostname specified on command line and perform safety check.
-	struct hostent *hostp = gethostbyname(hostName); 	// server hostname
-	if (hostp == NULL) {
+	// Look up the hostname specified on command line once; the avatars reuse the answer.
+	struct addrinfo hints;
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	struct addrinfo *addresses;
+	if (getaddrinfo(hostName, port, &hints, &addresses) != 0) {
 		fprintf(stderr, "%s: unknown host '%s'\n", program, hostName);
 		exit(5);
 	}
 
-	// Copy memory block.
-	memcpy(&server.sin_addr, hostp->h_addr_list[0], hostp->h_length);
-
-	// Connect the socket to the server.   
-	if (connect(comm_sock, (struct sockaddr *) &server, sizeof(server)) < 0) {
+	// Connect to the first address that answers and perform safety checks.
+	struct addrinfo *server;	  // address of the server
+	int comm_sock = -1;
+	for (server = addresses; server != NULL; server = server->ai_next) {
+		comm_sock = socket(server->ai_family, server->ai_socktype, server->ai_protocol);
+		if (comm_sock < 0) {
+			perror("opening socket");
+			exit(4);
+		}
+		if (connect(comm_sock, server->ai_addr, server->ai_addrlen) == 0) {
+			break;
+		}
+		close(comm_sock);
+		comm_sock = -1;
+	}
+	if (comm_sock < 0) {
 		perror("connecting stream socket");
 		exit(6);
 	}
-	printf("Connected!\n");
+	if (!headless) {
+		printf("Connected!\n");
+	}
+	conn_t *conn = connNew(comm_sock);
+	if (conn == NULL) {
+		exit(13);
+	}
+	connCapture(conn, capture, CAPTURE_STARTUP);
 
 	// Configure AM_INIT message.
 	AM_Message message;
@@ -116,20 +241,32 @@ int main(const int argc, char *argv[]) {
 	message.init.nAvatars = htonl(nAvatars);
 
 	// Send AM_INIT message.
-	send(comm_sock, (void *) &message, sizeof(message), 0);
-	printf("Initialization message sent.\n");
+	if (!connSend(conn, &message)) {
+		fprintf(stderr, "ERROR: could not send the initialization message.\n");
+		exit(17);
+	}
+	if (!headless) {
+		printf("Initialization message sent.\n");
+	}
 
-	// Store response values.
+	// Store response values, reading until the whole message is in.
 	AM_Message response;
-	int bytesReceived = recv(comm_sock, (void *) &response, sizeof(AM_Message), 0);
+	int bytesReceived = 1;
+	while (bytesReceived > 0 && connPeek(conn) == NULL) {
+		bytesReceived = connFill(conn, true);
+	}
+	if (bytesReceived > 0) {
+		response = *connPeek(conn);
+		connConsume(conn);
+	}
 	
 	// Check for empty message, otherwise continue.
-	if (bytesReceived < 0) {
+	if (bytesReceived <= 0) {
 		// Handle empty message.
 		fprintf(stderr, "ERROR: No message recieved.\n");
 		exit(7);
 	} else {
-		if (IS_AM_ERROR(response.type)) {
+		if (IS_AM_ERROR(ntohl(response.type))) {
 			// Handle failed initialization.
 			fprintf(stderr, "ERROR: initialization failed.\n");
 			exit(8);	
@@ -142,22 +279,24 @@ int main(const int argc, char *argv[]) {
 			// Check to see type of message
 			if (response.type == ntohl(AM_INIT_OK)) {
 				// Create log file for all threads share
-				mazeTile_t ***mazeArray = createMaze(ntohl(response.init_ok.MazeHeight), ntohl(response.init_ok.MazeWidth));
+				maze_t *mazeArray = createMaze(ntohl(response.init_ok.MazeHeight), ntohl(response.init_ok.MazeWidth));
+				rendezvous_t *rendezvous = rendezvousNew(mazeArray, RENDEZVOUS);
+				if (mazeArray == NULL || rendezvous == NULL) {
+					exit(13);
+				}
 				
 				// Print useful information to stdout.
-				printf("\nMaze Height:	%d\n", ntohl(response.init_ok.MazeHeight));
-				printf("Maze Width: 	%d\n", ntohl(response.init_ok.MazeWidth));
-				printf("Maze Port: 	%d\n", ntohl(response.init_ok.MazePort));
+				if (!headless) {
+					printf("\nMaze Height:	%d\n", ntohl(response.init_ok.MazeHeight));
+					printf("Maze Width: 	%d\n", ntohl(response.init_ok.MazeWidth));
+					printf("Maze Port: 	%d\n", ntohl(response.init_ok.MazePort));
+				}
 
-				// Set height and width variables.
-				int h = ntohl(response.init_ok.MazeHeight);
-				int w = ntohl(response.init_ok.MazeWidth);
-				
 				// Create the logfile name.
 				char *logName = malloc(sizeof(char)*100);
 				strcpy(logName, "log.out/Amazing_");
-				char avatarNumString[2];
-				char difficultyString[2];
+				char avatarNumString[12];
+				char difficultyString[12];
 				strcat(logName, getenv("USER"));
 				strcat(logName, "_");
 				sprintf(avatarNumString, "%d", avatarNum);
@@ -165,7 +304,12 @@ int main(const int argc, char *argv[]) {
 				strcat(logName, "_");
 				sprintf(difficultyString, "%d", difficulty);
 				strcat(logName, difficultyString);
-				printf("Logfile:	%s\n\n", logName);
+				if (trace) {
+					strcat(logName, ".trace");
+				}
+				if (!headless) {
+					printf("Logfile:	%s\n\n", logName);
+				}
 
 				// Open log file.
 				FILE *fp = fopen(logName, "w");
@@ -173,25 +317,29 @@ int main(const int argc, char *argv[]) {
 				// Initialize thread checker.
 				int threadChecker;
 
-				// Initialize window for curses to draw into.
-				WINDOW *mainwindow;
+				// Initialize window for curses to draw into, unless headless or drawing with ANSI sequences.
+				WINDOW *mainwindow = NULL;
 
 				// Safety check.
-				if ((mainwindow = initscr())== NULL){
-					printf("failed to initialise screen\n");
-					exit(EXIT_FAILURE);
-				}
+				if (!headless && !ansi) {
+					if ((mainwindow = initscr())== NULL){
+						printf("failed to initialise screen\n");
+						exit(EXIT_FAILURE);
+					}
 
-				start_color();
+					start_color();
+				}
 
 				// Check file creation.
 				if (fp != NULL) {
 					// If file is created, continue.
 					
-					// Initialize time variable and write first line of log file.
+					// Initialize time variable and write first line of log file; a trace starts with a header instead.
 					time_t currentTime = time(NULL);
 					struct tm *tm = localtime(&currentTime);
-					fprintf(fp, "%s, %d, %s\n", getenv("USER"), ntohl(response.init_ok.MazePort), asctime(tm));
+					if (!trace) {
+						fprintf(fp, "%s, %d, %s\n", getenv("USER"), ntohl(response.init_ok.MazePort), asctime(tm));
+					}
 
 					// Initialize array of threads and avatar index.
 					pthread_t threads[avatarNum];
@@ -208,20 +356,77 @@ int main(const int argc, char *argv[]) {
 					// Create avatar array for all threads to reference.
 					avatars = createAvatars(avatarNum);
 
+					// Each avatar times the phases of its turns into its own histograms.
+					latency_t *latency = latencyNew(avatarNum);
+					if (latency == NULL) {
+						exit(13);
+					}
+
+					// Drawing happens on its own thread, from turns the avatars publish; with no window it writes ANSI sequences.
+					renderer_t *renderer = NULL;
+					if (!headless) {
+						renderer = renderNew(mazeArray, avatarNum, mainwindow, zoom, follow);
+						if (renderer == NULL) {
+							free(logName);
+							exit(16);
+						}
+					}
+
+					// Avatars hand their log lines to a writer thread instead of writing them on their turn.
+					logger_t *logger;
+					if (trace) {
+						traceHeader_t header = { "", ntohl(response.init_ok.MazePort), currentTime, difficulty, avatarNum,
+								ntohl(response.init_ok.MazeHeight), ntohl(response.init_ok.MazeWidth) };
+						snprintf(header.user, sizeof(header.user), "%s", getenv("USER"));
+						logger = loggerNewTrace(fp, &header);
+					} else {
+						logger = loggerNew(fp, avatarNum);
+					}
+					if (logger == NULL) {
+						free(logName);
+						exit(12);
+					}
+
+					// The message that ended the game, kept by the first avatar to see it.
+					AM_Message ending;
+					memset(&ending, 0, sizeof(ending));
+
 					// Initialize remaining game state variables.
 					int lastTurnID = -1;
 					int solved = 0;
 					int moveCount = 0;
 
-					// Iterate number of avatar times.
+					// Time the game on the wall clock and in CPU time, to compare engines.
+					struct timespec start;
+					timespec_get(&start, TIME_UTC);
+					clock_t startCPU = clock();
+
+					// Set up every avatar's session.
+					avatarSession_t *sessions[AM_MAX_AVATAR];
 					for (avatarIdx = 0; avatarIdx < avatarNum; avatarIdx++) {
 						//Initialize a startup struct.	
 						startupInfo_t *initStruct = loadStartupStruct(&lock, avatarIdx, avatarNum, difficulty, 
-								hostName, ntohl(response.init_ok.MazePort), logName, avatars, &lastTurnID, 
-								mazeArray, &solved, ntohl(response.init_ok.MazeHeight), ntohl(response.init_ok.MazeWidth), mainwindow, fp, &moveCount);
-						
+								hostName, server, ntohl(response.init_ok.MazePort), logName, avatars, &lastTurnID, 
+								mazeArray, rendezvous, strategy, &solved, ntohl(response.init_ok.MazeHeight), ntohl(response.init_ok.MazeWidth), mainwindow, logger, &moveCount, latency, renderer, &ending);
+						sessions[avatarIdx] = avatarSessionNew(initStruct);
+					}
+
+					// Connect them all at once and time how long the server takes to start the game.
+					avatarConnectAll(sessions, avatarNum, capture);
+					struct timespec connected;
+					timespec_get(&connected, TIME_UTC);
+					bool started = avatarAwaitFirstTurn(sessions, avatarNum);
+					struct timespec firstTurn;
+					timespec_get(&firstTurn, TIME_UTC);
+					double connectMs = (connected.tv_sec - start.tv_sec) * 1e3 + (connected.tv_nsec - start.tv_nsec) / 1e6;
+					double firstTurnMs = (firstTurn.tv_sec - start.tv_sec) * 1e3 + (firstTurn.tv_nsec - start.tv_nsec) / 1e6;
+					loggerLine(logger, "Connected %d avatars in %.3f ms, first turn after %.3f ms%s\n", avatarNum,
+							connectMs, firstTurnMs, started ? "" : " (timed out)");
+					fflush(fp);
+
+					for (avatarIdx = 0; avatarIdx < avatarNum && !eventLoop; avatarIdx++) {
 						// Create the thread and perform safety check.
-						threadChecker = pthread_create(&threads[avatarIdx], NULL, runAvatar, (void *)initStruct);
+						threadChecker = pthread_create(&threads[avatarIdx], NULL, runAvatar, (void *)sessions[avatarIdx]);
 						if (threadChecker) {
 							fprintf(stderr, "Error when creating thread for avatar number %d\n", avatarIdx);
 							free(logName);
@@ -229,9 +434,75 @@ int main(const int argc, char *argv[]) {
 						}
 					}
 
-					// Clean up threads in memory.
-					for (int i = 0; i < avatarNum; i++) {
-						pthread_join(threads[i], NULL);
+					bool timedOut = false;	  // the server went quiet before the game ended
+					if (eventLoop) {
+						// Play every avatar from this thread.
+						int status = runEventLoop(sessions, avatarNum);
+						if (status < 0 && errno == ETIMEDOUT) {
+							timedOut = true;
+						}
+						else if (status != 0) {
+							free(logName);
+							exit(15);
+						}
+					}
+					else {
+						// Clean up threads in memory.
+						for (int i = 0; i < avatarNum; i++) {
+							void *status;
+							pthread_join(threads[i], &status);
+							timedOut |= status == AVATAR_TIMED_OUT;
+						}
+					}
+					pthread_mutex_destroy(&lock);
+
+					// Write whatever the avatars logged last; the lines below go straight to the file.
+					loggerStop(logger);
+
+					// Draw the final state and give the terminal back, if no avatar has yet.
+					renderStop(renderer);
+
+					struct timespec end;
+					timespec_get(&end, TIME_UTC);
+					double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+					double cpuSeconds = (double)(clock() - startCPU) / CLOCKS_PER_SEC;
+					// Headless runs keep stdout to the summary line; the reports go to the log, through a text record in a trace.
+					char *traceText = NULL;
+					size_t traceTextLength = 0;
+					FILE *logText = trace ? open_memstream(&traceText, &traceTextLength) : fp;
+					if (logText == NULL) {
+						exit(12);
+					}
+					FILE *report = headless ? logText : stdout;
+					fprintf(report, "%s: %d moves in %.3f s wall, %.3f s CPU, %.1f us per move\n", eventLoop ? "Event loop" : "Threads",
+							moveCount, seconds, cpuSeconds, moveCount > 0 ? seconds * 1e6 / moveCount : 0.0);
+					fprintf(report, "Startup: %d avatars connected in %.3f ms, first turn after %.3f ms\n", avatarNum, connectMs, firstTurnMs);
+					if (renderer != NULL) {
+						renderReport(renderer, report);
+						renderDelete(renderer);
+					}
+					loggerReport(logger, report);
+					if (!headless) {
+						latencyReport(latency, stdout, false);
+					}
+					latencyReport(latency, logText, true);
+					latencyDelete(latency);
+					if (trace) {
+						fclose(logText);
+						loggerLine(logger, "%s", traceText);
+						free(traceText);
+					}
+					loggerDelete(logger);
+
+					if (headless) {
+						// One line of key=value pairs for scripts.
+						uint32_t endType = ntohl(ending.type);
+						const char *result = endType == AM_MAZE_SOLVED ? "solved" : endType == AM_TOO_MANY_MOVES ? "too_many_moves"
+								: endType == AM_SERVER_TIMEOUT ? "server_timeout" : timedOut ? "timed_out" : "disconnected";
+						printf("result=%s avatars=%d difficulty=%d moves=%d hash=%u engine=%s strategy=%s wall_s=%.6f cpu_s=%.6f us_per_move=%.3f connect_ms=%.3f first_turn_ms=%.3f\n",
+								result, avatarNum, difficulty, moveCount, endType == AM_MAZE_SOLVED ? ntohl(ending.maze_solved.Hash) : 0,
+								eventLoop ? "eventloop" : "threads", strategyName, seconds, cpuSeconds,
+								moveCount > 0 ? seconds * 1e6 / moveCount : 0.0, connectMs, firstTurnMs);
 					}
 
 					// Close log file.
@@ -245,7 +516,8 @@ int main(const int argc, char *argv[]) {
 
 				// Clean up with respect to memory.
 				deleteAvatars(avatars, avatarNum);
-				mazeDelete(h, w, mazeArray);
+				rendezvousDelete(rendezvous);
+				mazeDelete(mazeArray);
 				free(logName);
 			} else {
 				// Handle unexpected message.
@@ -255,8 +527,15 @@ int main(const int argc, char *argv[]) {
 	}
 	
 	// Close and exit, return 0.
-	close(comm_sock);
-	printf("Exiting AMStartup\n");
+	connDelete(conn);
+	freeaddrinfo(addresses);
+	if (capture != NULL) {
+		captureDelete(capture);
+		fclose(captureFile);
+	}
+	if (!headless) {
+		printf("Exiting AMStartup\n");
+	}
 	pthread_exit(NULL);
 	return 0;
 }
@@ -0,0 +1,137 @@
+/*
+ * amreplay
+ *
+ * Plays a game recorded by AMStartup -c back through a strategy, with no server and no network
+ * (see replay.h), and reports how fast the strategy decided and whether every avatar made the
+ * move it made when the game was recorded. Give -s the strategy the game was recorded with (the
+ * default is the same as AMStartup's) to check a change to it, or another one to compare them.
+ *
+ * Usage: ./amreplay [-s strategy] capture
+ *
+ * Example: ./AMStartup -h localhost -d 3 -n 4 -q -e -c game.cap && ./amreplay game.cap
+ *
+ * Exits with 0 if every move matched and 5 if any differed.
+ *
+ * Connor Davis, Sean Simons, Luca Lit, and Mack Reiferson, Winter 2020.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L   // getopt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>	      // getopt
+#include <netdb.h>	      // ntohl
+#include <pthread.h>
+#include "amazing.h"
+#include "avatar.h"
+#include "mazeSolver.h"
+#include "rendezvous.h"
+#include "strategy.h"
+#include "latency.h"
+#include "capture.h"
+#include "replay.h"
+
+/**************** file-local constants ****************/
+
+// how the meeting point of the bfs and incremental strategies is chosen, as in AMStartup
+#ifndef RENDEZVOUS
+#define RENDEZVOUS RENDEZVOUS_MINMAX
+#endif
+
+/**************** main() ****************/
+int main(int argc, char *argv[]) {
+	char *strategyName = DEFAULT_STRATEGY;	  // how avatars choose their moves
+	int opt;
+	while ((opt = getopt(argc, argv, "s:")) != -1) {
+		switch (opt) {
+			case 's':
+				strategyName = optarg;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-s strategy] capture\n", argv[0]);
+				exit(1);
+		}
+	}
+	if (argc - optind != 1) {
+		fprintf(stderr, "usage: %s [-s strategy] capture\n", argv[0]);
+		exit(1);
+	}
+	const strategy_t *strategy = findStrategy(strategyName);
+	if (strategy == NULL) {
+		fprintf(stderr, "Error, unknown strategy '%s', choose one of:\n", strategyName);
+		printStrategies(stderr);
+		exit(1);
+	}
+
+	FILE *fp = fopen(argv[optind], "r");
+	if (fp == NULL) {
+		fprintf(stderr, "Error when opening capture %s\n", argv[optind]);
+		exit(2);
+	}
+	capture_t *capture = captureOpen(fp);
+	AM_Message initOk;
+	int avatarNum, difficulty;
+	if (capture == NULL || !replayGame(capture, &initOk, &avatarNum, &difficulty)) {
+		fprintf(stderr, "Error, %s is not a capture of a game\n", argv[optind]);
+		exit(3);
+	}
+	int height = ntohl(initOk.init_ok.MazeHeight);
+	int width = ntohl(initOk.init_ok.MazeWidth);
+
+	// The same game state AMStartup builds, with nothing drawn, logged or connected.
+	maze_t *maze = createMaze(height, width);
+	rendezvous_t *rendezvous = rendezvousNew(maze, RENDEZVOUS);
+	avatar_t **avatars = createAvatars(avatarNum);
+	latency_t *latency = latencyNew(avatarNum);
+	if (maze == NULL || rendezvous == NULL || latency == NULL) {
+		exit(4);
+	}
+	pthread_mutex_t lock;
+	pthread_mutex_init(&lock, NULL);
+	int lastTurnID = -1;
+	int solved = 0;
+	int moveCount = 0;
+	AM_Message ending;
+	memset(&ending, 0, sizeof(ending));
+
+	// The capture stands in for the server, so it is named where the host would be.
+	avatarSession_t *sessions[AM_MAX_AVATAR];
+	for (int k = 0; k < avatarNum; k++) {
+		startupInfo_t *initStruct = loadStartupStruct(&lock, k, avatarNum, difficulty, argv[optind], NULL,
+				ntohl(initOk.init_ok.MazePort), NULL, avatars, &lastTurnID, maze, rendezvous, strategy, &solved,
+				height, width, NULL, NULL, &moveCount, latency, NULL, &ending);
+		sessions[k] = avatarSessionNew(initStruct);
+	}
+	avatarConnectOffline(sessions, avatarNum);
+
+	replayResult_t result;
+	long long start = latencyNow();
+	runReplay(capture, sessions, avatarNum, &result);
+	long long nanos = latencyNow() - start;
+
+	printf("%s: %d avatars, difficulty %d, %dx%d maze, strategy %s\n", argv[optind], avatarNum, difficulty, width,
+			height, strategyName);
+	printf("Replayed %ld records, %ld messages, %d moves in %.3f ms (captured game took %.3f ms, %.1fx)\n",
+			captureCount(capture), result.messages, moveCount, nanos / 1e6, result.capturedNanos / 1e6,
+			nanos > 0 ? (double)result.capturedNanos / nanos : 0.0);
+	latencyReport(latency, stdout, false);
+	if (result.differences == 0) {
+		printf("All %ld recorded moves matched\n", result.moves);
+	} else {
+		printf("%ld of %ld recorded moves differed; first: avatar %d, move %d, recorded %s, replayed %s\n",
+				result.differences, result.moves, result.firstAvatar, result.firstMove,
+				parseDirection(result.recordedDirection),
+				result.replayedDirection < 0 ? "no move" : parseDirection(result.replayedDirection));
+	}
+
+	pthread_mutex_destroy(&lock);
+	latencyDelete(latency);
+	deleteAvatars(avatars, avatarNum);
+	rendezvousDelete(rendezvous);
+	mazeDelete(maze);
+	captureDelete(capture);
+	fclose(fp);
+	return result.differences == 0 ? 0 : 5;
+}
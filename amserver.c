@@ -0,0 +1,535 @@
+/*
+ * amserver
+ *
+ * A local maze server speaking the protocol in amazing.h, so AMStartup can be run, tested and
+ * timed over loopback without the course server. Every AM_INIT gets its own process, its own
+ * seeded maze and its own MazePort; the game is then played out in a poll loop over the avatar
+ * sockets.
+ *
+ * Usage: ./amserver [-p port] [-s seed] [-W width -H height] [-m maxMoves] [-l loops] [-f]
+ *
+ * Example: ./amserver -p 17235 -s 7 -m 100000 -f
+ *
+ * With -l every maze has that percent of its inner walls knocked down after carving, so it has
+ * loops, as the course server's mazes do; by default mazes are perfect.
+ *
+ * With -f every message is sent in random pieces of 1 to 32 bytes, to check that clients
+ * reassemble messages split across reads.
+ *
+ * Connor Davis, Sean Simons, Luca Lit, and Mack Reiferson, Winter 2020.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r, getopt, MSG_NOSIGNAL
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>	      // memset
+#include <unistd.h>	      // read, write, close, fork, getopt
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <netdb.h>	      // socket-related structures
+#include <netinet/in.h>
+#include <netinet/tcp.h>     // TCP_NODELAY
+#include <sys/socket.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+#include "mazegen.h"
+#include "conn.h"
+
+/**************** file-local constants ****************/
+#define BACKLOG 32                              // pending connections per listening socket
+#define MAX_CONNECTIONS (2 * AM_MAX_AVATAR)     // maze port sockets, counting ones that never get ready
+
+/**************** file-local types ****************/
+
+/*
+ * Command line settings shared by every game. A width or height of 0 means the size follows
+ * the difficulty, see mazegenSize().
+ */
+typedef struct options {
+	int port;
+	unsigned int seed;
+	int width;
+	int height;
+	int maxMoves;
+	int loops;                // percent of inner walls knocked down
+	bool fragment;
+} options_t;
+
+/*
+ * One game: the true maze, where each avatar stands and whose turn it is.
+ */
+typedef struct game {
+	int nAvatars;
+	int difficulty;
+	int width;
+	int height;
+	uint8_t *open;            // WALL_* bits of the open edges of every tile
+	int maxMoves;
+	unsigned int seed;
+	int x[AM_MAX_AVATAR];
+	int y[AM_MAX_AVATAR];
+	int turn;
+	int moves;
+	int ready;
+} game_t;
+
+/*
+ * A socket on the MazePort and the part of a message read from it so far.
+ */
+typedef struct connection {
+	conn_t *conn;             // NULL once closed
+	int avatarID;             // -1 until it sends a valid AM_AVATAR_READY
+} connection_t;
+
+// set in a game's process when messages are to be sent in pieces
+static bool fragment = false;
+static unsigned int fragmentSeed = 0;
+
+/**************** file-local functions ****************/
+
+/*
+ *	Writes a whole message, in random pieces under -f, returning false if the peer is gone
+ */
+static bool sendMessage(conn_t *conn, AM_Message *message) {
+	if (!fragment) {
+		return connSend(conn, message);
+	}
+	char *bytes = (char *)message;
+	size_t sent = 0;
+	while (sent < sizeof(AM_Message)) {
+		size_t piece = 1 + rand_r(&fragmentSeed) % 32;
+		piece = piece < sizeof(AM_Message) - sent ? piece : sizeof(AM_Message) - sent;
+		ssize_t n = send(connFd(conn), bytes + sent, piece, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		sent += n;
+	}
+	return true;
+}
+
+/*
+ *	Sends an error message; BadType is only read for AM_UNKNOWN_MSG_TYPE
+ */
+static void sendError(conn_t *conn, uint32_t type, uint32_t badType) {
+	AM_Message message;
+	memset(&message, 0, sizeof(message));
+	message.type = htonl(type);
+	message.unknown_msg_type.BadType = htonl(badType);
+	sendMessage(conn, &message);
+}
+
+/*
+ *	Opens a listening TCP socket on every interface; port 0 lets the kernel choose
+ */
+static int listenOn(int port) {
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) {
+		perror("opening socket");
+		return -1;
+	}
+	int yes = 1;
+	setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+	struct sockaddr_in server;
+	memset(&server, 0, sizeof(server));
+	server.sin_family = AF_INET;
+	server.sin_addr.s_addr = htonl(INADDR_ANY);
+	server.sin_port = htons(port);
+	if (bind(fd, (struct sockaddr *) &server, sizeof(server)) < 0) {
+		perror("binding socket");
+		close(fd);
+		return -1;
+	}
+	if (listen(fd, BACKLOG) < 0) {
+		perror("listening on socket");
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+/*
+ *	Sends a message to every avatar that has announced itself
+ */
+static void broadcast(connection_t *connections, int numConnections, AM_Message *message) {
+	for (int i = 0; i < numConnections; i++) {
+		if (connections[i].avatarID >= 0 && connections[i].conn != NULL) {
+			sendMessage(connections[i].conn, message);
+		}
+	}
+}
+
+/*
+ *	Tells every avatar whose turn it is and where everyone stands
+ */
+static void sendTurn(game_t *game, connection_t *connections, int numConnections) {
+	AM_Message message;
+	memset(&message, 0, sizeof(message));
+	message.type = htonl(AM_AVATAR_TURN);
+	message.avatar_turn.TurnId = htonl(game->turn);
+	for (int k = 0; k < game->nAvatars; k++) {
+		message.avatar_turn.Pos[k].x = htonl(game->x[k]);
+		message.avatar_turn.Pos[k].y = htonl(game->y[k]);
+	}
+	broadcast(connections, numConnections, &message);
+}
+
+/*
+ *	Carries out the move of the avatar holding the turn; returns false once the game is over
+ */
+static bool playMove(game_t *game, connection_t *connections, int numConnections, int direction) {
+	int avatar = game->turn;
+	int tile = game->y[avatar] * game->width + game->x[avatar];
+	game->moves++;
+	if (direction >= 0 && direction < M_NUM_DIRECTIONS && (game->open[tile] & (1 << direction))) {
+		game->x[avatar] += deltaX[direction];
+		game->y[avatar] += deltaY[direction];
+	}
+
+	// solved once everyone stands on the same tile
+	bool together = true;
+	for (int k = 1; k < game->nAvatars; k++) {
+		together = together && game->x[k] == game->x[0] && game->y[k] == game->y[0];
+	}
+	if (together) {
+		AM_Message message;
+		memset(&message, 0, sizeof(message));
+		message.type = htonl(AM_MAZE_SOLVED);
+		message.maze_solved.nAvatars = htonl(game->nAvatars);
+		message.maze_solved.Difficulty = htonl(game->difficulty);
+		message.maze_solved.nMoves = htonl(game->moves);
+		message.maze_solved.Hash = htonl(mazegenHash(game->seed, game->width, game->height, game->nAvatars, game->difficulty, game->moves));
+		broadcast(connections, numConnections, &message);
+		return false;
+	}
+	if (game->moves >= game->maxMoves) {
+		AM_Message message;
+		memset(&message, 0, sizeof(message));
+		message.type = htonl(AM_TOO_MANY_MOVES);
+		broadcast(connections, numConnections, &message);
+		return false;
+	}
+	game->turn = (game->turn + 1) % game->nAvatars;
+	sendTurn(game, connections, numConnections);
+	return true;
+}
+
+/*
+ *	Acts on one whole message from a MazePort socket; returns false once the game is over
+ */
+static bool handleMessage(game_t *game, connection_t *connections, int numConnections, connection_t *connection, AM_Message *message) {
+	uint32_t type = ntohl(message->type);
+
+	if (type == AM_AVATAR_READY) {
+		int id = ntohl(message->avatar_ready.AvatarId);
+		bool taken = false;
+		for (int i = 0; i < numConnections; i++) {
+			taken = taken || connections[i].avatarID == id;
+		}
+		if (connection->avatarID >= 0 || id < 0 || id >= game->nAvatars || taken) {
+			sendError(connection->conn, AM_NO_SUCH_AVATAR, 0);
+			return true;
+		}
+		connection->avatarID = id;
+		game->ready++;
+
+		// the first turn goes out once the last avatar is ready
+		if (game->ready == game->nAvatars) {
+			sendTurn(game, connections, numConnections);
+		}
+		return true;
+	}
+	if (type == AM_AVATAR_MOVE) {
+		int id = ntohl(message->avatar_move.AvatarId);
+		if (id < 0 || id >= game->nAvatars || id != connection->avatarID) {
+			sendError(connection->conn, AM_NO_SUCH_AVATAR, 0);
+			return true;
+		}
+		if (game->ready < game->nAvatars || id != game->turn) {
+			sendError(connection->conn, AM_AVATAR_OUT_OF_TURN, 0);
+			return true;
+		}
+		return playMove(game, connections, numConnections, ntohl(message->avatar_move.Direction));
+	}
+
+	// anything else is either a message only the server sends or not part of the protocol
+	switch (type) {
+		case AM_INIT:
+		case AM_INIT_OK:
+		case AM_INIT_FAILED:
+		case AM_AVATAR_TURN:
+		case AM_MAZE_SOLVED:
+			sendError(connection->conn, AM_UNEXPECTED_MSG_TYPE, type);
+			break;
+		default:
+			sendError(connection->conn, AM_UNKNOWN_MSG_TYPE, type);
+	}
+	return true;
+}
+
+/*
+ *	Plays one game on its MazePort until it is solved, runs out of moves, times out or an avatar leaves
+ */
+static void playGame(game_t *game, int listenFd) {
+	connection_t connections[MAX_CONNECTIONS];
+	struct pollfd fds[MAX_CONNECTIONS + 1];
+	int numConnections = 0;
+	bool playing = true;
+
+	while (playing) {
+		// only listen for new avatars until every avatar is ready
+		fds[0].fd = game->ready < game->nAvatars && numConnections < MAX_CONNECTIONS ? listenFd : -1;
+		fds[0].events = POLLIN;
+		for (int i = 0; i < numConnections; i++) {
+			fds[i + 1].fd = connFd(connections[i].conn);
+			fds[i + 1].events = POLLIN;
+		}
+
+		int ready = poll(fds, numConnections + 1, AM_WAIT_TIME * 1000);
+		if (ready < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ready < 0) {
+			perror("poll");
+			break;
+		}
+		if (ready == 0) {
+			AM_Message message;
+			memset(&message, 0, sizeof(message));
+			message.type = htonl(AM_SERVER_TIMEOUT);
+			broadcast(connections, numConnections, &message);
+			break;
+		}
+
+		// read every socket with data waiting, dropping closed ones afterwards
+		int polled = numConnections;
+		for (int i = 0; i < polled && playing; i++) {
+			if (!(fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))) {
+				continue;
+			}
+			int received = connFill(connections[i].conn, false);
+			if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK)) {
+				// an avatar that leaves ends the game for everyone
+				playing = connections[i].avatarID < 0;
+				connDelete(connections[i].conn);
+				connections[i].conn = NULL;
+				continue;
+			}
+
+			// every whole message that came in, in place
+			AM_Message *message;
+			while (playing && (message = connPeek(connections[i].conn)) != NULL) {
+				playing = handleMessage(game, connections, numConnections, &connections[i], message);
+				connConsume(connections[i].conn);
+			}
+		}
+		int kept = 0;
+		for (int i = 0; i < numConnections; i++) {
+			if (connections[i].conn != NULL) {
+				connections[kept++] = connections[i];
+			}
+		}
+		numConnections = kept;
+
+		if (playing && (fds[0].revents & POLLIN)) {
+			int fd = accept(listenFd, NULL, NULL);
+			if (fd >= 0) {
+				// turns are tiny and must not wait for the avatar to acknowledge the previous one
+				int yes = 1;
+				setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+				connections[numConnections].conn = connNew(fd);
+				connections[numConnections].avatarID = -1;
+				if (connections[numConnections].conn != NULL) {
+					numConnections++;
+				}
+			}
+		}
+	}
+
+	for (int i = 0; i < numConnections; i++) {
+		connDelete(connections[i].conn);
+	}
+}
+
+/*
+ *	Answers one AM_INIT connection and, if the game can start, plays it; runs in its own process
+ */
+static void serveGame(conn_t *init, options_t *options, unsigned int seed) {
+	fragment = options->fragment;
+	fragmentSeed = seed;
+	int yes = 1;
+	setsockopt(connFd(init), IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+	// read the whole AM_INIT
+	while (connPeek(init) == NULL) {
+		struct pollfd fd = { connFd(init), POLLIN, 0 };
+		if (poll(&fd, 1, AM_WAIT_TIME * 1000) <= 0 || connFill(init, false) <= 0) {
+			return;
+		}
+	}
+	AM_Message request = *connPeek(init);
+	connConsume(init);
+	uint32_t type = ntohl(request.type);
+	if (type != AM_INIT) {
+		sendError(init, type == AM_AVATAR_READY || type == AM_AVATAR_MOVE ? AM_UNEXPECTED_MSG_TYPE : AM_UNKNOWN_MSG_TYPE, type);
+		return;
+	}
+
+	// check the request
+	game_t game;
+	memset(&game, 0, sizeof(game));
+	game.nAvatars = ntohl(request.init.nAvatars);
+	game.difficulty = ntohl(request.init.Difficulty);
+	uint32_t errNum = 0;
+	if (game.nAvatars < 1 || game.nAvatars > AM_MAX_AVATAR) {
+		errNum = AM_INIT_TOO_MANY_AVATARS;
+	}
+	else if (game.difficulty < 0 || game.difficulty > AM_MAX_DIFFICULTY) {
+		errNum = AM_INIT_BAD_DIFFICULTY;
+	}
+	if (errNum != 0) {
+		AM_Message message;
+		memset(&message, 0, sizeof(message));
+		message.type = htonl(AM_INIT_FAILED);
+		message.init_failed.ErrNum = htonl(errNum);
+		sendMessage(init, &message);
+		return;
+	}
+
+	// build the maze and scatter the avatars over distinct tiles
+	mazegenSize(game.difficulty, &game.width, &game.height);
+	if (options->width > 0 && options->height > 0) {
+		game.width = options->width;
+		game.height = options->height;
+	}
+	game.seed = seed;
+	game.maxMoves = options->maxMoves;
+	game.open = mazegenCarve(game.width, game.height, seed);
+	if (game.open == NULL) {
+		sendError(init, AM_SERVER_OUT_OF_MEM, 0);
+		return;
+	}
+	mazegenLoops(game.open, game.width, game.height, options->loops, seed);
+	mazegenPlace(game.width, game.height, game.nAvatars, seed, game.x, game.y);
+
+	// open the MazePort before answering, so avatars can connect as soon as they read it
+	int listenFd = listenOn(0);
+	if (listenFd < 0) {
+		// no socket or port left for the MazePort, a resource failure like the one above
+		sendError(init, AM_SERVER_OUT_OF_MEM, 0);
+		free(game.open);
+		return;
+	}
+	struct sockaddr_in address;
+	socklen_t length = sizeof(address);
+	getsockname(listenFd, (struct sockaddr *) &address, &length);
+	int mazePort = ntohs(address.sin_port);
+
+	AM_Message message;
+	memset(&message, 0, sizeof(message));
+	message.type = htonl(AM_INIT_OK);
+	message.init_ok.MazePort = htonl(mazePort);
+	message.init_ok.MazeWidth = htonl(game.width);
+	message.init_ok.MazeHeight = htonl(game.height);
+	sendMessage(init, &message);
+	printf("Game on port %d: %d avatars, difficulty %d, %dx%d maze from seed %u\n", mazePort, game.nAvatars, game.difficulty, game.width, game.height, game.seed);
+	fflush(stdout);
+
+	playGame(&game, listenFd);
+	printf("Game on port %d ended after %d moves\n", mazePort, game.moves);
+	fflush(stdout);
+	close(listenFd);
+	free(game.open);
+}
+
+/**************** main() ****************/
+int main(const int argc, char *argv[]) {
+	options_t options = { atoi(AM_SERVER_PORT), 1, 0, 0, AM_MAX_MOVES, 0, false };
+
+	// Handle flag parsing.
+	int opt;
+	while ((opt = getopt(argc, argv, "p:s:W:H:m:l:f")) != -1) {
+		switch (opt) {
+			case 'p':
+				options.port = atoi(optarg);
+				break;
+			case 's':
+				options.seed = strtoul(optarg, NULL, 10);
+				break;
+			case 'W':
+				options.width = atoi(optarg);
+				break;
+			case 'H':
+				options.height = atoi(optarg);
+				break;
+			case 'm':
+				options.maxMoves = atoi(optarg);
+				break;
+			case 'l':
+				options.loops = atoi(optarg);
+				break;
+			case 'f':
+				options.fragment = true;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-p port] [-s seed] [-W width -H height] [-m maxMoves] [-l loops] [-f]\n", argv[0]);
+				exit(1);
+		}
+	}
+	if (optind != argc || options.port < 0 || options.port > 65535 || options.maxMoves < 1 || options.loops < 0 || options.loops > 100
+			|| options.width < 0 || options.height < 0 || (options.width > 0) != (options.height > 0)) {
+		fprintf(stderr, "usage: %s [-p port] [-s seed] [-W width -H height] [-m maxMoves] [-l loops] [-f]\n", argv[0]);
+		exit(1);
+	}
+
+	// Finished games are reaped automatically, and a vanished client must not kill the server.
+	signal(SIGCHLD, SIG_IGN);
+	signal(SIGPIPE, SIG_IGN);
+
+	int listenFd = listenOn(options.port);
+	if (listenFd < 0) {
+		exit(2);
+	}
+	printf("amserver listening on port %d with seed %u\n", options.port, options.seed);
+	fflush(stdout);
+
+	// Each game gets its own process and the next seed.
+	unsigned int gameNumber = 0;
+	while (true) {
+		int fd = accept(listenFd, NULL, NULL);
+		if (fd < 0) {
+			if (errno != EINTR) {
+				perror("accepting connection");
+			}
+			continue;
+		}
+		conn_t *init = connNew(fd);
+		if (init == NULL) {
+			close(fd);
+			continue;
+		}
+		pid_t pid = fork();
+		if (pid == 0) {
+			close(listenFd);
+			serveGame(init, &options, options.seed + gameNumber);
+			connDelete(init);
+			exit(0);
+		}
+		if (pid < 0) {
+			perror("forking game");
+			sendError(init, AM_SERVER_OUT_OF_MEM, 0);
+		}
+		connDelete(init);
+		gameNumber++;
+	}
+	return 0;
+}
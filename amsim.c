@@ -0,0 +1,113 @@
+/*
+ * amsim
+ *
+ * Plays games in process with the simulator (see sim.h): no server, no sockets, no window and
+ * no log, so a strategy's moves are all that is timed. Game g is carved from seed + g, as the
+ * g-th game amserver -s seed serves, and ends the same way; -l knocks down that percent of the
+ * inner walls, as amserver -l does, so the mazes have loops.
+ *
+ * Usage: ./amsim [-s strategy] [-n avatars] [-d difficulty] [-g games] [-S seed] [-l loops] [-m maxMoves] [-v]
+ *
+ * Example: ./amsim -s lefthand -n 4 -d 5 -g 1000
+ *
+ * With -v every game gets a line like AMStartup's -q summary; the last line always gives the
+ * games solved, the moves made and the moves simulated per second.
+ *
+ * Connor Davis, Sean Simons, Luca Lit, and Mack Reiferson, Winter 2020.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L   // getopt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>	      // getopt
+#include "amazing.h"
+#include "strategy.h"
+#include "latency.h"
+#include "sim.h"
+
+/**************** main() ****************/
+int main(int argc, char *argv[]) {
+	char *strategyName = DEFAULT_STRATEGY;	  // how avatars choose their moves
+	int avatarNum = 3;
+	int difficulty = 3;
+	int games = 1;
+	unsigned int seed = 1;	  // amserver's default
+	int loops = 0;	  // perfect mazes
+	int maxMoves = AM_MAX_MOVES;
+	bool verbose = false;
+	int opt;
+	while ((opt = getopt(argc, argv, "s:n:d:g:S:l:m:v")) != -1) {
+		switch (opt) {
+			case 's':
+				strategyName = optarg;
+				break;
+			case 'n':
+				avatarNum = atoi(optarg);
+				break;
+			case 'd':
+				difficulty = atoi(optarg);
+				break;
+			case 'g':
+				games = atoi(optarg);
+				break;
+			case 'S':
+				seed = strtoul(optarg, NULL, 10);
+				break;
+			case 'l':
+				loops = atoi(optarg);
+				break;
+			case 'm':
+				maxMoves = atoi(optarg);
+				break;
+			case 'v':
+				verbose = true;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-s strategy] [-n avatars] [-d difficulty] [-g games] [-S seed] [-l loops] [-m maxMoves] [-v]\n", argv[0]);
+				exit(1);
+		}
+	}
+	if (optind != argc || games < 1 || maxMoves < 1 || loops < 0 || loops > 100) {
+		fprintf(stderr, "usage: %s [-s strategy] [-n avatars] [-d difficulty] [-g games] [-S seed] [-l loops] [-m maxMoves] [-v]\n", argv[0]);
+		exit(1);
+	}
+	if (difficulty < 0 || difficulty > AM_MAX_DIFFICULTY) {
+		fprintf(stderr, "Error, difficulty must be between 0 and %d\n", AM_MAX_DIFFICULTY);
+		exit(2);
+	}
+	if (avatarNum < 1 || avatarNum > AM_MAX_AVATAR) {
+		fprintf(stderr, "Error, number of avatars must be between 1 and %d\n", AM_MAX_AVATAR);
+		exit(3);
+	}
+	const strategy_t *strategy = findStrategy(strategyName);
+	if (strategy == NULL) {
+		fprintf(stderr, "Error, unknown strategy '%s', choose one of:\n", strategyName);
+		printStrategies(stderr);
+		exit(14);
+	}
+
+	long long totalMoves = 0;
+	int solved = 0;
+	long long start = latencyNow();
+	for (int g = 0; g < games; g++) {
+		simResult_t result;
+		if (!simPlay(strategy, avatarNum, difficulty, seed + g, loops, maxMoves, &result)) {
+			fprintf(stderr, "Error, could not set up game %d\n", g);
+			exit(13);
+		}
+		totalMoves += result.moves;
+		solved += result.solved;
+		if (verbose) {
+			printf("result=%s avatars=%d difficulty=%d moves=%d hash=%u seed=%u strategy=%s\n",
+					result.solved ? "solved" : "too_many_moves", avatarNum, difficulty, result.moves, result.hash,
+					seed + g, strategyName);
+		}
+	}
+	double seconds = (latencyNow() - start) / 1e9;
+	printf("%s: %d of %d games solved, %lld moves in %.3f s, %.0f moves per second\n", strategyName,
+			solved, games, totalMoves, seconds, seconds > 0 ? totalMoves / seconds : 0.0);
+	return 0;
+}
@@ -0,0 +1,258 @@
+/*
+ * amtournament
+ *
+ * Plays strategies against each other over many seeded mazes with the simulator (see sim.h), for
+ * every pair of difficulty and number of avatars asked for, on all cores through a work-stealing
+ * pool (see pool.h). For each pair and strategy it prints the mean and 95th percentile of the
+ * moves a game took and the share of games that needed more than the server's move limit, then
+ * names the strategy that fails least, and takes the fewest moves on average among those, as
+ * the default for the pair.
+ *
+ * Usage: ./amtournament [-s strategy,...] [-d difficulties] [-n avatars] [-g games] [-S seed] [-l loops] [-m limit] [-c cap] [-j workers]
+ *
+ * Example: ./amtournament -s lefthand,bfs -d 0-3 -n 2-4 -g 2000
+ *
+ * Difficulties and avatars are a number or a range like 0-3. Every strategy plays the same games:
+ * game g of a difficulty is carved from seed + g, as the g-th game amserver -s seed serves. A game
+ * is played on to the cap (default 3 times the limit), so moves past the limit are still counted;
+ * a game not solved by then counts as the cap. -l sets the percent of each maze's inner walls that
+ * is knocked down (default 10), so the mazes have loops; with -l 0 they are perfect, and lefthand
+ * and tremaux play every game alike.
+ *
+ * Connor Davis, Sean Simons, Luca Lit, and Mack Reiferson, Winter 2020.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L   // getopt, strtok_r, sysconf
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <stdatomic.h>    // a game that could not be set up, flagged from any worker
+#include <unistd.h>	      // getopt, sysconf
+#include "amazing.h"
+#include "strategy.h"
+#include "sim.h"
+#include "pool.h"
+
+/**************** file-local constants ****************/
+#define MAX_STRATEGIES 16
+#define USAGE "usage: %s [-s strategy,...] [-d difficulties] [-n avatars] [-g games] [-S seed] [-l loops] [-m limit] [-c cap] [-j workers]\n"
+
+/**************** file-local types ****************/
+
+/*
+ * Everything the games need, and where each game's moves go: one slot per game and strategy,
+ * written by whichever worker plays it, so the workers share nothing they write.
+ */
+typedef struct tournament {
+	const strategy_t *strategies[MAX_STRATEGIES];
+	int numStrategies;
+	int minDifficulty, maxDifficulty;
+	int minAvatars, maxAvatars;
+	int games;                // per pair
+	unsigned int seed;
+	int loops;                // percent of inner walls knocked down, as amserver -l
+	int cap;
+	int *moves;               // [pair][game][strategy], the cap for a game never solved
+	_Atomic bool failed;      // a game could not be set up
+} tournament_t;
+
+/**************** file-local functions ****************/
+
+// reads "a" or "a-b" into a range, returning false if it is neither
+static bool parseRange(const char *text, int *low, int *high) {
+	char *end;
+	*low = strtol(text, &end, 10);
+	*high = *low;
+	if (*end == '-') {
+		*high = strtol(end + 1, &end, 10);
+	}
+	return end != text && *end == '\0' && *low <= *high;
+}
+
+static int compareInts(const void *a, const void *b) {
+	int x = *(const int *)a;
+	int y = *(const int *)b;
+	return (x > y) - (x < y);
+}
+
+/*
+ *	Plays one game with every strategy; the task number picks the pair and the game
+ */
+static void playGame(void *arg, long task, int worker) {
+	tournament_t *tournament = arg;
+	int avatarsPerDifficulty = tournament->maxAvatars - tournament->minAvatars + 1;
+	long pair = task / tournament->games;
+	int game = task % tournament->games;
+	int difficulty = tournament->minDifficulty + pair / avatarsPerDifficulty;
+	int avatars = tournament->minAvatars + pair % avatarsPerDifficulty;
+	for (int s = 0; s < tournament->numStrategies; s++) {
+		simResult_t result;
+		if (!simPlay(tournament->strategies[s], avatars, difficulty, tournament->seed + game, tournament->loops,
+				tournament->cap, &result)) {
+			atomic_store(&tournament->failed, true);
+		}
+		tournament->moves[task * tournament->numStrategies + s] = result.solved ? result.moves : tournament->cap;
+	}
+}
+
+/**************** main() ****************/
+int main(int argc, char *argv[]) {
+	tournament_t tournament;
+	memset(&tournament, 0, sizeof(tournament));
+	atomic_init(&tournament.failed, false);
+	char *strategyNames = NULL;	  // all of them
+	tournament.minDifficulty = 0;
+	tournament.maxDifficulty = 2;
+	tournament.minAvatars = 2;
+	tournament.maxAvatars = 4;
+	tournament.games = 1000;
+	tournament.seed = 1;	  // amserver's default
+	tournament.loops = 10;	  // the course server's mazes have loops; perfect ones make lefthand and tremaux alike
+	int limit = AM_MAX_MOVES;
+	int cap = -1;
+	long workers = sysconf(_SC_NPROCESSORS_ONLN);
+
+	int opt;
+	while ((opt = getopt(argc, argv, "s:d:n:g:S:l:m:c:j:")) != -1) {
+		switch (opt) {
+			case 's':
+				strategyNames = optarg;
+				break;
+			case 'd':
+				if (!parseRange(optarg, &tournament.minDifficulty, &tournament.maxDifficulty)
+						|| tournament.minDifficulty < 0 || tournament.maxDifficulty > AM_MAX_DIFFICULTY) {
+					fprintf(stderr, "Error, difficulties must be between 0 and %d\n", AM_MAX_DIFFICULTY);
+					exit(2);
+				}
+				break;
+			case 'n':
+				if (!parseRange(optarg, &tournament.minAvatars, &tournament.maxAvatars)
+						|| tournament.minAvatars < 1 || tournament.maxAvatars > AM_MAX_AVATAR) {
+					fprintf(stderr, "Error, number of avatars must be between 1 and %d\n", AM_MAX_AVATAR);
+					exit(3);
+				}
+				break;
+			case 'g':
+				tournament.games = atoi(optarg);
+				break;
+			case 'S':
+				tournament.seed = strtoul(optarg, NULL, 10);
+				break;
+			case 'l':
+				tournament.loops = atoi(optarg);
+				break;
+			case 'm':
+				limit = atoi(optarg);
+				break;
+			case 'c':
+				cap = atoi(optarg);
+				break;
+			case 'j':
+				workers = atol(optarg);
+				break;
+			default:
+				fprintf(stderr, USAGE, argv[0]);
+				exit(1);
+		}
+	}
+	if (cap < 0) {
+		cap = 3 * limit;
+	}
+	tournament.cap = cap;
+	if (optind != argc || tournament.games < 1 || limit < 1 || cap < limit || tournament.loops < 0 || tournament.loops > 100) {
+		fprintf(stderr, USAGE, argv[0]);
+		exit(1);
+	}
+	if (workers < 1 || workers > POOL_MAX_WORKERS) {
+		workers = workers < 1 ? 1 : POOL_MAX_WORKERS;
+	}
+
+	// the strategies named, or every registered one
+	if (strategyNames == NULL) {
+		for (const strategy_t *strategy; tournament.numStrategies < MAX_STRATEGIES
+				&& (strategy = strategyAt(tournament.numStrategies)) != NULL; ) {
+			tournament.strategies[tournament.numStrategies++] = strategy;
+		}
+	} else {
+		char *save;
+		for (char *name = strtok_r(strategyNames, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save)) {
+			const strategy_t *strategy = findStrategy(name);
+			if (strategy == NULL || tournament.numStrategies == MAX_STRATEGIES) {
+				fprintf(stderr, "Error, unknown strategy '%s', choose one of:\n", name);
+				printStrategies(stderr);
+				exit(14);
+			}
+			tournament.strategies[tournament.numStrategies++] = strategy;
+		}
+	}
+
+	int pairs = (tournament.maxDifficulty - tournament.minDifficulty + 1) * (tournament.maxAvatars - tournament.minAvatars + 1);
+	long tasks = (long)pairs * tournament.games;
+	tournament.moves = malloc(tasks * tournament.numStrategies * sizeof(int));
+	int *sorted = malloc(tournament.games * sizeof(int));
+	if (tournament.moves == NULL || sorted == NULL) {
+		fprintf(stderr, "Failed to malloc for tournament results\n");
+		exit(13);
+	}
+
+	printf("Tournament: %d strategies, difficulties %d-%d, %d-%d avatars, %d games each from seed %u, %d%% loops, limit %d moves, cap %d, %ld workers\n",
+			tournament.numStrategies, tournament.minDifficulty, tournament.maxDifficulty, tournament.minAvatars,
+			tournament.maxAvatars, tournament.games, tournament.seed, tournament.loops, limit, cap, workers);
+	if (tournament.loops == 0) {
+		printf("Perfect mazes: lefthand and tremaux play every game alike, so their rows cannot tell them apart\n");
+	}
+	fflush(stdout);
+	poolStats_t stats;
+	if (!poolRun(workers, tasks, playGame, &tournament, &stats)) {
+		exit(11);
+	}
+	if (atomic_load(&tournament.failed)) {
+		fprintf(stderr, "Error, a game could not be set up\n");
+		exit(13);
+	}
+
+	// one row per pair and strategy, then the pair's default
+	printf("%10s %7s %-12s %7s %10s %8s %7s\n", "difficulty", "avatars", "strategy", "games", "mean", "p95", "failed");
+	for (int pair = 0; pair < pairs; pair++) {
+		int avatarsPerDifficulty = tournament.maxAvatars - tournament.minAvatars + 1;
+		int difficulty = tournament.minDifficulty + pair / avatarsPerDifficulty;
+		int avatars = tournament.minAvatars + pair % avatarsPerDifficulty;
+		int best = -1;
+		double bestMean = 0, bestFailed = 0;
+		int bestP95 = 0;
+		for (int s = 0; s < tournament.numStrategies; s++) {
+			double total = 0;
+			int failed = 0;
+			for (int game = 0; game < tournament.games; game++) {
+				int moves = tournament.moves[((long)pair * tournament.games + game) * tournament.numStrategies + s];
+				sorted[game] = moves;
+				total += moves;
+				failed += moves > limit;
+			}
+			qsort(sorted, tournament.games, sizeof(int), compareInts);
+			double mean = total / tournament.games;
+			int p95 = sorted[(int)(0.95 * (tournament.games - 1) + 0.5)];
+			double failRate = (double)failed / tournament.games;
+			printf("%10d %7d %-12s %7d %10.1f %8d %6.1f%%\n", difficulty, avatars, tournament.strategies[s]->name,
+					tournament.games, mean, p95, 100 * failRate);
+			if (best < 0 || failRate < bestFailed || (failRate == bestFailed && mean < bestMean)) {
+				best = s;
+				bestMean = mean;
+				bestP95 = p95;
+				bestFailed = failRate;
+			}
+		}
+		printf("default difficulty=%d avatars=%d strategy=%s mean=%.1f p95=%d failed=%.4f\n", difficulty, avatars,
+				tournament.strategies[best]->name, bestMean, bestP95, bestFailed);
+	}
+	printf("Pool: %d workers, %ld games, %ld steals, %.3f s wall, %.3f s in games, %.1f workers busy on average\n", stats.workers,
+			stats.tasks * tournament.numStrategies, stats.steals, stats.wallNanos / 1e9, stats.busyNanos / 1e9,
+			stats.wallNanos > 0 ? (double)stats.busyNanos / stats.wallNanos : 0.0);
+
+	free(sorted);
+	free(tournament.moves);
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * amtrace
+ *
+ * Turns binary traces written by AMStartup -t back into text logs, line for line what AMStartup
+ * would have written without -t. Each trace Amazing_<user>_<n>_<d>.trace becomes the text log
+ * Amazing_<user>_<n>_<d> next to it, or the file given with -o when there is one trace.
+ *
+ * Usage: ./amtrace [-o output] trace...
+ *
+ * Example: ./amtrace log.out/Amazing_*.trace
+ *
+ * Connor Davis, Sean Simons, Luca Lit, and Mack Reiferson, Winter 2020.
+ *
+ */
+
+#define _POSIX_C_SOURCE 200809L   // getopt
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>	      // getopt
+#include "logger.h"
+
+/**************** file-local constants ****************/
+#define SUFFIX ".trace"
+
+/**************** file-local functions ****************/
+
+// the text log's name: the trace's without SUFFIX, or with ".txt" added if it has none
+static char *textName(const char *traceName) {
+	size_t length = strlen(traceName);
+	size_t suffix = strlen(SUFFIX);
+	char *name = malloc(length + 5);
+	if (name == NULL) {
+		return NULL;
+	}
+	strcpy(name, traceName);
+	if (length > suffix && strcmp(traceName + length - suffix, SUFFIX) == 0) {
+		name[length - suffix] = '\0';
+	} else {
+		strcat(name, ".txt");
+	}
+	return name;
+}
+
+/**************** main() ****************/
+int main(int argc, char *argv[]) {
+	char *output = NULL;      // name of the text log, for a single trace
+	int opt;
+	while ((opt = getopt(argc, argv, "o:")) != -1) {
+		switch (opt) {
+			case 'o':
+				output = optarg;
+				break;
+			default:
+				fprintf(stderr, "usage: %s [-o output] trace...\n", argv[0]);
+				exit(1);
+		}
+	}
+	if (optind >= argc || (output != NULL && argc - optind != 1)) {
+		fprintf(stderr, "usage: %s [-o output] trace...\n", argv[0]);
+		exit(1);
+	}
+
+	for (int i = optind; i < argc; i++) {
+		FILE *trace = fopen(argv[i], "r");
+		if (trace == NULL) {
+			fprintf(stderr, "Error when opening trace %s\n", argv[i]);
+			exit(2);
+		}
+		char *name = output != NULL ? output : textName(argv[i]);
+		FILE *text = name != NULL ? fopen(name, "w") : NULL;
+		if (text == NULL) {
+			fprintf(stderr, "Error when creating log %s\n", name != NULL ? name : argv[i]);
+			exit(3);
+		}
+
+		traceHeader_t header;
+		long records = loggerConvert(trace, text, &header);
+		long traceBytes = ftell(trace);
+		long textBytes = ftell(text);
+		fclose(trace);
+		fclose(text);
+		if (records < 0) {
+			fprintf(stderr, "Error, %s is not a whole trace\n", argv[i]);
+			exit(4);
+		}
+		printf("%s: %s, %d avatars, difficulty %d, %dx%d maze, %ld records, %ld bytes -> %s, %ld bytes (%.1fx)\n",
+				argv[i], header.user, header.nAvatars, header.difficulty, header.width, header.height, records,
+				traceBytes, name, textBytes, traceBytes > 0 ? (double)textBytes / traceBytes : 0.0);
+		if (name != output) {
+			free(name);
+		}
+	}
+	return 0;
+}
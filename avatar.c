@@ -6,10 +6,15 @@
  */
 
 
+#define _POSIX_C_SOURCE 200809L   // getaddrinfo results
+
 #include <stdio.h>
 #include <stdlib.h>	
 #include <stdbool.h>		
 #include <unistd.h>	      // read, write, close
+#include <errno.h>
+#include <fcntl.h>	      // non-blocking connect
+#include <poll.h>
 #include <string.h>	      // memcpy, memset
 #include <netdb.h>		  // socket-related structures
 #include <pthread.h>	  // threading library
@@ -18,6 +23,14 @@
 #include "avatar.h"		  // avatar header file for module use
 #include "mazeSolver.h"	  // maze representation/move logic functions
 #include "graphics.h"	  // ASCII graphics/maze rendering
+#include "planner.h"	  // shortest paths over the discovered maze
+#include "rendezvous.h"	  // shared meeting point of all avatars
+#include "strategy.h"	  // pluggable move strategies
+#include "conn.h"		  // message framing on the MazePort socket
+#include "latency.h"	  // timing of every phase of a turn
+#include "render.h"		  // snapshots for the render thread
+#include "logger.h"		  // log lines for the writer thread
+#include "capture.h"		  // recording of every message
 
 
 // ***************************** STRUCTS *********************************
@@ -30,6 +43,7 @@ typedef struct startupInfo {
 	int nAvatars;
 	int difficulty;
 	char *hostname;
+	const struct addrinfo *serverAddress;
 	int mazePort;
 	char *logFile;
 	int comm_sock;
@@ -37,13 +51,18 @@ typedef struct startupInfo {
 	pthread_mutex_t *lock2;
 	avatar_t **avatars;
 	int *lastTurnID;
-	mazeTile_t ***maze;
+	maze_t *maze;
+	rendezvous_t *rendezvous;
+	const strategy_t *strategy;
 	int *solved;
 	int height;
 	int width;
 	WINDOW *window;
-	FILE *log;
+	logger_t *log;
 	int *moveCount;
+	latency_t *latency;
+	renderer_t *renderer;
+	AM_Message *ending;
 } startupInfo_t;
 
 // ***********************************************************************
@@ -68,6 +87,9 @@ int getDiff(startupInfo_t* s) {
 char* getHostname(startupInfo_t* s) {
 	return s->hostname;
 }
+const struct addrinfo *getServerAddress(startupInfo_t* s) {
+	return s->serverAddress;
+}
 int getMazePort(startupInfo_t* s) {
 	return s->mazePort;
 }
@@ -86,9 +108,15 @@ avatar_t **getAvatars(startupInfo_t* s) {
 int *getLastTurnID(startupInfo_t* s) {
 	return s->lastTurnID;
 }
-mazeTile_t ***getMaze(startupInfo_t* s) {
+maze_t *getMaze(startupInfo_t* s) {
 	return s->maze;
 }
+rendezvous_t *getRendezvous(startupInfo_t* s) {
+	return s->rendezvous;
+}
+const strategy_t *getStrategy(startupInfo_t* s) {
+	return s->strategy;
+}
 int* getSolved(startupInfo_t *s) {
 	return s->solved;
 }
@@ -101,34 +129,49 @@ int getWidth(startupInfo_t *s) {
 WINDOW *getWindow(startupInfo_t *s) {
 	return s->window;
 }
-FILE* getLog(startupInfo_t *s) {
+logger_t *getLog(startupInfo_t *s) {
 	return s->log;
 }
 int* getMoveCount(startupInfo_t *s) {
 	return s->moveCount;
 }
+latency_t *getLatency(startupInfo_t *s) {
+	return s->latency;
+}
+renderer_t *getRenderer(startupInfo_t *s) {
+	return s->renderer;
+}
+AM_Message *getEnding(startupInfo_t *s) {
+	return s->ending;
+}
 
 /*
  *	Takes all attributes of a startupInfo_t as paramaters & creates an instance & assigns attributes
  */
-startupInfo_t* loadStartupStruct(pthread_mutex_t *lock, int avatarID, int nAvatars, int difficulty, char *hostname, int mazePort, char *logFile, avatar_t **avatars, int *lastTurnID, mazeTile_t ***maze, int *solved, int height, int width, WINDOW *window, FILE *log, int *moveCount) {
+startupInfo_t* loadStartupStruct(pthread_mutex_t *lock, int avatarID, int nAvatars, int difficulty, char *hostname, const struct addrinfo *serverAddress, int mazePort, char *logFile, avatar_t **avatars, int *lastTurnID, maze_t *maze, rendezvous_t *rendezvous, const strategy_t *strategy, int *solved, int height, int width, WINDOW *window, logger_t *log, int *moveCount, latency_t *latency, renderer_t *renderer, AM_Message *ending) {
 	// set values
 	startupInfo_t *startup = malloc(sizeof(startupInfo_t));
 	startup->avatarID = avatarID;
 	startup->nAvatars = nAvatars;
 	startup->difficulty = difficulty;
+	startup->serverAddress = serverAddress;
 	startup->mazePort = mazePort;
 	startup->logFile = logFile;
 	startup->lock = lock;
 	startup->avatars = avatars;
 	startup->lastTurnID = lastTurnID;
 	startup->maze = maze;
+	startup->rendezvous = rendezvous;
+	startup->strategy = strategy;
 	startup->solved = solved;
 	startup->height = height;
 	startup->width = width;
 	startup->window = window;
 	startup->log = log;
 	startup->moveCount = moveCount;
+	startup->latency = latency;
+	startup->renderer = renderer;
+	startup->ending = ending;
 
 	// Copy hostname
 	char* hostname_copy = malloc(strlen(hostname) + 1);
@@ -144,7 +187,6 @@ startupInfo_t* loadStartupStruct(pthread_mutex_t *lock, int avatarID, int nAvata
  */
 void deleteStartupStruct(startupInfo_t *s) {
 	free(s->hostname);
-	pthread_mutex_destroy(s->lock);
 	free(s);
 }
 
@@ -229,10 +271,38 @@ void setDirection(avatar_t *avatar, int direction) {
 // ************************** HELPER FUNCTIONS ***************************
 
 
+/*
+ *	Move made by the left hand rule, indexed by the direction the avatar faces (M_NULL_MOVE included)
+ *	and the 4-bit wall mask of its tile. Each facing tries its left, front, right and back in that order;
+ *	rows 4-7 are never faced and, like a tile walled in on all four sides, give a null move.
+ *	Columns run through masks 0-15, bit (1 << direction) set for each wall.
+ */
+#define W M_WEST
+#define N M_NORTH
+#define S M_SOUTH
+#define E M_EAST
+#define X M_NULL_MOVE
+static const int8_t leftHandTable[M_NULL_MOVE + 1][16] = {
+	{ S, S, S, S, W, N, W, E, S, S, S, S, W, N, W, X },   // facing west
+	{ W, N, W, E, W, N, W, E, W, N, W, S, W, N, W, X },   // facing north
+	{ E, E, E, E, E, E, E, E, S, S, S, S, W, N, W, X },   // facing south
+	{ N, N, E, E, N, N, E, E, N, N, S, S, N, N, W, X },   // facing east
+	{ X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X },   // unused
+	{ X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X },   // unused
+	{ X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X },   // unused
+	{ X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X },   // unused
+	{ X, X, X, X, X, X, X, X, X, X, X, X, X, X, X, X },   // null move
+};
+#undef W
+#undef N
+#undef S
+#undef E
+#undef X
+
 /*
  *	Returns the direction an avatar should move in based on its location & the existence of walls
  */
-int leftHandRule(avatar_t *currentAvatar, mazeTile_t *currentTile, int *lastTurn, int numAvatars, avatar_t **avatars) {
+int leftHandRule(avatar_t *currentAvatar, int walls, int *lastTurn, int numAvatars, avatar_t **avatars) {
 	(*lastTurn) = currentAvatar->avatarID;
 
 	// Last avatar should not move
@@ -246,125 +316,83 @@ int leftHandRule(avatar_t *currentAvatar, mazeTile_t *currentTile, int *lastTurn
 		return M_NULL_MOVE;
 	}
 
-	// if we are facing up
-	if (currentAvatar->direction == M_NORTH) {
-		// if there is not a wall to the left, go left
-		if (currentTile->westWall != true) {
-			currentAvatar->direction = M_WEST;
-			return M_WEST;
-		}
-		// if there is not a wall to the front, go forward
-		else if (currentTile->northWall != true) {
-			currentAvatar->direction = M_NORTH;
-			return M_NORTH;
-		}
-		// if there is not a wall to the right, go right
-		else if (currentTile->eastWall != true) {
-			currentAvatar->direction = M_EAST;
-			return M_EAST;
-		}
-		// if there is not a wall to the bottom, go backwards
-		else if (currentTile->southWall != true) {
-			currentAvatar->direction = M_SOUTH;
-			return M_SOUTH;
-		}
-	}
-	// if we are facing east
-	else if (currentAvatar->direction == M_EAST) {
-		// if there is not a wall to the left, go up
-		if (currentTile->northWall != true) {
-			currentAvatar->direction = M_NORTH;
-			return M_NORTH;
-		}
-		// if there is not a wall in front, go forward
-		else if (currentTile->eastWall != true) {
-			currentAvatar->direction = M_EAST;
-			return M_EAST;
-		}
-		// if there is not a wall to the right, go right
-		else if (currentTile->southWall != true) {
-			currentAvatar->direction = M_SOUTH;
-			return M_SOUTH;
-		}
-		// if there is not a wall to the back, go backwards
-		else if (currentTile->westWall != true) {
-			currentAvatar->direction = M_WEST;
-			return M_WEST;
-		}
-	}
-	// if we are facing south
-	else if (currentAvatar->direction == M_SOUTH) {
-		// if there is not a wall to the left, go left
-		if (currentTile->eastWall != true) {
-			currentAvatar->direction = M_EAST;
-			return M_EAST;
-		}
-		// if there is not a wall in front, go forward
-		else if (currentTile->southWall != true) {
-			currentAvatar->direction = M_SOUTH;
-			return M_SOUTH;
-		}
-		// if there is not a wall to the right, go right
-		else if (currentTile->westWall != true) {
-			currentAvatar->direction = M_WEST;
-			return M_WEST;
-		}
-		// if there is not a wall to the back, go backwards
-		else if (currentTile->northWall != true) {
-			currentAvatar->direction = M_NORTH;
-			return M_NORTH;
-		}
+	// Look the move up instead of walking a ladder of poorly predicted wall tests; a null move keeps the facing
+	unsigned int facing = (unsigned int)currentAvatar->direction <= M_NULL_MOVE ? (unsigned int)currentAvatar->direction : M_NULL_MOVE;
+	int move = leftHandTable[facing][walls & 0xf];
+	currentAvatar->direction = (move == M_NULL_MOVE) ? currentAvatar->direction : move;
+	return move;
+}
+
+/*
+ *	Returns the direction an avatar should move in to follow a shortest path to the rendezvous over the known maze
+ */
+int shortestPathRule(avatar_t *currentAvatar, planner_t *planner, rendezvous_t *rendezvous, int *lastTurn) {
+	(*lastTurn) = currentAvatar->avatarID;
+	int goalX, goalY;
+	rendezvousTarget(rendezvous, &goalX, &goalY);
+
+	// Nobody moves before there is a meeting point, or once they stand on it
+	if (goalX < 0 || ((currentAvatar->xCoord == goalX) && (currentAvatar->yCoord == goalY))) {
+		currentAvatar->direction = M_NULL_MOVE;
+		return M_NULL_MOVE;
 	}
-	// if we are facing west
-	else if (currentAvatar->direction == M_WEST) {
-		// if there is not a wall to the left, go left
-		if (currentTile->southWall != true) {
-			currentAvatar->direction = M_SOUTH;
-			return M_SOUTH;
+
+	// Follow the planned path, which is replanned whenever a wall turns up on it or the meeting point moves
+	int move = plannerMove(planner, currentAvatar->xCoord, currentAvatar->yCoord, goalX, goalY);
+	currentAvatar->direction = move;
+	return move;
+}
+
+/*
+ *	Marks the edge crossed by every avatar that moved one tile between two turn messages as open
+ */
+void recordOpenings(maze_t *maze, XYPos *before, XYPos *after, int numAvatars) {
+	for (int k = 0; k < numAvatars; k++) {
+		int oldX = ntohl(before[k].x);
+		int oldY = ntohl(before[k].y);
+		int dx = (int)ntohl(after[k].x) - oldX;
+		int dy = (int)ntohl(after[k].y) - oldY;
+
+		// a single step in one of the four directions
+		if (dx == -1 && dy == 0) {
+			addOpening(maze, oldX, oldY, M_WEST);
 		}
-		// if there is not a wall in front, go forward
-		else if (currentTile->westWall != true) {
-			currentAvatar->direction = M_WEST;
-			return M_WEST;
+		else if (dx == 1 && dy == 0) {
+			addOpening(maze, oldX, oldY, M_EAST);
 		}
-		// if there is not a wall to the right, go right
-		else if (currentTile->northWall != true) {
-			currentAvatar->direction = M_NORTH;
-			return M_NORTH;
+		else if (dx == 0 && dy == -1) {
+			addOpening(maze, oldX, oldY, M_NORTH);
 		}
-		// if there is not a wall to the back, go backwards
-		else if (currentTile->eastWall != true) {
-			currentAvatar->direction = M_EAST;
-			return M_EAST;
+		else if (dx == 0 && dy == 1) {
+			addOpening(maze, oldX, oldY, M_SOUTH);
 		}
 	}
-	return M_NULL_MOVE;
 }
 
 /*
  *	Determines which specific error was caught by the mask and writes to log correspondingly
  */	
-void runAvatarError(FILE *log, int responseType, int moveCount, int avatarID, int *solved) {
+void runAvatarError(logger_t *log, int responseType, int moveCount, int avatarID, int *solved) {
 	// Check which error type ocurred & act accordingly
 	if (responseType == AM_TOO_MANY_MOVES) {
-		fprintf(log, "Move limit reached at turn %d\n", moveCount);
+		loggerPush(log, avatarID, LOG_MOVE_LIMIT, moveCount);
 		(*solved)++;
 	}
 	else if (responseType == AM_NO_SUCH_AVATAR) {
-		fprintf(log, "Avatar %d does not exist\n", avatarID);
+		loggerPush(log, avatarID, LOG_NO_SUCH_AVATAR, avatarID);
 	}
 	else if (responseType == AM_AVATAR_OUT_OF_TURN) {
-		fprintf(log, "Avatar %d moving out of turn on turn %d\n", avatarID, moveCount);
+		loggerPush(log, avatarID, LOG_OUT_OF_TURN, avatarID, moveCount);
 	}
 	else if (responseType == AM_SERVER_TIMEOUT) {
-		fprintf(log, "Server timeout occured on turn %d\n", moveCount);
+		loggerPush(log, avatarID, LOG_SERVER_TIMEOUT, moveCount);
 		(*solved)++;
 	}
 	else if (responseType == AM_UNKNOWN_MSG_TYPE) {
-		fprintf(log, "Unknown message received on turn %d\n", moveCount);
+		loggerPush(log, avatarID, LOG_UNKNOWN_MESSAGE, moveCount);
 	}
 	else if (responseType == AM_UNEXPECTED_MSG_TYPE) {
-		fprintf(log, "Unexpected message of type %d received on turn %d\n", responseType, moveCount);
+		loggerPush(log, avatarID, LOG_UNEXPECTED_MESSAGE, responseType, moveCount);
 	}	
 }
 
@@ -391,179 +419,407 @@ char* parseDirection(int direction) {
 
 // ***********************************************************************
 // ********************** MAIN AVATAR FUNCTION ***************************
+
 /*
- *   Main avatar thread function
+ *	Everything one avatar keeps between two server messages, whichever engine drives it
  */
-void* runAvatar(void *startup) {
+typedef struct avatarSession {
+	startupInfo_t *initStruct;
+	strategyContext_t context;
+	conn_t *conn;                     // MazePort socket and its receive buffer
+	int move;                         // last move sent
+	bool pending;                     // a move was sent and its result not seen yet
+	int turns;                        // moves sent by this avatar
+	long long sentAt;                 // when the last move went out, on the monotonic clock
+	long long receivedAt;             // when the message being handled came in
+	XYPos lastPositions[AM_MAX_AVATAR];
+	bool havePositions;
+} avatarSession_t;
 
-	// Get init struct from void arg
-	startupInfo_t *initStruct = startup;
-
-	// Extract info from init struct
-	pthread_mutex_t *lock = getMutexLock(initStruct);
-	char *hostName = getHostname(initStruct);
-	int myID = getID(initStruct);
-	avatar_t **avatars = getAvatars(initStruct);
-	int *lastTurnID = getLastTurnID(initStruct);
-	mazeTile_t ***maze = getMaze(initStruct);
-	int *solved = getSolved(initStruct);
-	FILE *log = getLog(initStruct);
-	int numAvatars = getNumAvatars(initStruct);
-	int mazePort = getMazePort(initStruct);
-	int *myMoveCount = getMoveCount(initStruct);
+/*
+ *	Sets up the strategy for one avatar
+ */
+avatarSession_t *avatarSessionNew(startupInfo_t *initStruct) {
+	avatarSession_t *session = malloc(sizeof(avatarSession_t));
+	if (session == NULL) {
+		fprintf(stderr, "Failed to malloc for avatar session\n");
+		exit(6);
+	}
+	session->initStruct = initStruct;
+	session->conn = NULL;
+	session->move = M_NULL_MOVE;
+	session->pending = false;
+	session->turns = 0;
+	session->sentAt = 0;
+	session->receivedAt = 0;
+	session->havePositions = false;
+
+	// Let the strategy set up whatever it keeps for this avatar
+	strategyContext_t context = { getID(initStruct), getNumAvatars(initStruct), getAvatars(initStruct), getMaze(initStruct),
+			getRendezvous(initStruct), getLastTurnID(initStruct), getLog(initStruct), getMoveCount(initStruct), NULL };
+	session->context = context;
+	if (!getStrategy(initStruct)->init(&session->context)) {
+		exit(5);
+	}
+	return session;
+}
 
-	// Initialize values for later use
-	int i = 0;
-	int move = 0;
-	int oldDirection = avatars[myID]->direction;
+/*
+ *	Starts connecting one socket to the MazePort at the shared server address, without waiting for it
+ */
+static int startConnect(startupInfo_t *initStruct) {
+	const struct addrinfo *serverAddress = getServerAddress(initStruct);
+
+	// The address AMStartup resolved, with the port of this maze
+	struct sockaddr_storage server;
+	memcpy(&server, serverAddress->ai_addr, serverAddress->ai_addrlen);
+	if (server.ss_family == AF_INET6) {
+		((struct sockaddr_in6 *) &server)->sin6_port = htons(getMazePort(initStruct));
+	} else {
+		((struct sockaddr_in *) &server)->sin_port = htons(getMazePort(initStruct));
+	}
 
-	// Create socket
-	int maze_sock = socket(AF_INET, SOCK_STREAM, 0);
+	// Create a non-blocking socket, so connect returns at once
+	int maze_sock = socket(serverAddress->ai_family, SOCK_STREAM, 0);
 	if (maze_sock < 0) {
 		perror("opening socket");
 		exit(2);
 	}
+	fcntl(maze_sock, F_SETFL, fcntl(maze_sock, F_GETFL) | O_NONBLOCK);
+	if (connect(maze_sock, (struct sockaddr *) &server, serverAddress->ai_addrlen) < 0 && errno != EINPROGRESS) {
+		perror("connecting stream socket");
+		exit(4);
+	}
+	return maze_sock;
+}
+
+/*
+ *	Connects every avatar to its MazePort in parallel and announces each with AM_AVATAR_READY
+ */
+void avatarConnectAll(avatarSession_t **sessions, int numAvatars, capture_t *capture) {
+	struct pollfd fds[AM_MAX_AVATAR];
+	for (int k = 0; k < numAvatars; k++) {
+		fds[k].fd = startConnect(sessions[k]->initStruct);
+		fds[k].events = POLLOUT;
+	}
+
+	// A socket becomes writable once its connect has finished, one way or the other
+	int connecting = numAvatars;
+	while (connecting > 0) {
+		int ready = poll(fds, numAvatars, AM_WAIT_TIME * 1000);
+		if (ready < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ready <= 0) {
+			fprintf(stderr, "ERROR: could not connect to the maze port.\n");
+			exit(4);
+		}
+		for (int k = 0; k < numAvatars; k++) {
+			if (fds[k].fd < 0 || fds[k].revents == 0) {
+				continue;
+			}
+			int error = 0;
+			socklen_t length = sizeof(error);
+			getsockopt(fds[k].fd, SOL_SOCKET, SO_ERROR, &error, &length);
+			if (error != 0) {
+				errno = error;
+				perror("connecting stream socket");
+				exit(4);
+			}
+
+			// Back to blocking for the threads, then send avatar_ready
+			fcntl(fds[k].fd, F_SETFL, fcntl(fds[k].fd, F_GETFL) & ~O_NONBLOCK);
+			sessions[k]->conn = connNew(fds[k].fd);
+			if (sessions[k]->conn == NULL) {
+				exit(6);
+			}
+			connCapture(sessions[k]->conn, capture, getID(sessions[k]->initStruct));
+			AM_Message message;
+			message.type = htonl(AM_AVATAR_READY);
+			message.avatar_ready.AvatarId = htonl(getID(sessions[k]->initStruct));
+			if (!connSend(sessions[k]->conn, &message)) {
+				fprintf(stderr, "ERROR: could not send avatar_ready to the server.\n");
+				exit(7);
+			}
+
+			// poll skips negative descriptors
+			fds[k].fd = -1;
+			connecting--;
+		}
+	}
+}
 
-	// Initialize the fields of the server address
-	struct sockaddr_in server;  // address of the server
-	server.sin_family = AF_INET;
-	server.sin_port = htons(mazePort);
-	// Look up the hostname specified on command line
-	struct hostent *hostp = gethostbyname(hostName); // server hostname
+/*
+ *	Gives every avatar a connection with no socket, whose moves go nowhere
+ */
+void avatarConnectOffline(avatarSession_t **sessions, int numAvatars) {
+	for (int k = 0; k < numAvatars; k++) {
+		sessions[k]->conn = connNew(-1);
+		if (sessions[k]->conn == NULL) {
+			exit(6);
+		}
+	}
+}
 
-	if (hostp == NULL) {
-		fprintf(stderr, "avatar: unknown host '%s'\n", hostName);
-		exit(3);
+/*
+ *	Waits until the server has written to any avatar's socket
+ */
+bool avatarAwaitFirstTurn(avatarSession_t **sessions, int numAvatars) {
+	struct pollfd fds[AM_MAX_AVATAR];
+	for (int k = 0; k < numAvatars; k++) {
+		fds[k].fd = connFd(sessions[k]->conn);
+		fds[k].events = POLLIN;
 	}
-	memcpy(&server.sin_addr, hostp->h_addr_list[0], hostp->h_length);
+	int ready;
+	do {
+		ready = poll(fds, numAvatars, AM_WAIT_TIME * 1000);
+	} while (ready < 0 && errno == EINTR);
+	return ready > 0;
+}
 
-	// Connect the socket to that server   
-	if (connect(maze_sock, (struct sockaddr *) &server, sizeof(server)) < 0) {
-		perror("connecting stream socket");
-		exit(4);
-	}	
+int avatarSocket(avatarSession_t *session) {
+	return session->conn != NULL ? connFd(session->conn) : -1;
+}
 
-	// Assemble avatar_ready message
-	AM_Message message;
-	message.type = htonl(AM_AVATAR_READY);
-	uint32_t id = getID(initStruct);
-	message.avatar_ready.AvatarId = htonl(id);
+/*
+ *	Reads whatever the server sent and acts on every whole message that came with it
+ */
+bool avatarReceive(avatarSession_t *session, bool wait) {
+	int bytesReceived = connFill(session->conn, wait);
 
-	// Send avatar_ready message
-	send(maze_sock, (void *) &message, sizeof(message), 0);
+	// If there was a problem getting a response, exit
+	if (bytesReceived < 0) {
+		if (!wait && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			return true;
+		}
+		fprintf(stderr, "ERROR: No message recieved.\n");
+		exit(1);
+	}
+	// The server hung up, so there is nothing more to play
+	if (bytesReceived == 0) {
+		return false;
+	}
+	session->receivedAt = latencyNow();
+
+	// Handle messages in place; a partial one stays buffered for the next read
+	AM_Message *message;
+	while ((message = connPeek(session->conn)) != NULL) {
+		bool playing = avatarHandleMessage(session, message);
+		connConsume(session->conn);
+		if (!playing) {
+			return false;
+		}
+	}
+	return true;
+}
 
-	// Main "move loop" - ends when an error condition triggers or maze is solved
-	while (*solved == 0) {
+/*
+ *	Acts on a message that did not come from the socket, as if it had just arrived
+ */
+bool avatarDeliver(avatarSession_t *session, AM_Message *message) {
+	session->receivedAt = latencyNow();
+	return avatarHandleMessage(session, message);
+}
 
-		// Wait for server's response
-		AM_Message response;
-		int bytesReceived = recv(maze_sock, (void *) &response, sizeof(AM_Message), 0);
-
-		// If there was a problem getting a response, exit
-		if (bytesReceived < 0) {
-			fprintf(stderr, "ERROR: No message recieved.\n");
-			exit(1);
-		} else {
-			// If we've received a turn message
-			if (response.type == ntohl(AM_AVATAR_TURN)) {
-
-				// Parse message from server
-				int turnID = ntohl(response.avatar_turn.TurnId);
-				XYPos *positions = response.avatar_turn.Pos;
-				int newX = ntohl(positions[myID].x);
-				int newY = ntohl(positions[myID].y);
-
-				// If firstTurn, initialize position given by server
-				if (avatars[myID]->firstTurn) {
-					avatars[myID]->firstTurn = false;
-					setPosition(avatars[myID], newX, newY);
-					fprintf(log, "Initial position of Avatar %d is (%d, %d)\n", myID, avatars[myID]->xCoord, avatars[myID]->yCoord);
-				} 
-				// If currentAvatar made the previous move, we must check to see if it was a success
-				if (*lastTurnID == myID) {
-					// if old coords match new coords, we haven't moved
-					if ((avatars[myID]->xCoord == newX) && (avatars[myID]->yCoord == newY)) {
-
-						// if currentAvatar's direction is not 8, it should still be moving & adding walls
-						if (avatars[myID]->direction != 8) {
-							// If we couldn't move - add wall in that direction
-							addWall(maze, avatars[myID]->xCoord, avatars[myID]->yCoord, avatars[myID]->direction);
-							// We must re-orient. Set direction to old direction
-							setDirection(avatars[myID], oldDirection);	
-						}
-
-						// Draw the maze
-						pthread_mutex_lock(lock);
-						drawMaze(getHeight(initStruct), getWidth(initStruct), getNumAvatars(initStruct), avatars, maze);
-						pthread_mutex_unlock(lock);
-					} else {
-						// Move was successful, draw updated maze
-						pthread_mutex_lock(lock);
-						drawMaze(getHeight(initStruct), getWidth(initStruct), getNumAvatars(initStruct), avatars, maze);
-						pthread_mutex_unlock(lock);
-						// Update position to server's new values
-						setPosition(avatars[myID], ntohl(positions[myID].x), ntohl(positions[myID].y));
-					}
-					// Log all avatars "statuses" in log file
-					for (int idx = 0; idx < numAvatars; idx++) {
-						fprintf(log, "Avatar %d at (%d,%d) on turn %d\n", idx, avatars[idx]->xCoord, avatars[idx]->yCoord, *myMoveCount+1);
-					}
-					// if it's currentAvatar's turn, determine new move & send it to server
-				} else if (myID == turnID) {
-					// store old direction in case move fails
-					oldDirection = avatars[myID]->direction;
-					// Determine move
-					move = leftHandRule(avatars[myID], maze[avatars[myID]->yCoord][avatars[myID]->xCoord], lastTurnID, numAvatars, avatars);
-
-					// Assemble move message
-					AM_Message moveMessage;
-					moveMessage.type = htonl(AM_AVATAR_MOVE);
-					uint32_t id = htonl(getID(initStruct));
-					uint32_t direction = htonl(move);
-					moveMessage.avatar_move.AvatarId = id;
-					moveMessage.avatar_move.Direction = direction;
-
-					// Send message
-					send(maze_sock, (void *) &moveMessage, sizeof(message), 0);
-					// Track total move count & individual move count
-					(*myMoveCount)++;
-					i++;
-					// Log move attempt
-					char *dir = parseDirection(move);
-					fprintf(log, "Avatar %d tries to move in direction %s on turn %d, which is turn %d for the  avatar\n", myID, dir, *myMoveCount, i); 
-				}
+int avatarMoves(avatarSession_t *session, int *lastMove) {
+	*lastMove = session->move;
+	return session->turns;
+}
 
-				// if we've received an error
-			} else if (IS_AM_ERROR(response.type)) {
-				// Determine's type of error & logs accordingly
-				runAvatarError(log, ntohl(response.type), *myMoveCount, myID, solved);
-				// if the error was too many moves, close graphics window
-				if (ntohl(response.type) == AM_TOO_MANY_MOVES) {
-					printf("Move limit exceeded.\n");
-					delwin(getWindow(initStruct));
-					endwin();
-				}
+/*
+ *	Keeps the first message that ended the game for AMStartup's summary
+ */
+static void recordEnding(startupInfo_t *initStruct, AM_Message *response) {
+	AM_Message *ending = getEnding(initStruct);
+	if (ending == NULL) {
+		return;
+	}
+	pthread_mutex_lock(getMutexLock(initStruct));
+	if (ending->type == 0) {
+		*ending = *response;
+	}
+	pthread_mutex_unlock(getMutexLock(initStruct));
+}
 
-				// if maze has solved
-			} else if (response.type == ntohl(AM_MAZE_SOLVED)) {
-				printf("SOLVED!\n");
-				printf("ID: %d \nMove Count: %d\n", myID, i);
-				printf("Maze Port: %d\n", mazePort);                   
-				deleteStartupStruct(initStruct);
-				// if not done yet, clean up graphics & log
-				if (*solved == 0 ) {
-					delwin(getWindow(initStruct));
-					endwin();
-					int avatarNum = ntohl(response.maze_solved.nAvatars);
-					int difficulty = ntohl(response.maze_solved.Difficulty);
-					int numberMoves = ntohl(response.maze_solved.nMoves);
-					int hash = ntohl(response.maze_solved.Hash);
-					fprintf(log, "Solved!  Number of avatars: %d, difficulty: %d number of moves: %d, hash: %d\n", avatarNum, difficulty, numberMoves, hash);
+/*
+ *	Acts on one server message: records the result of the avatar's last move, and sends a new one on its turn
+ */
+bool avatarHandleMessage(avatarSession_t *session, AM_Message *response) {
+	startupInfo_t *initStruct = session->initStruct;
+	strategyContext_t *context = &session->context;
+	const strategy_t *strategy = getStrategy(initStruct);
+	int myID = getID(initStruct);
+	avatar_t **avatars = getAvatars(initStruct);
+	maze_t *maze = getMaze(initStruct);
+	int *solved = getSolved(initStruct);
+	logger_t *log = getLog(initStruct);
+	int numAvatars = getNumAvatars(initStruct);
+	int *myMoveCount = getMoveCount(initStruct);
+	latency_t *latency = getLatency(initStruct);
+	renderer_t *renderer = getRenderer(initStruct);
+	bool headless = getWindow(initStruct) == NULL && renderer == NULL;   // nothing goes to the terminal
+	long long start;
+
+	// If we've received a turn message
+	if (response->type == ntohl(AM_AVATAR_TURN)) {
+
+		// Parse message from server
+		int turnID = ntohl(response->avatar_turn.TurnId);
+		XYPos *positions = response->avatar_turn.Pos;
+		int newX = ntohl(positions[myID].x);
+		int newY = ntohl(positions[myID].y);
+
+		// Whoever moved since the last turn message crossed an open edge - record it before deciding
+		if (session->havePositions && myID == turnID) {
+			recordOpenings(maze, session->lastPositions, positions, numAvatars);
+		}
+		memcpy(session->lastPositions, positions, sizeof(session->lastPositions));
+		session->havePositions = true;
+
+		// If firstTurn, initialize position given by server
+		if (avatars[myID]->firstTurn) {
+			avatars[myID]->firstTurn = false;
+			setPosition(avatars[myID], newX, newY);
+			loggerPush(log, myID, LOG_INITIAL_POSITION, myID, avatars[myID]->xCoord, avatars[myID]->yCoord);
+		} 
+		// The first turn message after currentAvatar's move tells whether the move succeeded
+		if (session->pending) {
+			session->pending = false;
+			latencyRecord(latency, myID, LATENCY_NETWORK, session->receivedAt - session->sentAt);
+			// if old coords match new coords, we haven't moved
+			if ((avatars[myID]->xCoord == newX) && (avatars[myID]->yCoord == newY)) {
+
+				// if currentAvatar tried to move, it ran into a wall in that direction
+				if (session->move != M_NULL_MOVE) {
+					addWall(maze, avatars[myID]->xCoord, avatars[myID]->yCoord, session->move);
 				}
-				(*solved)++;
+				strategy->onMoveResult(context, session->move, false);
+			} else {
+				// Move was successful, update position to server's new values
+				setPosition(avatars[myID], newX, newY);
+				strategy->onMoveResult(context, session->move, true);
+			}
+			// Log all avatars "statuses" in log file
+			start = latencyNow();
+			for (int idx = 0; idx < numAvatars; idx++) {
+				loggerPush(log, myID, LOG_POSITION, idx, avatars[idx]->xCoord, avatars[idx]->yCoord, *myMoveCount+1);
 			}
+			latencyRecord(latency, myID, LATENCY_LOG, latencyNow() - start);
+		}
+		// if it's currentAvatar's turn, determine new move & send it to server
+		if (myID == turnID) {
+			// Hand the turn to the render thread, which draws it with the next frame
+			if (renderer != NULL) {
+				start = latencyNow();
+				renderPublish(renderer, positions);
+				latencyRecord(latency, myID, LATENCY_RENDER, latencyNow() - start);
+			}
+
+			// Determine move
+			start = latencyNow();
+			session->move = strategy->chooseMove(context, positions);
+			latencyRecord(latency, myID, LATENCY_DECISION, latencyNow() - start);
+
+			// Assemble move message
+			AM_Message moveMessage;
+			moveMessage.type = htonl(AM_AVATAR_MOVE);
+			moveMessage.avatar_move.AvatarId = htonl(myID);
+			moveMessage.avatar_move.Direction = htonl(session->move);
+
+			// Send message; a move that never left is not counted or logged
+			session->sentAt = latencyNow();
+			if (!connSend(session->conn, &moveMessage)) {
+				fprintf(stderr, "ERROR: could not send move to the server.\n");
+				exit(7);
+			}
+			session->pending = true;
+			// Track total move count & individual move count
+			(*myMoveCount)++;
+			session->turns++;
+			// Log move attempt
+			start = latencyNow();
+			loggerPush(log, myID, LOG_MOVE, myID, parseDirection(session->move), *myMoveCount, session->turns);
+			latencyRecord(latency, myID, LATENCY_LOG, latencyNow() - start);
+		}
+
+		// if we've received an error
+	} else if (IS_AM_ERROR(ntohl(response->type))) {
+		// Determine's type of error & logs accordingly
+		runAvatarError(log, ntohl(response->type), *myMoveCount, myID, solved);
+		// if the error was too many moves, close graphics window
+		if (ntohl(response->type) == AM_TOO_MANY_MOVES) {
+			recordEnding(initStruct, response);
+			renderStop(renderer);
+			if (!headless) {
+				printf("Move limit exceeded.\n");
+			}
+			return false;
+		}
+		if (ntohl(response->type) == AM_SERVER_TIMEOUT) {
+			recordEnding(initStruct, response);
+			return false;
+		}
+		return true;
+
+		// if maze has solved
+	} else if (response->type == ntohl(AM_MAZE_SOLVED)) {
+		// close the graphics window first, so the messages below reach the terminal
+		recordEnding(initStruct, response);
+		renderStop(renderer);
+		if (!headless) {
+			printf("SOLVED!\n");
+			printf("ID: %d \nMove Count: %d\n", myID, session->turns);
+			printf("Maze Port: %d\n", getMazePort(initStruct));                   
+		}
+		// if not done yet, log
+		if (*solved == 0 ) {
+			int avatarNum = ntohl(response->maze_solved.nAvatars);
+			int difficulty = ntohl(response->maze_solved.Difficulty);
+			int numberMoves = ntohl(response->maze_solved.nMoves);
+			int hash = ntohl(response->maze_solved.Hash);
+			loggerPush(log, myID, LOG_SOLVED, avatarNum, difficulty, numberMoves, hash);
+		}
+		(*solved)++;
+		return false;
+	}
+	return true;
+}
+
+/*
+ *	Lets the strategy clean up, closes the avatar's socket and frees the session and its startup struct
+ */
+void avatarSessionDelete(avatarSession_t *session) {
+	getStrategy(session->initStruct)->teardown(&session->context);
+	connDelete(session->conn);
+	deleteStartupStruct(session->initStruct);
+	free(session);
+}
+
+/*
+ *   Main avatar thread function
+ */
+void* runAvatar(void *arg) {
+	avatarSession_t *session = arg;
+	int *solved = getSolved(session->initStruct);
+
+	// Main "move loop" - ends when an error condition triggers, maze is solved or the server goes quiet
+	void *status = NULL;
+	while (*solved == 0) {
+		struct pollfd readable = { avatarSocket(session), POLLIN, 0 };
+		int ready;
+		do {
+			ready = readable.fd >= 0 ? poll(&readable, 1, AM_WAIT_TIME * 1000) : 1;
+		} while (ready < 0 && errno == EINTR);
+		if (ready == 0) {
+			fprintf(stderr, "Avatar %d: no message from the server for %d seconds\n", getID(session->initStruct), AM_WAIT_TIME);
+			status = AVATAR_TIMED_OUT;
+			break;
+		}
+		if (!avatarReceive(session, true)) {
+			break;
 		}
 	}
-	pthread_exit(NULL);
-	return NULL;
+	avatarSessionDelete(session);
+	pthread_exit(status);
+	return status;
 }
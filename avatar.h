@@ -18,13 +18,66 @@
 #include "mazeSolver.h"
 #include "amazing.h"
 
+/**************** constants ****************/
+
+// what runAvatar's thread exits with when the server went quiet in the middle of a game
+#define AVATAR_TIMED_OUT ((void *)1)
+
 /**************** structs ****************/
 
-/**************** mazeTile ****************/
+/**************** maze ****************/
+/*
+ * Represents the known walls of the maze. See mazeSolver.h for details.
+ */
+typedef struct maze maze_t;
+
+/**************** planner ****************/
+/*
+ * Per-avatar shortest path planner. See planner.h for details.
+ */
+typedef struct planner planner_t;
+
+/**************** rendezvous ****************/
+/*
+ * Meeting point shared by all avatars. See rendezvous.h for details.
+ */
+typedef struct rendezvous rendezvous_t;
+
+/**************** strategy ****************/
+/*
+ * Table of hooks deciding an avatar's moves. See strategy.h for details.
+ */
+typedef struct strategy strategy_t;
+
+/**************** latency ****************/
 /*
- * Represents a coordinate pair on the maze.
+ * Per-avatar histograms of how long each phase of a turn takes. See latency.h for details.
  */
-typedef struct mazeTile mazeTile_t;
+typedef struct latency latency_t;
+
+/**************** renderer ****************/
+/*
+ * Render thread that draws published turns. See render.h for details.
+ */
+typedef struct renderer renderer_t;
+
+/**************** logger ****************/
+/*
+ * Writer thread that formats and writes the log. See logger.h for details.
+ */
+typedef struct logger logger_t;
+
+/**************** capture ****************/
+/*
+ * Recording of every message sent and received. See capture.h for details.
+ */
+typedef struct capture capture_t;
+
+/**************** addrinfo ****************/
+/*
+ * Server address resolved by getaddrinfo() in AMStartup. See netdb.h.
+ */
+struct addrinfo;
 
 /**************** startupInfo ****************/
 /*
@@ -33,6 +86,14 @@ typedef struct mazeTile mazeTile_t;
  */
 typedef struct startupInfo startupInfo_t;  // opaque to users of the module
 
+/**************** avatarSession ****************/
+/*
+ * What one avatar keeps between server messages: its strategy context, socket, last move and
+ * whether its result is still to come. Driven by runAvatar, or by runEventLoop for all avatars
+ * at once. See avatar.c for details.
+ */
+typedef struct avatarSession avatarSession_t;  // opaque to users of the module
+
 /**************** avatar ****************/
 /*
  * Defines an avatar struct that holds an avatar id, x coord, y coord, direction, and whether or not
@@ -86,6 +147,14 @@ int getDiff(startupInfo_t* s);
  */
 char* getHostname(startupInfo_t* s);
 
+/*
+ * Input: startupInfo_t struct.
+ *
+ * Output: Server address resolved once by AMStartup; avatars connect to it on the MazePort.
+ *
+ */
+const struct addrinfo *getServerAddress(startupInfo_t* s);
+
 /*
  * Input: startupInfo_t struct.
  *
@@ -201,22 +270,141 @@ void avatarDelete(avatar_t *avatar);
 /*
  * Function which describes the behavior of an avatar's movement.
  *
- * Input: Avatar, mazetile, lastTurn, number of avatars, list of avatars.
+ * Input: Avatar, 4-bit wall mask of the avatar's tile (see getWalls), lastTurn, number of avatars, list of avatars.
  *
  * Output: Integer representing the direction for the current avatar to move in.
  *
  */
-int leftHandRule(avatar_t *currentAvatar, mazeTile_t *currentTile, int *lastTurn, int numAvatars, avatar_t **avatars);
+int leftHandRule(avatar_t *currentAvatar, int walls, int *lastTurn, int numAvatars, avatar_t **avatars);
+
+/*
+ * Function which describes the behavior of an avatar's movement using the shared knowledge of the maze.
+ * Every avatar, the last one included, follows a shortest path to the rendezvous target, treating unknown edges as open.
+ * Played by the "bfs" and "incremental" strategies (see strategy.h).
+ *
+ * Input: Avatar, the avatar's planner, the shared rendezvous (see rendezvousUpdate), lastTurn.
+ *
+ * Output: Integer representing the direction for the current avatar to move in.
+ *
+ */
+int shortestPathRule(avatar_t *currentAvatar, planner_t *planner, rendezvous_t *rendezvous, int *lastTurn);
 
 /*
  * Function which calls the helper functions to "drive" an avatar from the start to the finish of the game.
+ * Each move is decided by the strategy in the startup struct, through the hooks in strategy.h.
  *
- * Input: A startup struct representing all necessary knowledge the avatars need to have to beat the game.
+ * Input: A session created by avatarSessionNew and connected by avatarConnectAll; the thread deletes it.
  *
  * Output: Graphics, print statements, and log files which act as a GUI and history for the user. Output shows the user that the game has been won.
+ * The thread exits with NULL once the game is over for the avatar, or with AVATAR_TIMED_OUT if the
+ * server sent it nothing for AM_WAIT_TIME seconds.
+ *
+ */
+void* runAvatar(void *session);
+
+/*
+ * Function which sets up one avatar for a game and calls its strategy's init hook.
+ *
+ * Input: The avatar's startup struct, which the session takes over.
+ *
+ * Output: A session with no socket yet.
+ *
+ */
+avatarSession_t *avatarSessionNew(startupInfo_t *initStruct);
+
+/*
+ * Function which connects every avatar to the MazePort at once and sends each AM_AVATAR_READY.
+ * All sockets are opened non-blocking and connected in parallel, so startup costs one round trip
+ * instead of one per avatar.
+ *
+ * Input: Sessions of all avatars, number of avatars, capture to record every avatar's messages into (or NULL).
+ *
+ * Output: Every session holds a connected socket. Exits the program if any avatar cannot connect.
  *
  */
-void* runAvatar(void *startup);
+void avatarConnectAll(avatarSession_t **sessions, int numAvatars, capture_t *capture);
+
+/*
+ * Function which gives every avatar a connection with no socket instead, for playing from a
+ * capture: nothing is received, and moves are sent nowhere.
+ *
+ * Input: Sessions of all avatars, number of avatars.
+ *
+ * Output: None. Exits the program if memory could not be allocated.
+ *
+ */
+void avatarConnectOffline(avatarSession_t **sessions, int numAvatars);
+
+/*
+ * Function which waits until the server has sent the first message of the game (normally the
+ * first AM_AVATAR_TURN, once every avatar is ready) to any avatar, without reading it.
+ *
+ * Input: Connected sessions of all avatars, number of avatars.
+ *
+ * Output: False if nothing arrived within AM_WAIT_TIME seconds.
+ *
+ */
+bool avatarAwaitFirstTurn(avatarSession_t **sessions, int numAvatars);
+
+/*
+ * Input: Session.
+ *
+ * Output: The avatar's MazePort socket, or -1 before avatarConnectAll.
+ *
+ */
+int avatarSocket(avatarSession_t *session);
+
+/*
+ * Function which reads from an avatar's socket and, once a whole message has arrived, hands it
+ * to avatarHandleMessage. Messages may arrive in pieces; the part read so far is kept in the session.
+ *
+ * Input: Session, whether to block until something arrives.
+ *
+ * Output: False once the game is over for this avatar (solved, out of moves, timed out or the server hung up).
+ *
+ */
+bool avatarReceive(avatarSession_t *session, bool wait);
+
+/*
+ * Function which acts on one server message. The first AM_AVATAR_TURN after the avatar moved
+ * tells whether the move got through; when the turn is the avatar's it asks the strategy for a
+ * move and sends it.
+ *
+ * Input: Session, message from the server.
+ *
+ * Output: False once the game is over for this avatar.
+ *
+ */
+bool avatarHandleMessage(avatarSession_t *session, AM_Message *response);
+
+/*
+ * Function which hands avatarHandleMessage a message that did not come from the avatar's socket,
+ * e.g. one read from a capture, timed as if it had just arrived.
+ *
+ * Input: Session, message (network byte order).
+ *
+ * Output: False once the game is over for this avatar.
+ *
+ */
+bool avatarDeliver(avatarSession_t *session, AM_Message *message);
+
+/*
+ * Input: Session, where to put the last move the avatar sent (M_NULL_MOVE before the first).
+ *
+ * Output: Number of moves the avatar has sent.
+ *
+ */
+int avatarMoves(avatarSession_t *session, int *lastMove);
+
+/*
+ * Function which calls the strategy's teardown hook, closes the socket and frees the session with its startup struct.
+ *
+ * Input: Session.
+ *
+ * Output: None.
+ *
+ */
+void avatarSessionDelete(avatarSession_t *session);
 
 /*
  * Function which sets the position of an avatar.
@@ -246,7 +434,7 @@ void setDirection(avatar_t *avatar, int direction);
  * Output: Returns a startupInfo_t struct with all necessary knowledge initialized inside.
  *
  */
-startupInfo_t* loadStartupStruct(pthread_mutex_t *lock, int avatarID, int nAvatars, int difficulty, char *hostname, int mazePort, char *logFile, avatar_t **avatars, int *lastTurnID, mazeTile_t ***maze, int *solved, int height, int width, WINDOW *window, FILE *log, int *moveCount);
+startupInfo_t* loadStartupStruct(pthread_mutex_t *lock, int avatarID, int nAvatars, int difficulty, char *hostname, const struct addrinfo *serverAddress, int mazePort, char *logFile, avatar_t **avatars, int *lastTurnID, maze_t *maze, rendezvous_t *rendezvous, const strategy_t *strategy, int *solved, int height, int width, WINDOW *window, logger_t *log, int *moveCount, latency_t *latency, renderer_t *renderer, AM_Message *ending);
 
 /*
  * Function which frees memory allocated for a startupInfo_t struct.
@@ -258,15 +446,25 @@ startupInfo_t* loadStartupStruct(pthread_mutex_t *lock, int avatarID, int nAvata
  */
 void deleteStartupStruct(startupInfo_t *s);
 
+/*
+ * Function which records the edges avatars moved through between two turn messages.
+ *
+ * Input: Maze, avatar positions from the previous and the current AM_AVATAR_TURN (network byte order), number of avatars.
+ *
+ * Output: Marks the edge crossed by every avatar that moved exactly one tile as open in the maze.
+ *
+ */
+void recordOpenings(maze_t *maze, XYPos *before, XYPos *after, int numAvatars);
+
 /*
  * Function which handles all error messages.
  *
- * Input: Log file, type of response, move count, avatar ID, solved integer.
+ * Input: Logger, type of response, move count, avatar ID, solved integer.
  *
- * Output: Prints to the log file a corresponding error message.
+ * Output: Logs a corresponding error message.
  *
  */
-void runAvatarError(FILE *log, int resposeType, int moveCount, int avatarID, int *solved);
+void runAvatarError(logger_t *log, int resposeType, int moveCount, int avatarID, int *solved);
 
 /*
  * Function which converts an integer representing a direction to a string of that direction.
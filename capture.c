@@ -0,0 +1,110 @@
+/*
+ * capture.c - 'capture' module
+ *
+ * see capture.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include "amazing.h"
+#include "latency.h"
+#include "capture.h"
+
+/*
+ * On disk each record is its time (int64), avatar ID (int32) and direction (int32, 1 if sent),
+ * all in host byte order, then the message as it was on the wire.
+ */
+#define CAPTURE_RECORD_SIZE (8 + 4 + 4 + sizeof(AM_Message))
+
+typedef struct capture {
+	FILE *fp;
+	long long start;                  // latencyNow() when the capture was started
+	long count;
+	pthread_mutex_t lock;             // one writer at a time, so records stay whole and in order
+} capture_t;
+
+static capture_t *captureAlloc(FILE *fp) {
+	capture_t *capture = malloc(sizeof(capture_t));
+	if (capture == NULL) {
+		fprintf(stderr, "Failed to malloc for capture\n");
+		return NULL;
+	}
+	capture->fp = fp;
+	capture->start = latencyNow();
+	capture->count = 0;
+	pthread_mutex_init(&capture->lock, NULL);
+	return capture;
+}
+
+capture_t *captureNew(FILE *fp) {
+	size_t length = strlen(CAPTURE_MAGIC);
+	if (fwrite(CAPTURE_MAGIC, 1, length, fp) != length) {
+		fprintf(stderr, "Failed to write the capture header\n");
+		return NULL;
+	}
+	return captureAlloc(fp);
+}
+
+capture_t *captureOpen(FILE *fp) {
+	char magic[sizeof(CAPTURE_MAGIC)];
+	size_t length = strlen(CAPTURE_MAGIC);
+	if (fread(magic, 1, length, fp) != length || memcmp(magic, CAPTURE_MAGIC, length) != 0) {
+		return NULL;
+	}
+	return captureAlloc(fp);
+}
+
+void captureWrite(capture_t *capture, int avatarID, bool sent, const AM_Message *message) {
+	if (capture == NULL) {
+		return;
+	}
+	unsigned char record[CAPTURE_RECORD_SIZE];
+	int32_t id = avatarID;
+	int32_t direction = sent;
+	pthread_mutex_lock(&capture->lock);
+	int64_t nanos = latencyNow() - capture->start;
+	memcpy(record, &nanos, 8);
+	memcpy(record + 8, &id, 4);
+	memcpy(record + 12, &direction, 4);
+	memcpy(record + 16, message, sizeof(AM_Message));
+	fwrite(record, 1, CAPTURE_RECORD_SIZE, capture->fp);
+	capture->count++;
+	pthread_mutex_unlock(&capture->lock);
+}
+
+bool captureRead(capture_t *capture, captureRecord_t *record) {
+	unsigned char raw[CAPTURE_RECORD_SIZE];
+	if (fread(raw, 1, CAPTURE_RECORD_SIZE, capture->fp) != CAPTURE_RECORD_SIZE) {
+		return false;
+	}
+	int64_t nanos;
+	int32_t id, direction;
+	memcpy(&nanos, raw, 8);
+	memcpy(&id, raw + 8, 4);
+	memcpy(&direction, raw + 12, 4);
+	record->nanos = nanos;
+	record->avatarID = id;
+	record->sent = direction != 0;
+	memcpy(&record->message, raw + 16, sizeof(AM_Message));
+	capture->count++;
+	return true;
+}
+
+long captureCount(capture_t *capture) {
+	return capture->count;
+}
+
+void captureDelete(capture_t *capture) {
+	if (capture != NULL) {
+		fflush(capture->fp);
+		pthread_mutex_destroy(&capture->lock);
+		free(capture);
+	}
+}
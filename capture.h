@@ -0,0 +1,116 @@
+/*
+ * capture.h - header file for capture module
+ *
+ * This module records every AM_Message a client sends and receives, on every socket, with the
+ * time it was sent or handled, into a capture file; and reads captures back. Records from all
+ * sockets go into one file in the order they happened, so a capture can be replayed (see
+ * replay.h) without a server or a network.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __CAPTURE_H
+#define __CAPTURE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "amazing.h"
+
+/**************** constants ****************/
+
+// first bytes of a capture file
+#define CAPTURE_MAGIC "AMCAPT01"
+
+// avatar ID of AMStartup's own socket, which carries AM_INIT and its answer
+#define CAPTURE_STARTUP -1
+
+/**************** structs ****************/
+
+/**************** captureRecord ****************/
+/*
+ * One message as it was sent or received.
+ */
+typedef struct captureRecord {
+	long long nanos;          // since the capture was started
+	int avatarID;             // whose socket, or CAPTURE_STARTUP
+	bool sent;                // sent to the server, or received from it
+	AM_Message message;       // network byte order, as on the wire
+} captureRecord_t;
+
+/**************** capture ****************/
+/*
+ * The capture file, and a lock for the threads recording into it. See capture.c for details.
+ */
+typedef struct capture capture_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** captureNew ****************/
+/*
+ * Function which starts a capture, writing its header.
+ *
+ * Input: File to record into (left open).
+ *
+ * Output: The capture, or NULL if memory could not be allocated or the header not written.
+ *
+ */
+capture_t *captureNew(FILE *fp);
+
+/**************** captureOpen ****************/
+/*
+ * Function which opens a capture to read back.
+ *
+ * Input: File to read, from the start (left open).
+ *
+ * Output: The capture, or NULL if the file is not a capture.
+ *
+ */
+capture_t *captureOpen(FILE *fp);
+
+/**************** captureWrite ****************/
+/*
+ * Function which records one message. Any thread may call it; records are kept in the order
+ * the calls were made.
+ *
+ * Input: Capture from captureNew() (NULL records nothing), avatar ID or CAPTURE_STARTUP,
+ * whether the message was sent, message (network byte order).
+ *
+ * Output: None.
+ *
+ */
+void captureWrite(capture_t *capture, int avatarID, bool sent, const AM_Message *message);
+
+/**************** captureRead ****************/
+/*
+ * Function which reads the next record.
+ *
+ * Input: Capture from captureOpen(), where to put the record.
+ *
+ * Output: False at the end of the capture, or if it was cut short.
+ *
+ */
+bool captureRead(capture_t *capture, captureRecord_t *record);
+
+/**************** captureCount ****************/
+/*
+ * Input: Capture.
+ *
+ * Output: Records written or read so far.
+ *
+ */
+long captureCount(capture_t *capture);
+
+/**************** captureDelete ****************/
+/*
+ * Function which flushes the file and frees the capture. The file is left open.
+ *
+ * Input: Capture, or NULL.
+ *
+ * Output: None.
+ *
+ */
+void captureDelete(capture_t *capture);
+
+#endif // __CAPTURE_H
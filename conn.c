@@ -0,0 +1,164 @@
+/*
+ * conn.c - 'conn' module
+ *
+ * see conn.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // MSG_NOSIGNAL, recvmsg
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>	      // close
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>	      // struct iovec
+#include "amazing.h"
+#include "capture.h"
+#include "conn.h"
+
+#define CONN_CAPACITY (CONN_FRAMES * sizeof(AM_Message))
+
+/*
+ * 'head' is where the oldest unread byte is and always a multiple of sizeof(AM_Message);
+ * 'count' bytes follow it, wrapping around the end of 'buffer'. A negative 'fd' is no socket.
+ */
+typedef struct conn {
+	int fd;
+	size_t head;
+	size_t count;
+	capture_t *capture;               // where messages are recorded, or NULL
+	int avatarID;                     // whose messages they are, in the capture
+	bool captured;                    // the message at the head is recorded already
+	AM_Message buffer[CONN_FRAMES];   // AM_Message elements keep the frames aligned
+} conn_t;
+
+conn_t *connNew(int fd) {
+	conn_t *conn = malloc(sizeof(conn_t));
+	if (conn == NULL) {
+		fprintf(stderr, "Failed to malloc for connection\n");
+		return NULL;
+	}
+	conn->fd = fd;
+	conn->head = 0;
+	conn->count = 0;
+	conn->capture = NULL;
+	conn->avatarID = CAPTURE_STARTUP;
+	conn->captured = false;
+	return conn;
+}
+
+void connDelete(conn_t *conn) {
+	if (conn != NULL) {
+		if (conn->fd >= 0) {
+			close(conn->fd);
+		}
+		free(conn);
+	}
+}
+
+int connFd(conn_t *conn) {
+	return conn->fd;
+}
+
+void connCapture(conn_t *conn, capture_t *capture, int avatarID) {
+	conn->capture = capture;
+	conn->avatarID = avatarID;
+}
+
+/*
+ *	Reads into the free space after the buffered bytes, which may wrap round to the front
+ */
+int connFill(conn_t *conn, bool wait) {
+	char *bytes = (char *)conn->buffer;
+	size_t tail = (conn->head + conn->count) % CONN_CAPACITY;
+	size_t space = CONN_CAPACITY - conn->count;
+	if (space == 0) {
+		errno = ENOBUFS;
+		return -1;
+	}
+	if (conn->fd < 0) {
+		return 0;
+	}
+
+	// the free space runs from the tail to the end of the buffer, then from the front up to the head
+	struct iovec parts[2];
+	int numParts = 1;
+	parts[0].iov_base = bytes + tail;
+	if (tail + space <= CONN_CAPACITY) {
+		parts[0].iov_len = space;
+	}
+	else {
+		parts[0].iov_len = CONN_CAPACITY - tail;
+		parts[1].iov_base = bytes;
+		parts[1].iov_len = space - parts[0].iov_len;
+		numParts = 2;
+	}
+
+	struct msghdr header = { 0 };
+	header.msg_iov = parts;
+	header.msg_iovlen = numParts;
+	ssize_t received;
+	do {
+		received = recvmsg(conn->fd, &header, wait ? 0 : MSG_DONTWAIT);
+	} while (received < 0 && errno == EINTR);
+
+	if (received > 0) {
+		conn->count += received;
+	}
+	return (int)received;
+}
+
+AM_Message *connPeek(conn_t *conn) {
+	if (conn->count < sizeof(AM_Message)) {
+		return NULL;
+	}
+	AM_Message *message = &conn->buffer[conn->head / sizeof(AM_Message)];
+
+	// recorded the first time it is looked at, so before whatever is sent in answer
+	if (conn->capture != NULL && !conn->captured) {
+		captureWrite(conn->capture, conn->avatarID, false, message);
+		conn->captured = true;
+	}
+	return message;
+}
+
+void connConsume(conn_t *conn) {
+	if (conn->count >= sizeof(AM_Message)) {
+		conn->head = (conn->head + sizeof(AM_Message)) % CONN_CAPACITY;
+		conn->count -= sizeof(AM_Message);
+		conn->captured = false;
+	}
+}
+
+/*
+ *	Writes until the whole message is out, waiting for room if the socket is non-blocking
+ */
+bool connSend(conn_t *conn, AM_Message *message) {
+	captureWrite(conn->capture, conn->avatarID, true, message);
+	if (conn->fd < 0) {
+		return true;
+	}
+	char *bytes = (char *)message;
+	size_t sent = 0;
+	while (sent < sizeof(AM_Message)) {
+		ssize_t n = send(conn->fd, bytes + sent, sizeof(AM_Message) - sent, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+			struct pollfd writable = { conn->fd, POLLOUT, 0 };
+			poll(&writable, 1, -1);
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		sent += n;
+	}
+	return true;
+}
@@ -0,0 +1,132 @@
+/*
+ * conn.h - header file for conn module
+ *
+ * This module frames AM_Messages on a TCP socket. TCP delivers a byte stream, so one recv can
+ * return part of a message or several messages at once, and one send can write only part of
+ * one. A connection reads into a per-socket ring buffer and hands out whole messages straight
+ * from it, and writes retry until the whole message is out.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __CONN_H
+#define __CONN_H
+
+#include <stdbool.h>
+#include "amazing.h"
+#include "capture.h"
+
+/**************** constants ****************/
+
+/*
+ * Size of the ring buffer in messages. The buffer is a whole number of messages long and is
+ * always consumed a whole message at a time, so a complete message never wraps around its end
+ * and can be read in place.
+ */
+#define CONN_FRAMES 16
+
+/**************** structs ****************/
+
+/**************** conn ****************/
+/*
+ * A socket with its ring buffer of received bytes. See conn.c for details.
+ */
+typedef struct conn conn_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** connNew ****************/
+/*
+ * Function which wraps a connected socket. With no socket (-1) the connection never receives
+ * anything and sends go nowhere but to its capture, e.g. for replaying a capture.
+ *
+ * Input: Socket, or -1.
+ *
+ * Output: A connection with an empty buffer, or NULL if memory could not be allocated.
+ *
+ */
+conn_t *connNew(int fd);
+
+/**************** connDelete ****************/
+/*
+ * Function which closes the socket and frees the connection.
+ *
+ * Input: Connection created by connNew().
+ *
+ * Output: None.
+ *
+ */
+void connDelete(conn_t *conn);
+
+/**************** connFd ****************/
+/*
+ * Input: Connection.
+ *
+ * Output: Its socket, e.g. to register with poll or epoll.
+ *
+ */
+int connFd(conn_t *conn);
+
+/**************** connCapture ****************/
+/*
+ * Function which records every message sent on the connection, and every message received
+ * the first time connPeek() returns it, into a capture.
+ *
+ * Input: Connection, capture (NULL to stop recording), avatar ID to record under, or CAPTURE_STARTUP.
+ *
+ * Output: None.
+ *
+ */
+void connCapture(conn_t *conn, capture_t *capture, int avatarID);
+
+/**************** connFill ****************/
+/*
+ * Function which reads as much as is waiting, up to the free space in the buffer, with one
+ * recvmsg() call scattering into both free parts of the ring. Several messages that arrived together
+ * are taken in the same call.
+ *
+ * Input: Connection, whether to block until something arrives.
+ *
+ * Output: Bytes read; 0 if the peer closed the connection; -1 on error, with errno set
+ * (EAGAIN or EWOULDBLOCK when not waiting and nothing is there).
+ *
+ */
+int connFill(conn_t *conn, bool wait);
+
+/**************** connPeek ****************/
+/*
+ * Function which gives the oldest whole message in the buffer without copying it.
+ *
+ * Input: Connection.
+ *
+ * Output: Pointer into the buffer, valid until connConsume() or connFill(); NULL if no whole message has arrived.
+ *
+ */
+AM_Message *connPeek(conn_t *conn);
+
+/**************** connConsume ****************/
+/*
+ * Function which drops the message connPeek() returned, making room for more.
+ *
+ * Input: Connection.
+ *
+ * Output: None.
+ *
+ */
+void connConsume(conn_t *conn);
+
+/**************** connSend ****************/
+/*
+ * Function which writes a whole message, carrying on after short writes and interrupted calls,
+ * and waiting for room on a non-blocking socket. Never raises SIGPIPE.
+ *
+ * Input: Connection, message (network byte order).
+ *
+ * Output: False if the connection failed before the whole message was written.
+ *
+ */
+bool connSend(conn_t *conn, AM_Message *message);
+
+#endif // __CONN_H
@@ -0,0 +1,173 @@
+/*
+ * conntest.c, a testing module for the message framing in conn.c
+ *
+ * A writer thread streams numbered AM_Messages into one end of a socket pair and a reader
+ * takes them out of the other end through a conn_t. First the stream is written in random
+ * pieces of 1 to 200 bytes, so messages arrive split and several at a time; then connSend
+ * writes into a non-blocking socket with a tiny send buffer while the reader falls behind, so
+ * writes come up short and have to wait. Every message must come out whole and in order.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r, nanosleep
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>	      // memset
+#include <unistd.h>	      // close
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <netdb.h>	      // htonl
+#include <sys/socket.h>
+#include "amazing.h"
+#include "conn.h"
+
+/**************** file-local constants ****************/
+#define NUM_MESSAGES 20000
+#define MAX_PIECE 200
+
+/**************** file-local types ****************/
+typedef struct writer {
+	int fd;
+	bool pieces;              // random pieces with send(), or whole messages with connSend()
+} writer_t;
+
+/**************** file-local functions ****************/
+
+// message number i, with every field derived from i
+static void makeMessage(AM_Message *message, uint32_t i) {
+	memset(message, 0, sizeof(AM_Message));
+	message->type = htonl(AM_AVATAR_TURN);
+	message->avatar_turn.TurnId = htonl(i);
+	for (int k = 0; k < AM_MAX_AVATAR; k++) {
+		message->avatar_turn.Pos[k].x = htonl(i * 31 + k);
+		message->avatar_turn.Pos[k].y = htonl(i * 17 + k);
+	}
+}
+
+// writes every message, then closes its end
+static void *writeMessages(void *arg) {
+	writer_t *writer = arg;
+	unsigned int seed = 5;
+	if (writer->pieces) {
+		// the whole stream, cut at random points regardless of message boundaries
+		size_t total = NUM_MESSAGES * sizeof(AM_Message);
+		char *stream = malloc(total);
+		for (uint32_t i = 0; i < NUM_MESSAGES; i++) {
+			makeMessage((AM_Message *)stream + i, i);
+		}
+		size_t sent = 0;
+		while (sent < total) {
+			size_t piece = 1 + rand_r(&seed) % MAX_PIECE;
+			piece = piece < total - sent ? piece : total - sent;
+			ssize_t n = send(writer->fd, stream + sent, piece, MSG_NOSIGNAL);
+			if (n > 0) {
+				sent += n;
+			}
+		}
+		free(stream);
+		close(writer->fd);
+	}
+	else {
+		conn_t *conn = connNew(writer->fd);
+		for (uint32_t i = 0; i < NUM_MESSAGES; i++) {
+			AM_Message message;
+			makeMessage(&message, i);
+			connSend(conn, &message);
+		}
+		connDelete(conn);
+	}
+	return NULL;
+}
+
+// reads until the writer closes; returns the number of messages that came out wrong
+static int readMessages(int fd, bool slow, int *received) {
+	conn_t *conn = connNew(fd);
+	int wrong = 0;
+	*received = 0;
+	struct timespec pause = { 0, 100000 };
+	while (connFill(conn, true) > 0) {
+		AM_Message *message;
+		while ((message = connPeek(conn)) != NULL) {
+			AM_Message expected;
+			makeMessage(&expected, *received);
+			if (memcmp(message, &expected, sizeof(AM_Message)) != 0) {
+				wrong++;
+			}
+			(*received)++;
+			connConsume(conn);
+		}
+		// fall behind now and then so the writer's buffer fills up
+		if (slow && *received % 1000 < 10) {
+			nanosleep(&pause, NULL);
+		}
+	}
+	connDelete(conn);
+	return wrong;
+}
+
+// runs one writer against the reader and reports
+static bool runCase(const char *name, bool pieces) {
+	int fds[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	if (!pieces) {
+		int size = 1024;
+		setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+		fcntl(fds[0], F_SETFL, fcntl(fds[0], F_GETFL) | O_NONBLOCK);
+	}
+	writer_t writer = { fds[0], pieces };
+	pthread_t thread;
+	pthread_create(&thread, NULL, writeMessages, &writer);
+	int received;
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int wrong = readMessages(fds[1], !pieces, &received);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	pthread_join(thread, NULL);
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	printf("%s: %d of %d messages received, %d wrong, %.0f messages per second\n", name, received, NUM_MESSAGES, wrong, received / seconds);
+	return received == NUM_MESSAGES && wrong == 0;
+}
+
+// Testing function
+int main(int argc, char *argv[]) {
+	bool ok = true;
+
+	// nothing waiting: a non-blocking fill says so instead of blocking
+	int fds[2];
+	socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+	conn_t *conn = connNew(fds[1]);
+	int result = connFill(conn, false);
+	bool again = result < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+	printf("Fill with nothing waiting returns %d (%s)\n", result, again ? "EAGAIN" : "unexpected");
+	ok = ok && again && connPeek(conn) == NULL;
+
+	// half a message is not a message
+	AM_Message message;
+	makeMessage(&message, 7);
+	send(fds[0], &message, sizeof(message) / 2, 0);
+	connFill(conn, true);
+	ok = ok && connPeek(conn) == NULL;
+	send(fds[0], (char *)&message + sizeof(message) / 2, sizeof(message) - sizeof(message) / 2, 0);
+	connFill(conn, true);
+	ok = ok && connPeek(conn) != NULL && memcmp(connPeek(conn), &message, sizeof(message)) == 0;
+	connConsume(conn);
+	close(fds[0]);
+	ok = ok && connFill(conn, true) == 0;
+	connDelete(conn);
+
+	ok = runCase("Random pieces", true) && ok;
+	ok = runCase("Short writes", false) && ok;
+
+	if (!ok) {
+		printf("Test Results Failed\n");
+		return 1;
+	}
+	printf("Test Results Successful\n");
+	return 0;
+}
@@ -8,9 +8,63 @@
 #include <curses.h>
 #include "avatar.h"
 #include "mazeSolver.h"
+#include "planner.h"
+#include "rendezvous.h"
+#include "strategy.h"
+#include "logger.h"
 
+// strategies log here; stopped from the start, so each line is printed as soon as it is pushed
+static logger_t *console;
+
+// true walls of a 7x7 room with a walled-off 3x3 island in the middle
+static bool islandWall(int x, int y, int direction) {
+	int nextX = x + deltaX[direction];
+	int nextY = y + deltaY[direction];
+	if (nextX < 0 || nextY < 0 || nextX >= 7 || nextY >= 7) {
+		return true;
+	}
+	bool inside = x >= 2 && x <= 4 && y >= 2 && y <= 4;
+	bool nextInside = nextX >= 2 && nextX <= 4 && nextY >= 2 && nextY <= 4;
+	return inside != nextInside;
+}
+
+// plays a strategy for avatar 0 in the island room until it reaches avatar 1 or gives up, returning the moves made
+static int playIsland(const char *name, int startX, int startY) {
+	maze_t *maze = createMaze(7, 7);
+	avatar_t **avatars = createAvatars(2);
+	int lastTurnID = -1;
+	int moveCount = 0;
+	setPosition(avatars[0], startX, startY);
+	setPosition(avatars[1], 0, 0);
+	const strategy_t *strategy = findStrategy(name);
+	strategyContext_t context = { 0, 2, avatars, maze, NULL, &lastTurnID, console, &moveCount, NULL };
+	strategy->init(&context);
+	while (moveCount < 500) {
+		int move = strategy->chooseMove(&context, NULL);
+		if (move == M_NULL_MOVE) {
+			break;
+		}
+		moveCount++;
+		if (islandWall(avatars[0]->xCoord, avatars[0]->yCoord, move)) {
+			addWall(maze, avatars[0]->xCoord, avatars[0]->yCoord, move);
+			strategy->onMoveResult(&context, move, false);
+		}
+		else {
+			setPosition(avatars[0], avatars[0]->xCoord + (move == M_EAST) - (move == M_WEST), avatars[0]->yCoord + (move == M_SOUTH) - (move == M_NORTH));
+			strategy->onMoveResult(&context, move, true);
+		}
+	}
+	strategy->teardown(&context);
+	bool reached = avatars[0]->xCoord == 0 && avatars[0]->yCoord == 0;
+	deleteAvatars(avatars, 2);
+	mazeDelete(maze);
+	return reached ? moveCount : -1;
+}
 
 int main(int argc, char * argv[]) {
+	console = loggerNew(stdout, AM_MAX_AVATAR);
+	loggerStop(console);
+
 	// Test avatar struct initialization
 	int testID = 0;
 	avatar_t *testAvatar = avatarNew(testID);
@@ -54,48 +108,41 @@ int main(int argc, char * argv[]) {
 	setDirection(testAvatar, testDir);
 	printf("Direction of Avatar %d now %d)\n", testAvatar->avatarID, testAvatar->direction);
 
-	// Test mazeTile struct initialization
-	printf("Initializing tile with position (%d, %d)\n", testX, testY);
-	mazeTile_t *testTile = mazeTileNew(testX, testY);
-	printf("Tile created with position of (%d, %d)\n", testTile->xCoord, testTile->yCoord);
-	
-	// Test mazeTile struct deletion
-	printf("Deleting tile, see myvalgrind for no memory leaks\n");
-	free(testTile);
-
-	// Test TWO-D mazeTile array creation
+	// Test maze wall grid creation
 	int xSize = 2;
 	int ySize = 3;
-	printf("Creating 2-D array of height %d and width %d\n", xSize, ySize);
-	mazeTile_t ***testMaze = createMaze(ySize, xSize);
+	printf("Creating maze of height %d and width %d\n", ySize, xSize);
+	maze_t *testMaze = createMaze(ySize, xSize);
 	if (testMaze != NULL) {
 		for (int i = 0; i < ySize; i++) {
-			if (testMaze[i] != NULL) {
-				for (int j = 0; j < xSize; j++) {
-					if (testMaze[i][j] != NULL) {
-						printf("Tile at (%d, %d) created\n", i, j);
-					}
-				}
+			for (int j = 0; j < xSize; j++) {
+				printf("Tile at (%d, %d) created with wall mask %d\n", j, i, getWalls(testMaze, j, i));
 			}
 		}
 	}
 	
-	// Test TWO-D mazeTile deletion
-	mazeDelete(ySize, xSize, testMaze);	
+	// Test maze deletion
+	mazeDelete(testMaze);	
 	printf("Deleting test maze, see myvalgrind for no memory leaks\n");
 	
-	// Test adding wall to function to mazeTile
+	// Test adding wall to function to maze
 	testMaze = createMaze(ySize, xSize);
-	printf("Maze tile created such that ");
-	if (!testMaze[0][0]->eastWall) {
+	printf("Maze created such that ");
+	if (!hasWall(testMaze, 0, 0, M_EAST)) {
 		printf("east wall does not exist\n");	
 	}
 	int east = 3;
 	addWall(testMaze, 0, 0, east);
-	if (testMaze[0][0]->eastWall) {
-		printf("Now maze tile has east wall\n");
+	if (hasWall(testMaze, 0, 0, M_EAST) && hasWall(testMaze, 1, 0, M_WEST)) {
+		printf("Now maze tile has east wall, shared with its neighbour's west wall\n");
 	}
-	mazeDelete(ySize, xSize, testMaze);
+
+	// Test tri-state edge knowledge
+	printf("Edge south of (0, 0) is %d (unknown = %d)\n", getEdgeState(testMaze, 0, 0, M_SOUTH), EDGE_UNKNOWN);
+	addOpening(testMaze, 0, 0, M_SOUTH);
+	printf("After moving south it is %d (open = %d), seen from below it is %d\n", getEdgeState(testMaze, 0, 0, M_SOUTH), EDGE_OPEN, getEdgeState(testMaze, 0, 1, M_NORTH));
+	printf("Edge east of (0, 0) is %d (wall = %d)\n", getEdgeState(testMaze, 0, 0, M_EAST), EDGE_WALL);
+	mazeDelete(testMaze);
 
 	// TEST STARTUPSTRUCTS
 	testMaze = createMaze(ySize, xSize);
@@ -113,9 +160,9 @@ int main(int argc, char * argv[]) {
 	int height = 2;
 	int width = 3;
 	WINDOW *window = initscr();
-	FILE *log = fopen(logFile, "r");
+	logger_t *log = NULL;
 	int moveCount = 0;
-	startupInfo_t *initStruct = loadStartupStruct(&lock, testID, avatarNum, difficulty, hostname, mazePort, logFile, multipleAvatars, &lastTurnID, testMaze, &solved, height, width, window, log, &moveCount, &lock2);
+	startupInfo_t *initStruct = loadStartupStruct(&lock, testID, avatarNum, difficulty, hostname, NULL, mazePort, logFile, multipleAvatars, &lastTurnID, testMaze, NULL, findStrategy(DEFAULT_STRATEGY), &solved, height, width, window, log, &moveCount, NULL, NULL, NULL);
       	if (initStruct != NULL) {
 		printf("Startup struct initialized\n");
 	}
@@ -140,7 +187,7 @@ int main(int argc, char * argv[]) {
 	setDirection(multipleAvatars[3], 3);
 	setPosition(multipleAvatars[3], 4, 4);
 	setPosition(multipleAvatars[4], 5, 5);
-	mazeDelete(ySize, xSize, testMaze);
+	mazeDelete(testMaze);
 	ySize = 6;
         xSize = 6;
 	testMaze = createMaze(ySize, xSize);
@@ -148,17 +195,17 @@ int main(int argc, char * argv[]) {
 	// Rule with no walls
 	printf("Initially no walls in any tile\n");
 	printf("Given direction %s", parseDirection(multipleAvatars[0]->direction));
-        leftHandRule(multipleAvatars[0], testMaze[1][1], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[0], getWalls(testMaze, 1, 1), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[0]->direction));
 	printf("Given direction %s", parseDirection(multipleAvatars[1]->direction));
-        leftHandRule(multipleAvatars[1], testMaze[2][2], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[1], getWalls(testMaze, 2, 2), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[1]->direction));
 	printf("Given direction %s", parseDirection(multipleAvatars[2]->direction));
-        leftHandRule(multipleAvatars[2], testMaze[3][3], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[2], getWalls(testMaze, 3, 3), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[2]->direction));
 
 	printf("Given direction %s", parseDirection(multipleAvatars[3]->direction));
-        leftHandRule(multipleAvatars[3], testMaze[4][4], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[3], getWalls(testMaze, 4, 4), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[3]->direction));
 	setDirection(multipleAvatars[0], 0);
         printf("%d\n", multipleAvatars[0]->direction);
@@ -178,17 +225,17 @@ int main(int argc, char * argv[]) {
 	// Wall to the west
 	printf("Added walls in direction %s\n", parseDirection(0));
         printf("Given direction %s", parseDirection(multipleAvatars[0]->direction));
-        leftHandRule(multipleAvatars[0], testMaze[1][1], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[0], getWalls(testMaze, 1, 1), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[0]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[1]->direction));
-        leftHandRule(multipleAvatars[1], testMaze[2][2], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[1], getWalls(testMaze, 2, 2), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[1]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[2]->direction));
-        leftHandRule(multipleAvatars[2], testMaze[3][3], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[2], getWalls(testMaze, 3, 3), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[2]->direction));
 
         printf("Given direction %s", parseDirection(multipleAvatars[3]->direction));
-        leftHandRule(multipleAvatars[3], testMaze[4][4], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[3], getWalls(testMaze, 4, 4), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[3]->direction));
 	setDirection(multipleAvatars[0], 0);
         printf("%d\n", multipleAvatars[0]->direction);
@@ -208,17 +255,17 @@ int main(int argc, char * argv[]) {
 	// Wall to the north
 	printf("Added walls in direction %s\n", parseDirection(1));
         printf("Given direction %s", parseDirection(multipleAvatars[0]->direction));
-        leftHandRule(multipleAvatars[0], testMaze[1][1], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[0], getWalls(testMaze, 1, 1), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[0]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[1]->direction));
-        leftHandRule(multipleAvatars[1], testMaze[2][2], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[1], getWalls(testMaze, 2, 2), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[1]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[2]->direction));
-        leftHandRule(multipleAvatars[2], testMaze[3][3], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[2], getWalls(testMaze, 3, 3), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[2]->direction));
 
         printf("Given direction %s", parseDirection(multipleAvatars[3]->direction));
-        leftHandRule(multipleAvatars[3], testMaze[4][4], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[3], getWalls(testMaze, 4, 4), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[3]->direction));
 	setDirection(multipleAvatars[0], 0);
         printf("%d\n", multipleAvatars[0]->direction);
@@ -238,17 +285,17 @@ int main(int argc, char * argv[]) {
 	// Wall to the south
 	printf("Added walls in direction %s\n", parseDirection(2));
         printf("Given direction %s", parseDirection(multipleAvatars[0]->direction));
-        leftHandRule(multipleAvatars[0], testMaze[1][1], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[0], getWalls(testMaze, 1, 1), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[0]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[1]->direction));
-        leftHandRule(multipleAvatars[1], testMaze[2][2], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[1], getWalls(testMaze, 2, 2), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[1]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[2]->direction));
-        leftHandRule(multipleAvatars[2], testMaze[3][3], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[2], getWalls(testMaze, 3, 3), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[2]->direction));
 
         printf("Given direction %s", parseDirection(multipleAvatars[3]->direction));
-        leftHandRule(multipleAvatars[3], testMaze[4][4], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[3], getWalls(testMaze, 4, 4), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[3]->direction));
 	setDirection(multipleAvatars[0], 0);
         printf("%d\n", multipleAvatars[0]->direction);
@@ -268,18 +315,89 @@ int main(int argc, char * argv[]) {
 	// Wall to the east
 	printf("Added walls in direction %s\n", parseDirection(3));
         printf("Given direction %s", parseDirection(multipleAvatars[0]->direction));
-        leftHandRule(multipleAvatars[0], testMaze[1][1], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[0], getWalls(testMaze, 1, 1), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[0]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[1]->direction));
-        leftHandRule(multipleAvatars[1], testMaze[2][2], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[1], getWalls(testMaze, 2, 2), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[1]->direction));
         printf("Given direction %s", parseDirection(multipleAvatars[2]->direction));
-        leftHandRule(multipleAvatars[2], testMaze[3][3], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[2], getWalls(testMaze, 3, 3), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[2]->direction));
 
         printf("Given direction %s", parseDirection(multipleAvatars[3]->direction));
-        leftHandRule(multipleAvatars[3], testMaze[4][4], &lastTurnID, avatarNum, multipleAvatars);
+        leftHandRule(multipleAvatars[3], getWalls(testMaze, 4, 4), &lastTurnID, avatarNum, multipleAvatars);
         printf(", the rule returns %s\n", parseDirection(multipleAvatars[3]->direction));
-}
-	
 
+	// Test rendezvous: avatars on the diagonal from (1, 1) to (5, 5) meet in the middle
+	mazeDelete(testMaze);
+	testMaze = createMaze(ySize, xSize);
+	rendezvous_t *rendezvous = rendezvousNew(testMaze, RENDEZVOUS_MINMAX);
+	XYPos positions[AM_MAX_AVATAR];
+	for (int k = 0; k < avatarNum; k++) {
+		positions[k].x = htonl(multipleAvatars[k]->xCoord);
+		positions[k].y = htonl(multipleAvatars[k]->yCoord);
+	}
+	int meetX, meetY;
+	rendezvousUpdate(rendezvous, positions, avatarNum);
+	rendezvousTarget(rendezvous, &meetX, &meetY);
+	printf("Avatars from (1, 1) to (5, 5) meet at (%d, %d), at most %d steps away\n", meetX, meetY, rendezvousCost(rendezvous));
+
+	// A wall that only lengthens one route a little keeps the target where it is
+	addWall(testMaze, 3, 3, M_NORTH);
+	rendezvousUpdate(rendezvous, positions, avatarNum);
+	rendezvousTarget(rendezvous, &meetX, &meetY);
+	printf("After a wall north of (3, 3) they still meet at (%d, %d) after %d retargets\n", meetX, meetY, rendezvousRetargets(rendezvous));
+
+	// Test shortest path rule: avatar 0 at (1, 1) heads for the rendezvous
+	mazeDelete(testMaze);
+	testMaze = createMaze(ySize, xSize);
+	rendezvousDelete(rendezvous);
+	rendezvous = rendezvousNew(testMaze, RENDEZVOUS_MINMAX);
+	rendezvousUpdate(rendezvous, positions, avatarNum);
+	planner_t *planner = plannerNew(testMaze, PLANNER_BFS);
+	setPosition(multipleAvatars[0], 1, 1);
+	printf("With no walls the planner moves %s", parseDirection(shortestPathRule(multipleAvatars[0], planner, rendezvous, &lastTurnID)));
+	printf(", then %s\n", parseDirection(shortestPathRule(multipleAvatars[0], planner, rendezvous, &lastTurnID)));
+
+	// A wall on the path forces a replan instead of a wasted move
+	setPosition(multipleAvatars[0], 1, 1);
+	addWall(testMaze, 1, 1, M_EAST);
+	addWall(testMaze, 1, 1, M_NORTH);
+	addWall(testMaze, 1, 1, M_SOUTH);
+	printf("Walled in on three sides the planner moves %s after %d replans\n", parseDirection(shortestPathRule(multipleAvatars[0], planner, rendezvous, &lastTurnID)), plannerReplans(planner));
+	printf("The avatar on the rendezvous moves %s\n", parseDirection(shortestPathRule(multipleAvatars[2], planner, rendezvous, &lastTurnID)));
+	planner_t *lastPlanner = plannerNew(testMaze, PLANNER_BFS);
+	printf("The last avatar moves %s\n", parseDirection(shortestPathRule(multipleAvatars[4], lastPlanner, rendezvous, &lastTurnID)));
+	plannerDelete(lastPlanner);
+
+	// Test strategy registry
+	printf("Registered strategies:\n");
+	printStrategies(stdout);
+	printf("Looking up 'bogus' gives %s\n", findStrategy("bogus") == NULL ? "NULL" : "a strategy");
+
+	// Test strategy hooks: a blocked lefthand move turns the avatar back to where it faced before
+	const strategy_t *strategy = findStrategy("lefthand");
+	strategyContext_t context = { 1, avatarNum, multipleAvatars, testMaze, rendezvous, &lastTurnID, console, &moveCount, NULL };
+	setPosition(multipleAvatars[1], 2, 2);
+	setDirection(multipleAvatars[1], M_NORTH);
+	strategy->init(&context);
+	int move = strategy->chooseMove(&context, positions);
+	strategy->onMoveResult(&context, move, false);
+	printf("lefthand tries %s and faces %s again after being blocked\n", parseDirection(move), parseDirection(multipleAvatars[1]->direction));
+	strategy->teardown(&context);
+
+	strategy = findStrategy("incremental");
+	strategy->init(&context);
+	move = strategy->chooseMove(&context, positions);
+	printf("incremental moves avatar 1 at (2, 2) %s toward the rendezvous\n", parseDirection(move));
+	strategy->teardown(&context);
+
+	// A wall follower starting next to an island goes round it forever; lefthand notices and falls back to Tremaux
+	printf("lefthand from (1, 2) reaches the goal in %d moves (-1 = never)\n", playIsland("lefthand", 1, 2));
+	printf("tremaux from (1, 2) reaches the goal in %d moves (-1 = never)\n", playIsland("tremaux", 1, 2));
+	rendezvousDelete(rendezvous);
+	plannerDelete(planner);
+	mazeDelete(testMaze);
+	deleteAvatars(multipleAvatars, avatarNum);
+	loggerDelete(console);
+}
@@ -0,0 +1,80 @@
+/*
+ * eventloop.c - 'eventloop' module
+ *
+ * see eventloop.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <unistd.h>	      // close
+#include <errno.h>
+#include <sys/epoll.h>
+#include "amazing.h"
+#include "avatar.h"
+#include "eventloop.h"
+
+/*
+ *	Dispatches each readable socket to its session until all games are over
+ */
+int runEventLoop(avatarSession_t **sessions, int numAvatars) {
+	int epollFd = epoll_create1(0);
+	if (epollFd < 0) {
+		perror("epoll_create1");
+		return 1;
+	}
+
+	// every avatar's socket, registered under its index
+	for (int k = 0; k < numAvatars; k++) {
+		struct epoll_event event = { .events = EPOLLIN, .data.u32 = k };
+		if (epoll_ctl(epollFd, EPOLL_CTL_ADD, avatarSocket(sessions[k]), &event) < 0) {
+			perror("epoll_ctl");
+			close(epollFd);
+			return 1;
+		}
+	}
+
+	// level triggered: a partly read message reports the socket again on the next wait
+	int playing = numAvatars;
+	int status = 0;
+	struct epoll_event events[AM_MAX_AVATAR];
+	while (playing > 0) {
+		int ready = epoll_wait(epollFd, events, AM_MAX_AVATAR, AM_WAIT_TIME * 1000);
+		if (ready < 0 && errno == EINTR) {
+			continue;
+		}
+		if (ready < 0) {
+			perror("epoll_wait");
+			status = 1;
+			break;
+		}
+		if (ready == 0) {
+			fprintf(stderr, "No message from the server for %d seconds\n", AM_WAIT_TIME);
+			status = -1;
+			break;
+		}
+		for (int i = 0; i < ready; i++) {
+			avatarSession_t *session = sessions[events[i].data.u32];
+			if (session != NULL && !avatarReceive(session, false)) {
+				sessions[events[i].data.u32] = NULL;
+				avatarSessionDelete(session);
+				playing--;
+			}
+		}
+	}
+
+	// avatars still in play when the loop gave up
+	for (int k = 0; k < numAvatars; k++) {
+		if (sessions[k] != NULL) {
+			avatarSessionDelete(sessions[k]);
+		}
+	}
+	close(epollFd);
+	if (status < 0) {
+		errno = ETIMEDOUT;
+	}
+	return status;
+}
@@ -0,0 +1,34 @@
+/*
+ * eventloop.h - header file for eventloop module
+ *
+ * This module plays every avatar of a game from a single thread. Play is round-robin, so at any
+ * moment one avatar has something to do while the others wait; instead of a blocked thread per
+ * avatar, all MazePort sockets are watched by one epoll instance and each message is handed to
+ * its avatar's session as soon as it is complete. Chosen with AMStartup's -e flag.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __EVENTLOOP_H
+#define __EVENTLOOP_H
+
+#include "avatar.h"
+
+/**************** functions ****************/
+
+/**************** runEventLoop ****************/
+/*
+ * Function which plays the game to the end from the calling thread.
+ * Sessions are independent, so the sessions of several games can share one loop.
+ *
+ * Input: Sessions connected by avatarConnectAll, one per avatar (the loop deletes them), number of avatars.
+ *
+ * Output: 0 once every avatar's game is over; -1 with errno set to ETIMEDOUT if the server sent
+ * nothing for AM_WAIT_TIME seconds (the sessions are deleted all the same); 1 if epoll failed.
+ *
+ */
+int runEventLoop(avatarSession_t **sessions, int numAvatars);
+
+#endif // __EVENTLOOP_H
@@ -0,0 +1,485 @@
+/*
+ * framebuffer.c - 'framebuffer' module
+ *
+ * see framebuffer.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <curses.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+#include "graphics.h"
+#include "framebuffer.h"
+
+// longest output one cell can need: a cursor move, a colour change and the glyph
+#define CELL_BYTES 32
+
+typedef struct cell {
+	char glyph;
+	unsigned char colour;
+} cell_t;
+
+/*
+ * The whole picture of the maze (the "canvas") is 2 * height + 1 rows by 4 * width + 2 columns at
+ * zoom 1, or one cell per block plus a border zoomed out. Only the part of it from 'originRow' and
+ * 'originCol' on, 'rows' by 'cols', is held: 'frame' is laid out by framebufferDraw(), 'shown' is
+ * what the terminal holds. A row is dirty when a cell of 'frame' was written since the last flush,
+ * so clean rows are not compared.
+ */
+typedef struct framebuffer {
+	int mazeHeight;
+	int mazeWidth;
+	int zoom;
+	int follow;                       // avatar kept in view, -1 for none
+	int canvasRows;
+	int canvasCols;
+	int originRow;
+	int originCol;
+	int rows;
+	int cols;
+	cell_t *frame;
+	cell_t *shown;
+	bool *dirtyRows;
+	int *blockWalls;                  // walls known per block when zoomed out, NULL at zoom 1
+	maze_t *counted;                  // maze blockWalls was counted for
+	maze_t *maze;                     // maze of the last frame, NULL before the first
+	size_t wallCursor;                // walls of the event log already laid out
+	XYPos positions[AM_MAX_AVATAR];
+	int avatarNum;
+	bool whole;                       // lay out the next frame whole
+	bool clear;                       // clear the terminal before the next flush
+	bool colorsReady;                 // curses colour pairs set up
+	char *out;                        // escape sequences of one flush
+	long bytes;
+} framebuffer_t;
+
+// where a tile's wall goes relative to its centre, and how it looks, indexed by direction
+static const int wallRow[M_NUM_DIRECTIONS] = { 0, -1, 1, 0 };
+static const int wallCol[M_NUM_DIRECTIONS] = { -2, 0, 0, 2 };
+static const char wallGlyph[M_NUM_DIRECTIONS] = { '|', '-', '-', '|' };
+
+// SGR sequences of the FRAMEBUFFER_* colours, and the same colours as curses pairs (as in graphics.c)
+static const char *colourCodes[] = { "\x1b[0m", "\x1b[36;40m", "\x1b[37;41m", "\x1b[33;40m" };
+static const short pairColours[][2] = { { -1, -1 }, { COLOR_CYAN, COLOR_BLACK }, { COLOR_WHITE, COLOR_RED }, { COLOR_YELLOW, COLOR_BLACK } };
+
+framebuffer_t *framebufferNew(int mazeHeight, int mazeWidth, int screenRows, int screenCols, int zoom, int follow) {
+	framebuffer_t *fb = calloc(1, sizeof(framebuffer_t));
+	if (fb == NULL) {
+		fprintf(stderr, "Failed to malloc for framebuffer\n");
+		return NULL;
+	}
+	fb->mazeHeight = mazeHeight;
+	fb->mazeWidth = mazeWidth;
+	fb->zoom = zoom < 1 ? 1 : zoom;
+	fb->follow = follow;
+	if (fb->zoom == 1) {
+		// the same picture graphics.c draws: borders on row 0 and 2 * height, columns 1 and 4 * width + 1
+		fb->canvasRows = mazeHeight * 2 + 1;
+		fb->canvasCols = mazeWidth * 4 + 2;
+	} else {
+		fb->canvasRows = (mazeHeight + fb->zoom - 1) / fb->zoom + 2;
+		fb->canvasCols = (mazeWidth + fb->zoom - 1) / fb->zoom + 2;
+	}
+	fb->rows = screenRows > 0 && screenRows < fb->canvasRows ? screenRows : fb->canvasRows;
+	fb->cols = screenCols > 0 && screenCols < fb->canvasCols ? screenCols : fb->canvasCols;
+
+	size_t cells = (size_t)fb->rows * fb->cols;
+	fb->frame = calloc(cells, sizeof(cell_t));
+	fb->shown = calloc(cells, sizeof(cell_t));
+	fb->dirtyRows = calloc(fb->rows, sizeof(bool));
+	fb->out = malloc(cells * CELL_BYTES + CELL_BYTES);
+	if (fb->zoom > 1) {
+		fb->blockWalls = calloc((size_t)(fb->canvasRows - 2) * (fb->canvasCols - 2), sizeof(int));
+	}
+	if (fb->frame == NULL || fb->shown == NULL || fb->dirtyRows == NULL || fb->out == NULL
+			|| (fb->zoom > 1 && fb->blockWalls == NULL)) {
+		fprintf(stderr, "Failed to malloc for framebuffer\n");
+		framebufferDelete(fb);
+		return NULL;
+	}
+	fb->whole = true;
+	fb->clear = true;
+	return fb;
+}
+
+void framebufferDelete(framebuffer_t *fb) {
+	if (fb != NULL) {
+		free(fb->frame);
+		free(fb->shown);
+		free(fb->dirtyRows);
+		free(fb->blockWalls);
+		free(fb->out);
+		free(fb);
+	}
+}
+
+// writes one cell of the canvas, if it is in view
+static void put(framebuffer_t *fb, int canvasRow, int canvasCol, char glyph, unsigned char colour) {
+	int row = canvasRow - fb->originRow;
+	int col = canvasCol - fb->originCol;
+	if (row < 0 || col < 0 || row >= fb->rows || col >= fb->cols) {
+		return;
+	}
+	cell_t *cell = &fb->frame[row * fb->cols + col];
+	if (cell->glyph != glyph || cell->colour != colour) {
+		cell->glyph = glyph;
+		cell->colour = colour;
+		fb->dirtyRows[row] = true;
+	}
+}
+
+// canvas cell of a tile: its centre at zoom 1, its block zoomed out
+static int canvasRow(framebuffer_t *fb, int y) {
+	return fb->zoom == 1 ? convertY(y) : y / fb->zoom + 1;
+}
+
+static int canvasCol(framebuffer_t *fb, int x) {
+	return fb->zoom == 1 ? convertX(x) : x / fb->zoom + 1;
+}
+
+// lays out a wall, unless the outer border already stands there
+static void putWall(framebuffer_t *fb, int x, int y, int direction) {
+	int row = convertY(y) + wallRow[direction];
+	int col = convertX(x) + wallCol[direction];
+	if (row > 0 && row < fb->canvasRows - 1 && col > 1 && col < fb->canvasCols - 1) {
+		put(fb, row, col, wallGlyph[direction], FRAMEBUFFER_WALL);
+	}
+}
+
+// counts the walls known in one block, from its tiles
+static void countBlock(framebuffer_t *fb, maze_t *maze, int bx, int by) {
+	int walls = 0;
+	for (int y = by * fb->zoom; y < (by + 1) * fb->zoom && y < fb->mazeHeight; y++) {
+		for (int x = bx * fb->zoom; x < (bx + 1) * fb->zoom && x < fb->mazeWidth; x++) {
+			for (int mask = getWalls(maze, x, y); mask != 0; mask &= mask - 1) {
+				walls++;
+			}
+		}
+	}
+	fb->blockWalls[by * (fb->canvasCols - 2) + bx] = walls;
+}
+
+// lays out one block: blank until a wall in it is known, then denser as more are
+static void putBlock(framebuffer_t *fb, int bx, int by) {
+	int walls = fb->blockWalls[by * (fb->canvasCols - 2) + bx];
+	int tiles = fb->zoom * fb->zoom;
+	if (walls == 0) {
+		put(fb, by + 1, bx + 1, ' ', FRAMEBUFFER_BLANK);
+	} else {
+		char glyph = walls * 2 <= tiles ? '.' : walls <= tiles * 2 ? ':' : '#';
+		put(fb, by + 1, bx + 1, glyph, FRAMEBUFFER_WALL);
+	}
+}
+
+// lays out every avatar, in order, so the highest ID stays on top as in graphics.c
+static void putAvatars(framebuffer_t *fb, int avatarNum, XYPos *positions) {
+	for (int k = 0; k < avatarNum; k++) {
+		put(fb, canvasRow(fb, positions[k].y), canvasCol(fb, positions[k].x), '0' + k, FRAMEBUFFER_AVATAR);
+		fb->positions[k] = positions[k];
+	}
+	fb->avatarNum = avatarNum;
+}
+
+// keeps the followed avatar out of the outer quarter of the view; true if the view moved
+static bool scrollView(framebuffer_t *fb, int avatarNum, XYPos *positions) {
+	if (fb->follow < 0 || fb->follow >= avatarNum) {
+		return false;
+	}
+	int row = canvasRow(fb, positions[fb->follow].y);
+	int col = canvasCol(fb, positions[fb->follow].x);
+	int originRow = fb->originRow;
+	int originCol = fb->originCol;
+	if (row < originRow + fb->rows / 4 || row >= originRow + fb->rows - fb->rows / 4) {
+		originRow = row - fb->rows / 2;
+	}
+	if (col < originCol + fb->cols / 4 || col >= originCol + fb->cols - fb->cols / 4) {
+		originCol = col - fb->cols / 2;
+	}
+	originRow = originRow < 0 ? 0 : originRow > fb->canvasRows - fb->rows ? fb->canvasRows - fb->rows : originRow;
+	originCol = originCol < 0 ? 0 : originCol > fb->canvasCols - fb->cols ? fb->canvasCols - fb->cols : originCol;
+	bool moved = originRow != fb->originRow || originCol != fb->originCol;
+	fb->originRow = originRow;
+	fb->originCol = originCol;
+	return moved;
+}
+
+// lays out the part of the canvas in view, as redrawMaze() draws it: walls, then avatars, then borders
+static void drawWhole(framebuffer_t *fb, int avatarNum, XYPos *positions, maze_t *maze) {
+	// walls added while this frame is laid out are laid out again with the next one, which is harmless
+	fb->wallCursor = getWallEventCount(maze);
+	for (size_t i = 0; i < (size_t)fb->rows * fb->cols; i++) {
+		fb->frame[i].glyph = ' ';
+		fb->frame[i].colour = FRAMEBUFFER_BLANK;
+	}
+	for (int row = 0; row < fb->rows; row++) {
+		fb->dirtyRows[row] = true;
+	}
+
+	if (fb->zoom == 1) {
+		// the tiles whose centre or walls are in view
+		int firstY = fb->originRow / 2 - 1, lastY = (fb->originRow + fb->rows) / 2;
+		int firstX = fb->originCol / 4 - 1, lastX = (fb->originCol + fb->cols) / 4;
+		for (int y = firstY < 0 ? 0 : firstY; y <= lastY && y < fb->mazeHeight; y++) {
+			for (int x = firstX < 0 ? 0 : firstX; x <= lastX && x < fb->mazeWidth; x++) {
+				int walls = getWalls(maze, x, y);
+				for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+					if (walls & (1 << direction)) {
+						putWall(fb, x, y, direction);
+					}
+				}
+			}
+		}
+		putAvatars(fb, avatarNum, positions);
+		for (int col = 3; col <= fb->mazeWidth * 4; col += 4) {
+			put(fb, 0, col, '*', FRAMEBUFFER_BORDER);
+			put(fb, fb->mazeHeight * 2, col, '*', FRAMEBUFFER_BORDER);
+		}
+		for (int row = 1; row <= fb->mazeHeight * 2; row += 2) {
+			put(fb, row, 1, '*', FRAMEBUFFER_BORDER);
+			put(fb, row, fb->mazeWidth * 4 + 1, '*', FRAMEBUFFER_BORDER);
+		}
+	} else {
+		// a new maze has its blocks counted once; after that the wall event log keeps them up to date
+		int blocksY = fb->canvasRows - 2, blocksX = fb->canvasCols - 2;
+		if (maze != fb->counted) {
+			for (int by = 0; by < blocksY; by++) {
+				for (int bx = 0; bx < blocksX; bx++) {
+					countBlock(fb, maze, bx, by);
+				}
+			}
+			fb->counted = maze;
+		}
+		int firstY = fb->originRow - 1, lastY = fb->originRow + fb->rows - 2;
+		int firstX = fb->originCol - 1, lastX = fb->originCol + fb->cols - 2;
+		for (int by = firstY < 0 ? 0 : firstY; by <= lastY && by < blocksY; by++) {
+			for (int bx = firstX < 0 ? 0 : firstX; bx <= lastX && bx < blocksX; bx++) {
+				putBlock(fb, bx, by);
+			}
+		}
+		putAvatars(fb, avatarNum, positions);
+		for (int col = 0; col < fb->canvasCols; col++) {
+			put(fb, 0, col, '*', FRAMEBUFFER_BORDER);
+			put(fb, fb->canvasRows - 1, col, '*', FRAMEBUFFER_BORDER);
+		}
+		for (int row = 1; row < fb->canvasRows - 1; row++) {
+			put(fb, row, 0, '*', FRAMEBUFFER_BORDER);
+			put(fb, row, fb->canvasCols - 1, '*', FRAMEBUFFER_BORDER);
+		}
+	}
+	fb->maze = maze;
+}
+
+// lays out a wall found since the last frame; zoomed out, recounts the blocks on both sides of it
+static void drawWallEvent(framebuffer_t *fb, maze_t *maze, int x, int y, int direction) {
+	if (fb->zoom == 1) {
+		putWall(fb, x, y, direction);
+		return;
+	}
+	countBlock(fb, maze, x / fb->zoom, y / fb->zoom);
+	putBlock(fb, x / fb->zoom, y / fb->zoom);
+	int nx = x + deltaX[direction], ny = y + deltaY[direction];
+	if (nx >= 0 && ny >= 0 && nx < fb->mazeWidth && ny < fb->mazeHeight) {
+		countBlock(fb, maze, nx / fb->zoom, ny / fb->zoom);
+		putBlock(fb, nx / fb->zoom, ny / fb->zoom);
+	}
+}
+
+void framebufferDraw(framebuffer_t *fb, int avatarNum, XYPos *positions, maze_t *maze) {
+	// a new maze, a different number of avatars or a scrolled view needs the whole frame
+	bool moved = scrollView(fb, avatarNum, positions);
+	if (fb->whole || moved || maze != fb->maze || avatarNum != fb->avatarNum) {
+		drawWhole(fb, avatarNum, positions, maze);
+		fb->whole = false;
+		return;
+	}
+
+	// walls found since the last frame, straight from the maze's event log
+	int x, y, direction;
+	while (nextWallEvent(maze, &fb->wallCursor, &x, &y, &direction)) {
+		drawWallEvent(fb, maze, x, y, direction);
+	}
+
+	// clear the tiles avatars stood on, then lay them out where they are now
+	for (int k = 0; k < fb->avatarNum; k++) {
+		if (fb->zoom == 1) {
+			put(fb, convertY(fb->positions[k].y), convertX(fb->positions[k].x), ' ', FRAMEBUFFER_BLANK);
+		} else {
+			putBlock(fb, fb->positions[k].x / fb->zoom, fb->positions[k].y / fb->zoom);
+		}
+	}
+	putAvatars(fb, avatarNum, positions);
+}
+
+void framebufferRedraw(framebuffer_t *fb) {
+	fb->whole = true;
+	fb->clear = true;
+}
+
+// appends a string to the output
+static size_t append(char *out, size_t at, const char *text) {
+	size_t length = strlen(text);
+	memcpy(out + at, text, length);
+	return at + length;
+}
+
+// appends a non-negative number in decimal to the output
+static size_t appendNumber(char *out, size_t at, int number) {
+	char digits[12];
+	int count = 0;
+	do {
+		digits[count++] = '0' + number % 10;
+		number /= 10;
+	} while (number > 0);
+	while (count > 0) {
+		out[at++] = digits[--count];
+	}
+	return at;
+}
+
+// writes the whole output, however many calls it takes
+static bool writeAll(int fd, const char *out, size_t length) {
+	while (length > 0) {
+		ssize_t written = write(fd, out, length);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		out += written;
+		length -= written;
+	}
+	return true;
+}
+
+int framebufferFlush(framebuffer_t *fb, int fd) {
+	size_t at = 0;
+	int curRow = -1;                  // where the terminal's cursor is, -1 if not known
+	int curCol = -1;
+	int curColour = -1;               // the terminal's colour, -1 if not known
+
+	// a cleared terminal is blank in the default colour, with the cursor hidden
+	if (fb->clear) {
+		at = append(fb->out, at, "\x1b[?25l\x1b[0m\x1b[2J");
+		for (size_t i = 0; i < (size_t)fb->rows * fb->cols; i++) {
+			fb->shown[i].glyph = ' ';
+			fb->shown[i].colour = FRAMEBUFFER_BLANK;
+		}
+		curColour = FRAMEBUFFER_BLANK;
+		fb->clear = false;
+	}
+
+	// send the cells that differ from the terminal, moving the cursor only over gaps
+	int cells = 0;
+	for (int row = 0; row < fb->rows; row++) {
+		if (!fb->dirtyRows[row]) {
+			continue;
+		}
+		fb->dirtyRows[row] = false;
+		cell_t *frame = &fb->frame[row * fb->cols];
+		cell_t *shown = &fb->shown[row * fb->cols];
+		for (int col = 0; col < fb->cols; col++) {
+			if (frame[col].glyph == shown[col].glyph && frame[col].colour == shown[col].colour) {
+				continue;
+			}
+			if (row != curRow || col != curCol) {
+				at = append(fb->out, at, "\x1b[");
+				at = appendNumber(fb->out, at, row + 1);
+				fb->out[at++] = ';';
+				at = appendNumber(fb->out, at, col + 1);
+				fb->out[at++] = 'H';
+			}
+			if (frame[col].colour != curColour) {
+				at = append(fb->out, at, colourCodes[frame[col].colour]);
+				curColour = frame[col].colour;
+			}
+			fb->out[at++] = frame[col].glyph;
+			shown[col] = frame[col];
+			curRow = row;
+			curCol = col + 1;
+			cells++;
+		}
+	}
+
+	// leave the terminal in its default colour between frames
+	if (curColour != FRAMEBUFFER_BLANK && curColour != -1) {
+		at = append(fb->out, at, colourCodes[FRAMEBUFFER_BLANK]);
+	}
+	if (at > 0 && !writeAll(fd, fb->out, at)) {
+		return -1;
+	}
+	fb->bytes += at;
+	return cells;
+}
+
+int framebufferFlushCurses(framebuffer_t *fb) {
+	if (!fb->colorsReady) {
+		for (int colour = FRAMEBUFFER_BORDER; colour <= FRAMEBUFFER_WALL; colour++) {
+			init_pair(colour, pairColours[colour][0], pairColours[colour][1]);
+		}
+		fb->colorsReady = true;
+	}
+	if (fb->clear) {
+		erase();
+		for (size_t i = 0; i < (size_t)fb->rows * fb->cols; i++) {
+			fb->shown[i].glyph = ' ';
+			fb->shown[i].colour = FRAMEBUFFER_BLANK;
+		}
+		fb->clear = false;
+	}
+
+	int cells = 0;
+	for (int row = 0; row < fb->rows; row++) {
+		if (!fb->dirtyRows[row]) {
+			continue;
+		}
+		fb->dirtyRows[row] = false;
+		cell_t *frame = &fb->frame[row * fb->cols];
+		cell_t *shown = &fb->shown[row * fb->cols];
+		for (int col = 0; col < fb->cols; col++) {
+			if (frame[col].glyph != shown[col].glyph || frame[col].colour != shown[col].colour) {
+				mvaddch(row, col, frame[col].glyph | COLOR_PAIR(frame[col].colour));
+				shown[col] = frame[col];
+				cells++;
+			}
+		}
+	}
+	refresh();
+	return cells;
+}
+
+void framebufferClose(framebuffer_t *fb, int fd) {
+	size_t at = append(fb->out, 0, colourCodes[FRAMEBUFFER_BLANK]);
+	at = append(fb->out, at, "\x1b[");
+	at = appendNumber(fb->out, at, fb->rows + 1);
+	at = append(fb->out, at, ";1H\x1b[?25h");
+	if (writeAll(fd, fb->out, at)) {
+		fb->bytes += at;
+	}
+}
+
+bool framebufferCell(framebuffer_t *fb, int row, int col, char *glyph, int *colour) {
+	if (row < 0 || col < 0 || row >= fb->rows || col >= fb->cols) {
+		return false;
+	}
+	*glyph = fb->frame[row * fb->cols + col].glyph;
+	*colour = fb->frame[row * fb->cols + col].colour;
+	return true;
+}
+
+void framebufferOrigin(framebuffer_t *fb, int *row, int *col) {
+	*row = fb->originRow;
+	*col = fb->originCol;
+}
+
+long framebufferBytes(framebuffer_t *fb) {
+	return fb->bytes;
+}
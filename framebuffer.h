@@ -0,0 +1,164 @@
+/*
+ * framebuffer.h - header file for framebuffer module
+ *
+ * This module draws the maze into memory, one glyph and one colour per screen cell, on the same
+ * grid graphics.c draws on (convertX/convertY). Flushing compares it with what the terminal
+ * already shows and sends only the cells that differ: as ANSI escape sequences in a single
+ * write(), or through curses.
+ *
+ * A maze too big for the screen is seen through a viewport the size of the screen, which can
+ * follow an avatar, and can be zoomed out so that each character stands for a square block of
+ * tiles. Only the tiles in view are ever drawn, so a frame costs the same for any size of maze.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __FRAMEBUFFER_H
+#define __FRAMEBUFFER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+
+/**************** constants ****************/
+
+/*
+ * Colours of a cell, numbered like the curses colour pairs graphics.c draws with.
+ */
+#define FRAMEBUFFER_BLANK 0       // terminal default
+#define FRAMEBUFFER_BORDER 1      // cyan on black
+#define FRAMEBUFFER_AVATAR 2      // white on red
+#define FRAMEBUFFER_WALL 3        // yellow on black
+
+/**************** structs ****************/
+
+/**************** framebuffer ****************/
+/*
+ * The frame being laid out and the one on the terminal. See framebuffer.c for details.
+ */
+typedef struct framebuffer framebuffer_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** framebufferNew ****************/
+/*
+ * Function which creates an empty framebuffer for a maze. The terminal is assumed to be blank;
+ * the first flush clears it anyway.
+ *
+ * Input: Maze height and width in tiles; rows and columns of the screen (0 for as many as the maze
+ * needs); zoom, 1 to draw every tile as graphics.c does, or n > 1 to draw each n x n block of tiles
+ * as one character; ID of the avatar the view follows, or -1 to keep the top left corner in view.
+ *
+ * Output: The framebuffer, or NULL if memory could not be allocated.
+ *
+ */
+framebuffer_t *framebufferNew(int mazeHeight, int mazeWidth, int screenRows, int screenCols, int zoom, int follow);
+
+/**************** framebufferDelete ****************/
+/*
+ * Input: Framebuffer, or NULL.
+ *
+ * Output: None.
+ *
+ */
+void framebufferDelete(framebuffer_t *fb);
+
+/**************** framebufferDraw ****************/
+/*
+ * Function which lays out the next frame. The first frame, the first after framebufferRedraw() and
+ * any frame in which the view scrolls to keep the followed avatar away from its edges are laid out
+ * whole, the part in view only; other frames only add the walls found since (from the maze's wall
+ * event log) and move the avatars. Nothing is written to the terminal.
+ *
+ * Zoomed out, a block is blank while none of its walls are known, and shows '.', ':' or '#' as
+ * more of them are found; a block with an avatar in it shows the highest such ID.
+ *
+ * Input: Framebuffer, number of avatars, their positions (host byte order), maze.
+ *
+ * Output: None.
+ *
+ */
+void framebufferDraw(framebuffer_t *fb, int avatarNum, XYPos *positions, maze_t *maze);
+
+/**************** framebufferFlush ****************/
+/*
+ * Function which writes every cell that differs from the terminal, with as few cursor moves and
+ * colour changes as it can, in one write(). After framebufferRedraw() the terminal is cleared first.
+ *
+ * Input: Framebuffer, file descriptor of the terminal.
+ *
+ * Output: Number of cells written, or -1 if the write failed.
+ *
+ */
+int framebufferFlush(framebuffer_t *fb, int fd);
+
+/**************** framebufferFlushCurses ****************/
+/*
+ * Function which draws every cell that differs from the screen with curses, in the colour pairs
+ * graphics.c uses, then refreshes. The caller has started curses and colour.
+ *
+ * Input: Framebuffer.
+ *
+ * Output: Number of cells drawn.
+ *
+ */
+int framebufferFlushCurses(framebuffer_t *fb);
+
+/**************** framebufferRedraw ****************/
+/*
+ * Function which makes the next frame be laid out whole and sent whole, e.g. after the screen was disturbed.
+ *
+ * Input: Framebuffer.
+ *
+ * Output: None.
+ *
+ */
+void framebufferRedraw(framebuffer_t *fb);
+
+/**************** framebufferClose ****************/
+/*
+ * Function which gives the terminal back: resets colours, shows the cursor and moves it below the maze.
+ *
+ * Input: Framebuffer, file descriptor of the terminal.
+ *
+ * Output: None.
+ *
+ */
+void framebufferClose(framebuffer_t *fb, int fd);
+
+/**************** framebufferCell ****************/
+/*
+ * Function which reads one cell of the frame laid out last.
+ *
+ * Input: Framebuffer, screen row and column, where to put the glyph and the colour (FRAMEBUFFER_*).
+ *
+ * Output: false if the cell is off the screen.
+ *
+ */
+bool framebufferCell(framebuffer_t *fb, int row, int col, char *glyph, int *colour);
+
+/**************** framebufferOrigin ****************/
+/*
+ * Function which tells where the view is. At zoom 1 the whole picture is laid out as graphics.c
+ * draws it; zoomed out, the border is row and column 0 and block (bx, by) is at row by + 1, column bx + 1.
+ *
+ * Input: Framebuffer, where to put the row and column of the whole picture shown in the screen's top left cell.
+ *
+ * Output: None.
+ *
+ */
+void framebufferOrigin(framebuffer_t *fb, int *row, int *col);
+
+/**************** framebufferBytes ****************/
+/*
+ * Input: Framebuffer.
+ *
+ * Output: Bytes written to the terminal so far.
+ *
+ */
+long framebufferBytes(framebuffer_t *fb);
+
+#endif // __FRAMEBUFFER_H
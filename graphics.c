@@ -16,33 +16,116 @@
 #include <stdbool.h>
 #include <unistd.h>
 
+// what is on the screen, so the next frame only has to draw what changed
+static maze_t *drawnMaze = NULL;          // maze of the last frame, NULL before the first
+static size_t wallCursor = 0;             // walls of the event log already on the screen
+static XYPos drawnPositions[AM_MAX_AVATAR];
+static int drawnCount = 0;
+static bool colorsReady = false;
+
+// wall names drawWall takes, indexed by direction
+static char *directionNames[M_NUM_DIRECTIONS] = { "west", "north", "south", "east" };
+
+// creating colored pairs, once
+static void initColors(void) {
+	if (!colorsReady) {
+		// outer boundaries are cyan
+		init_pair(1,COLOR_CYAN,COLOR_BLACK);
+		// avatar colors are white
+		init_pair(2,COLOR_WHITE,COLOR_RED);
+		// walls are yellow
+		init_pair(3,COLOR_YELLOW,COLOR_BLACK);
+		colorsReady = true;
+	}
+}
+
+// draws every avatar whose tile is among the dirty ones, in order, so the highest ID stays on top as in a full frame
+static void drawAvatarsOn(int avatarNum, XYPos *positions, XYPos *dirty, int dirtyCount) {
+	for (int k = 0; k < avatarNum; k++) {
+		for (int d = 0; d < dirtyCount; d++) {
+			if (positions[k].x == dirty[d].x && positions[k].y == dirty[d].y) {
+				// draw the avatar at their corresponding positions, in corresponding color pair
+				attron(COLOR_PAIR(2));
+				drawAvatar(k, positions[k].x, positions[k].y);
+				attroff(COLOR_PAIR(2));
+				break;
+			}
+		}
+	}
+}
+
+// function that draws only what changed since the last frame
+int drawMaze(int avatarNum, XYPos *positions, maze_t *maze){
+
+	// a new maze or a different number of avatars needs the whole screen
+	if (maze != drawnMaze || avatarNum != drawnCount) {
+		return redrawMaze(avatarNum, positions, maze);
+	}
+	initColors();
+	int cells = 0;
+
+	// walls found since the last frame, straight from the maze's event log
+	int x, y, direction;
+	attron(COLOR_PAIR(3));
+	while (nextWallEvent(maze, &wallCursor, &x, &y, &direction)) {
+		drawWall(x, y, directionNames[direction]);
+		cells++;
+	}
+	attroff(COLOR_PAIR(3));
+
+	// the tiles avatars left or entered: clear them, then draw whoever stands on them now
+	XYPos dirty[2 * AM_MAX_AVATAR];
+	int dirtyCount = 0;
+	for (int k = 0; k < avatarNum; k++) {
+		if (positions[k].x != drawnPositions[k].x || positions[k].y != drawnPositions[k].y) {
+			dirty[dirtyCount++] = drawnPositions[k];
+			dirty[dirtyCount++] = positions[k];
+			drawnPositions[k] = positions[k];
+		}
+	}
+	for (int d = 0; d < dirtyCount; d++) {
+		mvaddstr(convertY(dirty[d].y), convertX(dirty[d].x), " ");
+	}
+	drawAvatarsOn(avatarNum, positions, dirty, dirtyCount);
+	cells += dirtyCount;
+
+	// calling refresh to draw over last frame (thus creating the animation)
+	refresh();
+	return cells;
+}
+
 // function that draws the entire maze, calling upon all the sublevel draw functions
-void drawMaze(int mazeHeight, int mazeWidth, int avatarNum, avatar_t **avatars, mazeTile_t ***maze){
-
-	// creating colored pairs
-	// outer boundaries are cyan
-	init_pair(1,COLOR_CYAN,COLOR_BLACK);
-	// avatar colors are white
-	init_pair(2,COLOR_WHITE,COLOR_RED);
-	// walls are yellow
-	init_pair(3,COLOR_YELLOW,COLOR_BLACK);
+int redrawMaze(int avatarNum, XYPos *positions, maze_t *maze){
+
+	int mazeHeight = getMazeHeight(maze);
+	int mazeWidth = getMazeWidth(maze);
+	initColors();
+
+	// walls added while this frame is drawn are drawn again with the next one, which is harmless
+	wallCursor = getWallEventCount(maze);
+	erase();
+
 	// iterate over the maze 
 	for (int i = 0; i <  mazeHeight; i++){
 		for (int j = 0; j < mazeWidth; j++){
 			// draw the tile one at a time, in corresponding color pair
 			attron(COLOR_PAIR(3));
-			drawMazeTile(maze[i][j]);
+			drawMazeTile(maze, j, i);
 			attroff(COLOR_PAIR(3));
 		}
 	}
 
-	// for every single avatar in the avatar array
+	// for every single avatar in the position array
 	for (int k = 0; k < avatarNum; k++) {
 		// draw the avatar at their corresponding positions, in corresponding color pair
 		attron(COLOR_PAIR(2));
-		drawAvatar(avatars[k]->avatarID, avatars[k]->xCoord, avatars[k]->yCoord);
+		drawAvatar(k, positions[k].x, positions[k].y);
 		attroff(COLOR_PAIR(2));
+		drawnPositions[k] = positions[k];
 	}
+	drawnCount = avatarNum;
+	drawnMaze = maze;
+
 	// draw the outer borders, in corresponding color pair
 	attron(COLOR_PAIR(1));
 	drawOuterBorders(mazeHeight, mazeWidth);
@@ -50,43 +133,38 @@ void drawMaze(int mazeHeight, int mazeWidth, int avatarNum, avatar_t **avatars,
 
 	// calling refresh to draw over last frame (thus creating the animation)
 	refresh();
-	// nap for 10 milliseconds
-	napms(15);
-
-	// for every avatar, clear the previous spot it was on
-	for (int k = 0; k < avatarNum; k++) {
-		mvaddstr(convertY(avatars[k]->yCoord), convertX(avatars[k]->xCoord), " ");	
-	}
-	refresh();
-
+	return mazeHeight * mazeWidth + avatarNum;
 }
 
 
 /*
- * This function draws the maze, taking in a mazeTile struct as a parameter
+ * This function draws one tile of the maze, taking in the maze and the tile's coordinates as parameters
  * It will call upon the other helper functions which are included in this file. 
  */
 
-void drawMazeTile(mazeTile_t *mazeTile) {
+void drawMazeTile(maze_t *maze, int x, int y) {
+
+	// look up all four walls of the tile at once
+	int walls = getWalls(maze, x, y);
 
-	// if the north wall of the maze tile struct is true, draw a wall in the corresponding direction
-	if (mazeTile->northWall) {
-		drawWall(mazeTile->xCoord, mazeTile->yCoord, "north");
+	// if the tile has a north wall, draw a wall in the corresponding direction
+	if (walls & WALL_NORTH) {
+		drawWall(x, y, "north");
 	}
 
-	// if the south wall of the maze tile struct is true, draw a wall in the corresponding direction
-	if (mazeTile->southWall) {
-		drawWall(mazeTile->xCoord, mazeTile->yCoord, "south");
+	// if the tile has a south wall, draw a wall in the corresponding direction
+	if (walls & WALL_SOUTH) {
+		drawWall(x, y, "south");
 	}
 
-	// if the east wall of the maze tile struct is true, draw a wall in the corresponding direction
-	if (mazeTile->eastWall) {
-		drawWall(mazeTile->xCoord, mazeTile->yCoord, "east");
+	// if the tile has an east wall, draw a wall in the corresponding direction
+	if (walls & WALL_EAST) {
+		drawWall(x, y, "east");
 	}
 
-	// if the west wall of the maze tile struct is true, draw a wall in the corresponding direction
-	if (mazeTile->westWall) {
-		drawWall(mazeTile->xCoord, mazeTile->yCoord, "west");
+	// if the tile has a west wall, draw a wall in the corresponding direction
+	if (walls & WALL_WEST) {
+		drawWall(x, y, "west");
 	}
 }
 
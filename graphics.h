@@ -19,25 +19,41 @@
 
 /**************** draw_maze ****************/
 /*
- * Function that draws the entire maze (excluding avatars), calling upon all the sublevel draw functions
+ * Function that draws one frame, touching only what changed since the last one: the walls added
+ * to the maze's wall event log since then, and the tiles avatars left or entered. The first frame
+ * of a maze is drawn whole by redrawMaze(). The module remembers what is on the screen, so all
+ * frames must be drawn by one thread. Returns straight away; how often it is called sets the
+ * frame rate (see render.h).
  *
- * Input: Maze dimensions, number of avatars, list of avatars, maze.
+ * Input: Number of avatars, their positions (avatar k at positions[k], host byte order), maze.
  *
- * Output: a visualized maze via the curses library.
+ * Output: a visualized maze via the curses library. Returns the number of walls and tiles drawn.
  *
  */
-void drawMaze(int mazeHeight, int mazeWidth, int avatarNum, avatar_t **avatars, mazeTile_t ***maze);
+int drawMaze(int avatarNum, XYPos *positions, maze_t *maze);
+
+/**************** redraw_maze ****************/
+/*
+ * Function that clears the screen and draws the entire maze, the avatars and the outer borders,
+ * calling upon all the sublevel draw functions. Later drawMaze() frames carry on from here.
+ *
+ * Input: Number of avatars, their positions (host byte order), maze.
+ *
+ * Output: a visualized maze via the curses library. Returns the number of tiles and avatars drawn.
+ *
+ */
+int redrawMaze(int avatarNum, XYPos *positions, maze_t *maze);
 
 /**************** drawMazeTile ****************/
 /*
  * Function that draws an individual maze tile.
  *
- * Input: mazeTile struct representing a single coordinate on the maze.
+ * Input: Maze, coordinate pair of the tile.
  *
- * Output: a visualized mazeTile via the curses library.
+ * Output: a visualized maze tile via the curses library.
  *
  */
-void drawMazeTile(mazeTile_t *mazeTile);
+void drawMazeTile(maze_t *maze, int x, int y);
 
 /**************** draw_outer_borders ****************/
 /*
@@ -1,19 +1,313 @@
  /* 
  * graphicstest.c, a testing module that evaluates the functionality of functions in graphics.c and mazeSolver.c, and avatar.c
+ * A random walk drawn frame by frame, touching only what changed, must leave the same screen as
+ * drawing the final state whole. It then hands turns to the render thread in render.c, which must draw at most RENDER_FPS frames a second
+ * however fast turns are published, and must draw the last one before it stops. Last, a walk on a
+ * 100x100 maze is drawn both by curses and by the ANSI framebuffer in framebuffer.c; the curses
+ * screen, the framebuffer and the terminal its output describes must agree, and both are timed.
+ * Then an avatar crosses mazes too big for a 24x80 screen, with the view following it, at full
+ * size and zoomed out: it must never leave the view, the view must match the same part of the
+ * whole picture, and a whole frame must cost about the same however big the maze.
  *
  * Written by:
  * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
  */
 
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+
 #include "graphics.h"
 #include "mazeSolver.h"
+#include "render.h"
+#include "framebuffer.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <stdbool.h>
+#include <string.h>	      // memcmp
 #include <curses.h>
 #include <ctype.h>
 #include <unistd.h>
+#include <time.h>
+#include <netdb.h>	      // htonl
 #include "avatar.h"
 
+#define PUBLISH_SECONDS 0.5
+#define WALK_STEPS 500
+#define BIG_SIZE 100
+#define BIG_WALLS 4000
+#define BIG_FRAMES 300
+#define VIEW_ROWS 24
+#define VIEW_COLS 80
+#define HUGE_SIZE 500
+#define VIEW_REPEATS 50
+
+// draws the avatars where their structs say they are; returns the walls and tiles drawn
+static int drawAvatars(int numAv, avatar_t **avatars, maze_t *maze) {
+	XYPos positions[AM_MAX_AVATAR];
+	for (int k = 0; k < numAv; k++) {
+		positions[k].x = avatars[k]->xCoord;
+		positions[k].y = avatars[k]->yCoord;
+	}
+	return drawMaze(numAv, positions, maze);
+}
+
+// copies the characters of the maze's part of the screen
+static void readScreen(char *screen, int height, int width) {
+	for (int row = 0; row <= height * 2; row++) {
+		for (int col = 0; col <= width * 4 + 1; col++) {
+			*screen++ = mvinch(row, col) & A_CHARTEXT;
+		}
+	}
+}
+
+// walks the avatars around at random, finding walls as they go, drawing each step as it changes
+static bool walkMatchesRedraw(int numAv, avatar_t **avatars, int height, int width, double *cellsPerFrame, int *wholeCells) {
+	maze_t *maze = createMaze(height, width);
+	unsigned int seed = 11;
+	long cells = 0;
+	drawAvatars(numAv, avatars, maze);
+	for (int step = 0; step < WALK_STEPS; step++) {
+		avatar_t *avatar = avatars[rand_r(&seed) % numAv];
+		int direction = rand_r(&seed) % M_NUM_DIRECTIONS;
+		int x = avatar->xCoord + deltaX[direction];
+		int y = avatar->yCoord + deltaY[direction];
+		if (rand_r(&seed) % 3 == 0) {
+			addWall(maze, avatar->xCoord, avatar->yCoord, direction);
+		} else if (x >= 0 && y >= 0 && x < width && y < height) {
+			setPosition(avatar, x, y);
+		}
+		cells += drawAvatars(numAv, avatars, maze);
+	}
+
+	// the same state drawn whole must look the same
+	size_t size = (height * 2 + 1) * (width * 4 + 2);
+	char *incremental = malloc(size);
+	char *whole = malloc(size);
+	readScreen(incremental, height, width);
+	XYPos positions[AM_MAX_AVATAR];
+	for (int k = 0; k < numAv; k++) {
+		positions[k].x = avatars[k]->xCoord;
+		positions[k].y = avatars[k]->yCoord;
+	}
+	*wholeCells = redrawMaze(numAv, positions, maze);
+	*cellsPerFrame = (double)cells / WALK_STEPS;
+	readScreen(whole, height, width);
+	bool same = memcmp(incremental, whole, size) == 0;
+	free(incremental);
+	free(whole);
+	mazeDelete(maze);
+	return same;
+}
+
+// seconds on the monotonic clock
+static double now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// plays ANSI output onto a blank screen of glyphs and colours, as a terminal would
+static void replayAnsi(FILE *fp, char *glyphs, int *colours, int rows, int cols) {
+	int row = 0, col = 0, colour = FRAMEBUFFER_BLANK;
+	int c;
+	rewind(fp);
+	while ((c = getc(fp)) != EOF) {
+		if (c != '\x1b') {
+			if (row < rows && col < cols) {
+				glyphs[row * cols + col] = c;
+				colours[row * cols + col] = colour;
+			}
+			col++;
+			continue;
+		}
+		// ESC [ parameters final
+		int params[2] = { 0, 0 }, count = 0;
+		getc(fp);
+		while ((c = getc(fp)) != EOF && (c == ';' || c == '?' || (c >= '0' && c <= '9'))) {
+			if (c == ';') {
+				count++;
+			} else if (c != '?' && count < 2) {
+				params[count] = params[count] * 10 + c - '0';
+			}
+		}
+		if (c == 'H') {
+			row = params[0] - 1;
+			col = params[1] - 1;
+		} else if (c == 'J') {
+			for (int i = 0; i < rows * cols; i++) {
+				glyphs[i] = ' ';
+				colours[i] = FRAMEBUFFER_BLANK;
+			}
+		} else if (c == 'm') {
+			colour = params[0] == 36 ? FRAMEBUFFER_BORDER : params[0] == 37 ? FRAMEBUFFER_AVATAR
+					: params[0] == 33 ? FRAMEBUFFER_WALL : FRAMEBUFFER_BLANK;
+		}
+	}
+}
+
+/*
+ * Walks avatars over a 100x100 maze, drawing every step with curses (into a terminal that writes to
+ * /dev/null, sized to fit the maze) and with the framebuffer (into a temporary file). The curses
+ * screen, the framebuffer and what the framebuffer's output puts on a terminal must agree.
+ */
+static bool ansiMatchesCurses(int numAv, double *cursesMicros, double *ansiMicros, double *cursesWholeMicros,
+		double *ansiWholeMicros, double *bytesPerFrame) {
+	int rows = BIG_SIZE * 2 + 1;
+	int cols = BIG_SIZE * 4 + 2;
+	FILE *sink = fopen("/dev/null", "w");
+	FILE *output = tmpfile();
+	SCREEN *screen = sink == NULL ? NULL : newterm(NULL, sink, stdin);
+	maze_t *maze = createMaze(BIG_SIZE, BIG_SIZE);
+	framebuffer_t *fb = framebufferNew(BIG_SIZE, BIG_SIZE, 0, 0, 1, -1);
+	char *glyphs = malloc(rows * cols);
+	int *colours = malloc(rows * cols * sizeof(int));
+	if (screen == NULL || output == NULL || fb == NULL || glyphs == NULL || colours == NULL) {
+		return false;
+	}
+	resizeterm(rows, cols);
+
+	// a maze with walls already found, and avatars spread over it
+	unsigned int seed = 5;
+	for (int i = 0; i < BIG_WALLS; i++) {
+		addWall(maze, rand_r(&seed) % BIG_SIZE, rand_r(&seed) % BIG_SIZE, rand_r(&seed) % M_NUM_DIRECTIONS);
+	}
+	XYPos positions[AM_MAX_AVATAR];
+	for (int k = 0; k < numAv; k++) {
+		positions[k].x = k * 20;
+		positions[k].y = k * 20;
+	}
+
+	// the first frame of each is whole; every frame after, one avatar steps or finds a wall
+	double cursesSeconds = 0, ansiSeconds = 0;
+	for (int frame = 0; frame < BIG_FRAMES; frame++) {
+		if (frame > 0) {
+			XYPos *avatar = &positions[rand_r(&seed) % numAv];
+			int direction = rand_r(&seed) % M_NUM_DIRECTIONS;
+			int x = avatar->x + deltaX[direction];
+			int y = avatar->y + deltaY[direction];
+			if (rand_r(&seed) % 3 == 0) {
+				addWall(maze, avatar->x, avatar->y, direction);
+			} else if (x >= 0 && y >= 0 && x < BIG_SIZE && y < BIG_SIZE) {
+				avatar->x = x;
+				avatar->y = y;
+			}
+		}
+		double start = now();
+		drawMaze(numAv, positions, maze);
+		double middle = now();
+		framebufferDraw(fb, numAv, positions, maze);
+		framebufferFlush(fb, fileno(output));
+		double end = now();
+		if (frame == 0) {
+			*cursesWholeMicros = (middle - start) * 1e6;
+			*ansiWholeMicros = (end - middle) * 1e6;
+		} else {
+			cursesSeconds += middle - start;
+			ansiSeconds += end - middle;
+		}
+	}
+	*cursesMicros = cursesSeconds * 1e6 / (BIG_FRAMES - 1);
+	*ansiMicros = ansiSeconds * 1e6 / (BIG_FRAMES - 1);
+	*bytesPerFrame = (double)framebufferBytes(fb) / BIG_FRAMES;
+
+	// compare cell by cell
+	replayAnsi(output, glyphs, colours, rows, cols);
+	bool same = true;
+	for (int row = 0; row < rows; row++) {
+		for (int col = 0; col < cols; col++) {
+			chtype shown = mvinch(row, col);
+			char glyph;
+			int colour;
+			framebufferCell(fb, row, col, &glyph, &colour);
+			if ((shown & A_CHARTEXT) != glyph || PAIR_NUMBER(shown & A_COLOR) != colour
+					|| glyphs[row * cols + col] != glyph || colours[row * cols + col] != colour) {
+				same = false;
+			}
+		}
+	}
+
+	endwin();
+	delscreen(screen);
+	fclose(sink);
+	fclose(output);
+	framebufferDelete(fb);
+	mazeDelete(maze);
+	free(glyphs);
+	free(colours);
+	return same;
+}
+
+/*
+ * Walks avatar 0 diagonally across a size x size maze, seen through a VIEW_ROWS x VIEW_COLS view
+ * that follows it. Avatar 0 must be in view after every frame, and at the end the view must hold
+ * the same cells as the same part of the whole picture. Returns the time of a whole frame.
+ */
+static bool viewFollows(int numAv, int size, int zoom, double *wholeMicros) {
+	FILE *sink = fopen("/dev/null", "w");
+	maze_t *maze = createMaze(size, size);
+	framebuffer_t *view = framebufferNew(size, size, VIEW_ROWS, VIEW_COLS, zoom, 0);
+	framebuffer_t *whole = framebufferNew(size, size, 0, 0, zoom, -1);
+	if (sink == NULL || view == NULL || whole == NULL) {
+		return false;
+	}
+	unsigned int seed = 3;
+	for (int i = 0; i < size * size / 4; i++) {
+		addWall(maze, rand_r(&seed) % size, rand_r(&seed) % size, rand_r(&seed) % M_NUM_DIRECTIONS);
+	}
+	XYPos positions[AM_MAX_AVATAR];
+	for (int k = 1; k < numAv; k++) {
+		positions[k].x = size - k;
+		positions[k].y = 0;
+	}
+
+	bool ok = true;
+	for (int step = 0; step < size; step++) {
+		positions[0].x = step;
+		positions[0].y = step;
+		if (step % 7 == 0) {
+			addWall(maze, step, step, M_SOUTH);
+		}
+		framebufferDraw(view, numAv, positions, maze);
+		framebufferFlush(view, fileno(sink));
+		int originRow, originCol;
+		framebufferOrigin(view, &originRow, &originCol);
+		int row = (zoom == 1 ? convertY(step) : step / zoom + 1) - originRow;
+		int col = (zoom == 1 ? convertX(step) : step / zoom + 1) - originCol;
+		char glyph;
+		int colour;
+		ok = ok && framebufferCell(view, row, col, &glyph, &colour) && glyph == '0' && colour == FRAMEBUFFER_AVATAR;
+	}
+
+	// the view is a window onto the whole picture
+	framebufferDraw(whole, numAv, positions, maze);
+	int originRow, originCol;
+	framebufferOrigin(view, &originRow, &originCol);
+	for (int row = 0; row < VIEW_ROWS; row++) {
+		for (int col = 0; col < VIEW_COLS; col++) {
+			char glyph, expected;
+			int colour, expectedColour;
+			if (framebufferCell(view, row, col, &glyph, &colour)) {
+				framebufferCell(whole, originRow + row, originCol + col, &expected, &expectedColour);
+				ok = ok && glyph == expected && colour == expectedColour;
+			}
+		}
+	}
+
+	// a whole frame only lays out what is in view
+	double start = now();
+	for (int i = 0; i < VIEW_REPEATS; i++) {
+		framebufferRedraw(view);
+		framebufferDraw(view, numAv, positions, maze);
+		framebufferFlush(view, fileno(sink));
+	}
+	*wholeMicros = (now() - start) * 1e6 / VIEW_REPEATS;
+
+	fclose(sink);
+	framebufferDelete(view);
+	framebufferDelete(whole);
+	mazeDelete(maze);
+	return ok;
+}
+
 // Testing function
 int main(int argc, char * argv[]){
 
@@ -32,8 +326,8 @@ int main(int argc, char * argv[]){
 		exit(EXIT_FAILURE);
 	}
 
-	// Testing createMaze() with 4 avatars (each calling mazeTilenew())
-	mazeTile_t ***tiles = createMaze(mazeheight, mazewidth);
+	// Testing createMaze() on a 10 by 10 grid
+	maze_t *tiles = createMaze(mazeheight, mazewidth);
 
 	// create an array of 4 avatars (each calling avatarNew())
 	avatar_t **avatararray = createAvatars(numAv);
@@ -54,35 +348,82 @@ int main(int argc, char * argv[]){
 	addWall(tiles, 0, 6, 1);
 
 	// call drawMaze(), which calls upon all helper functions in graphics.c (drawWall, drawAvatar, etc.)
-	drawMaze(mazeheight, mazewidth, numAv, avatararray, tiles);
+	drawAvatars(numAv, avatararray, tiles);
 
 	// change the coordinates again 
 	avatararray[2]->yCoord = 1;
 	avatararray[3]->yCoord = 1;
 
 	// draw again to see that the positions were updated on the window 
-	drawMaze(mazeheight, mazewidth, numAv, avatararray, tiles);
+	drawAvatars(numAv, avatararray, tiles);
 
 	// change one more time
 	avatararray[3]->yCoord = 0;
 
 	// draw again to see updated positions 
-	drawMaze(mazeheight, mazewidth, numAv, avatararray, tiles);
+	drawAvatars(numAv, avatararray, tiles);
 	sleep(5);
 	refresh();
 
+	// a frame drawn from changes alone leaves the same screen as a whole one
+	double cellsPerFrame;
+	int wholeCells;
+	bool ok = walkMatchesRedraw(numAv, avatararray, mazeheight, mazewidth, &cellsPerFrame, &wholeCells);
+	sleep(2);
+
+	// publish turns for half a second, far faster than frames are drawn: avatar 0 walks along the top row
+	renderer_t *renderer = renderNew(tiles, numAv, mainwindow, 1, -1);
+	ok = ok && renderer != NULL;
+	XYPos turn[AM_MAX_AVATAR];
+	for (int k = 0; k < numAv; k++) {
+		turn[k].x = htonl(avatararray[k]->xCoord);
+		turn[k].y = htonl(avatararray[k]->yCoord);
+	}
+	double start = now();
+	long published = 0;
+	while (now() - start < PUBLISH_SECONDS) {
+		turn[0].x = htonl(published % mazewidth);
+		renderPublish(renderer, turn);
+		published++;
+	}
+	double publishSeconds = now() - start;
+	renderStop(renderer);
+	double seconds = now() - start;
+	int frames = renderFrames(renderer);
+	renderDelete(renderer);
+
+	// one frame per period at most, plus the last one drawn on the way out
+	ok = ok && frames >= PUBLISH_SECONDS * RENDER_FPS / 2 && frames <= seconds * RENDER_FPS + 2;
+
+	// the ANSI framebuffer against curses on a large maze
+	double cursesMicros, ansiMicros, cursesWholeMicros, ansiWholeMicros, bytesPerFrame;
+	bool ansiOk = ansiMatchesCurses(numAv, &cursesMicros, &ansiMicros, &cursesWholeMicros, &ansiWholeMicros, &bytesPerFrame);
+	ok = ok && ansiOk;
+
+	// views smaller than the maze
+	double smallMicros, hugeMicros, zoomedMicros;
+	bool viewOk = viewFollows(numAv, BIG_SIZE, 1, &smallMicros) && viewFollows(numAv, HUGE_SIZE, 1, &hugeMicros)
+			&& viewFollows(numAv, HUGE_SIZE, 10, &zoomedMicros);
+	ok = ok && viewOk;
+	printf("\rIncremental frames drew %.1f walls and tiles each, a whole frame draws %d\n\r", cellsPerFrame, wholeCells);
+	printf("\rRender thread: %d frames in %.2f s (cap %d per second), %.0f ns per publish\n\r", frames, seconds, RENDER_FPS, publishSeconds * 1e9 / published);
+	printf("\r%dx%d maze, %s: curses %.1f us per frame (%.1f us whole), ANSI framebuffer %.1f us per frame (%.1f us whole), %.1f bytes per frame\n\r",
+			BIG_SIZE, BIG_SIZE, ansiOk ? "screens agree" : "SCREENS DIFFER", cursesMicros, cursesWholeMicros, ansiMicros, ansiWholeMicros, bytesPerFrame);
+	printf("\r%dx%d view %s: whole frame of a %dx%d maze %.1f us, of a %dx%d maze %.1f us, zoomed out 10x %.1f us\n\r",
+			VIEW_ROWS, VIEW_COLS, viewOk ? "follows" : "LOST THE AVATAR", BIG_SIZE, BIG_SIZE, smallMicros, HUGE_SIZE, HUGE_SIZE, hugeMicros, zoomedMicros);
+	if (!ok) {
+		printf("\rTest Results Failed\n\r");
+		return 1;
+	}
+
 	printf("\rTest Results Successful\n\r");
 	printf(" :) \n\r");
 
 	// testing deleteAvatars() function which calls avatarDelete on every avatar
 	deleteAvatars(avatararray, numAv);
 
-	// deleting every mazetile / freeing all memory
-	mazeDelete(mazeheight, mazewidth, tiles);
-
-	// Delete the window and end the window 
-	delwin(mainwindow);
-	endwin();
+	// deleting the maze / freeing all memory
+	mazeDelete(tiles);
 
 	printf("\n");
 	return 0;
@@ -0,0 +1,382 @@
+/*
+ * kerneltest.c, a testing module for the table-driven leftHandRule in avatar.c
+ *
+ * The rule used to be a ladder of if/else wall tests per facing; that ladder is kept here as the
+ * reference. The table kernel must agree with it on every (facing, wall mask) pair, and must
+ * reproduce the moves logged in the log.out runs given on the command line. Finally both
+ * kernels are timed on random inputs.
+ *
+ * Usage: ./kerneltest [log.out/Amazing_...]...
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r, clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include "amazing.h"
+#include "avatar.h"
+#include "mazeSolver.h"
+
+/**************** file-local constants ****************/
+#define BENCH_CALLS (1 << 22)         // calls per kernel per round
+#define BENCH_ROUNDS 5
+#define BENCH_INPUTS 4096        // random (facing, mask) pairs cycled through by the benchmark
+#define LINE_LENGTH 256
+
+/**************** file-local types ****************/
+
+// what the replay believes one avatar knew when it last chose a move
+typedef struct replayAvatar {
+	int x, y;                 // position the avatar believed it was on
+	int seenX, seenY;         // latest position logged for it
+	bool seen;
+	bool moved;               // has chosen a move before
+	int moveX, moveY;         // tile it chose that move on
+	int move;
+	int facingBefore;
+	int facingAfter;
+} replayAvatar_t;
+
+/**************** file-local functions ****************/
+
+// nanoseconds on the monotonic clock
+static long long now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ *	The if/else version of leftHandRule the table replaced, kept verbatim as the reference
+ */
+static int ladderLeftHandRule(avatar_t *currentAvatar, int walls, int *lastTurn, int numAvatars, avatar_t **avatars) {
+	(*lastTurn) = currentAvatar->avatarID;
+
+	// Last avatar should not move
+	if (currentAvatar->avatarID == (numAvatars - 1)) {
+		currentAvatar->direction = 8;
+		return M_NULL_MOVE;
+	}
+	// If currentAvatar is on the same tile as the "goal" avatar, don't move
+	if ((currentAvatar->xCoord == avatars[numAvatars - 1]->xCoord) && (currentAvatar->yCoord == avatars[numAvatars - 1]->yCoord)) {
+		currentAvatar->direction = 8;
+		return M_NULL_MOVE;
+	}
+
+	// if we are facing up
+	if (currentAvatar->direction == M_NORTH) {
+		// if there is not a wall to the left, go left
+		if (!(walls & WALL_WEST)) {
+			currentAvatar->direction = M_WEST;
+			return M_WEST;
+		}
+		// if there is not a wall to the front, go forward
+		else if (!(walls & WALL_NORTH)) {
+			currentAvatar->direction = M_NORTH;
+			return M_NORTH;
+		}
+		// if there is not a wall to the right, go right
+		else if (!(walls & WALL_EAST)) {
+			currentAvatar->direction = M_EAST;
+			return M_EAST;
+		}
+		// if there is not a wall to the bottom, go backwards
+		else if (!(walls & WALL_SOUTH)) {
+			currentAvatar->direction = M_SOUTH;
+			return M_SOUTH;
+		}
+	}
+	// if we are facing east
+	else if (currentAvatar->direction == M_EAST) {
+		// if there is not a wall to the left, go up
+		if (!(walls & WALL_NORTH)) {
+			currentAvatar->direction = M_NORTH;
+			return M_NORTH;
+		}
+		// if there is not a wall in front, go forward
+		else if (!(walls & WALL_EAST)) {
+			currentAvatar->direction = M_EAST;
+			return M_EAST;
+		}
+		// if there is not a wall to the right, go right
+		else if (!(walls & WALL_SOUTH)) {
+			currentAvatar->direction = M_SOUTH;
+			return M_SOUTH;
+		}
+		// if there is not a wall to the back, go backwards
+		else if (!(walls & WALL_WEST)) {
+			currentAvatar->direction = M_WEST;
+			return M_WEST;
+		}
+	}
+	// if we are facing south
+	else if (currentAvatar->direction == M_SOUTH) {
+		// if there is not a wall to the left, go left
+		if (!(walls & WALL_EAST)) {
+			currentAvatar->direction = M_EAST;
+			return M_EAST;
+		}
+		// if there is not a wall in front, go forward
+		else if (!(walls & WALL_SOUTH)) {
+			currentAvatar->direction = M_SOUTH;
+			return M_SOUTH;
+		}
+		// if there is not a wall to the right, go right
+		else if (!(walls & WALL_WEST)) {
+			currentAvatar->direction = M_WEST;
+			return M_WEST;
+		}
+		// if there is not a wall to the back, go backwards
+		else if (!(walls & WALL_NORTH)) {
+			currentAvatar->direction = M_NORTH;
+			return M_NORTH;
+		}
+	}
+	// if we are facing west
+	else if (currentAvatar->direction == M_WEST) {
+		// if there is not a wall to the left, go left
+		if (!(walls & WALL_SOUTH)) {
+			currentAvatar->direction = M_SOUTH;
+			return M_SOUTH;
+		}
+		// if there is not a wall in front, go forward
+		else if (!(walls & WALL_WEST)) {
+			currentAvatar->direction = M_WEST;
+			return M_WEST;
+		}
+		// if there is not a wall to the right, go right
+		else if (!(walls & WALL_NORTH)) {
+			currentAvatar->direction = M_NORTH;
+			return M_NORTH;
+		}
+		// if there is not a wall to the back, go backwards
+		else if (!(walls & WALL_EAST)) {
+			currentAvatar->direction = M_EAST;
+			return M_EAST;
+		}
+	}
+	return M_NULL_MOVE;
+}
+
+// runs both kernels for avatar 'id' on (x,y) with the given facing and walls; returns the ladder's move
+static int decide(avatar_t **avatars, int numAvatars, int id, int x, int y, int facing, int walls, int *newFacing, int *disagreements) {
+	int lastTurn;
+	setPosition(avatars[id], x, y);
+	setDirection(avatars[id], facing);
+	int expected = ladderLeftHandRule(avatars[id], walls, &lastTurn, numAvatars, avatars);
+	*newFacing = avatars[id]->direction;
+	setDirection(avatars[id], facing);
+	int move = leftHandRule(avatars[id], walls, &lastTurn, numAvatars, avatars);
+	if (move != expected || avatars[id]->direction != *newFacing) {
+		(*disagreements)++;
+	}
+	return expected;
+}
+
+// converts a direction as written by parseDirection back to its number
+static int parseLoggedDirection(const char *word) {
+	for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+		if (strcmp(parseDirection(direction), word) == 0) {
+			return direction;
+		}
+	}
+	return M_NULL_MOVE;
+}
+
+/*
+ *	Replays one log, rebuilding what each avatar knew when it chose each move, and counts the logged
+ *	moves the kernels reproduce. The old client raced on lastTurnID, so an avatar sometimes never saw
+ *	the result of a move; both outcomes are tried and the one matching the logged move is kept.
+ */
+static void replayLog(const char *path, int *decisions, int *reproduced, int *disagreements) {
+	FILE *fp = fopen(path, "r");
+	if (fp == NULL) {
+		fprintf(stderr, "kerneltest: cannot open %s\n", path);
+		return;
+	}
+	char line[LINE_LENGTH];
+	char word[LINE_LENGTH];
+	replayAvatar_t state[AM_MAX_AVATAR];
+	int numAvatars = 0;
+	int width = 1;
+	int height = 1;
+	int id, x, y;
+
+	// the logs do not hold the maze size, so take the smallest maze every logged position fits in
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "Initial position of Avatar %d is (%d, %d)", &id, &x, &y) == 3 && id >= 0 && id < AM_MAX_AVATAR) {
+			memset(&state[id], 0, sizeof(replayAvatar_t));
+			state[id].x = x;
+			state[id].y = y;
+			state[id].facingAfter = M_SOUTH;
+			numAvatars = id + 1 > numAvatars ? id + 1 : numAvatars;
+		}
+		else if (sscanf(line, "Avatar %d at (%d,%d)", &id, &x, &y) != 3) {
+			continue;
+		}
+		width = x + 1 > width ? x + 1 : width;
+		height = y + 1 > height ? y + 1 : height;
+	}
+	if (numAvatars == 0) {
+		fclose(fp);
+		return;
+	}
+	maze_t *maze = createMaze(height, width);
+	avatar_t **avatars = createAvatars(numAvatars);
+	int goal = numAvatars - 1;
+
+	rewind(fp);
+	while (fgets(line, sizeof(line), fp) != NULL) {
+		if (sscanf(line, "Avatar %d at (%d,%d)", &id, &x, &y) == 3 && id < numAvatars) {
+			state[id].seenX = x;
+			state[id].seenY = y;
+			state[id].seen = true;
+			continue;
+		}
+		if (sscanf(line, "Avatar %d tries to move in direction %255s", &id, word) != 2 || id >= numAvatars) {
+			continue;
+		}
+		int logged = parseLoggedDirection(word);
+		replayAvatar_t *me = &state[id];
+		replayAvatar_t *goalAvatar = &state[goal];
+		setPosition(avatars[goal], goalAvatar->seen ? goalAvatar->seenX : goalAvatar->x, goalAvatar->seen ? goalAvatar->seenY : goalAvatar->y);
+
+		// outcomes of the previous move: it was seen (blocked or moved), or it was missed
+		int candidates = 0;
+		int candX[2], candY[2], candFacing[2], candWall[2];
+		if (me->moved) {
+			int seenX = me->seen ? me->seenX : me->moveX;
+			int seenY = me->seen ? me->seenY : me->moveY;
+			bool blocked = seenX == me->moveX && seenY == me->moveY;
+			candX[candidates] = blocked ? me->moveX : seenX;
+			candY[candidates] = blocked ? me->moveY : seenY;
+			candFacing[candidates] = blocked && me->facingAfter != M_NULL_MOVE ? me->facingBefore : me->facingAfter;
+			candWall[candidates] = blocked && me->facingAfter != M_NULL_MOVE ? me->move : M_NULL_MOVE;
+			candidates++;
+			candX[candidates] = me->moveX;
+			candY[candidates] = me->moveY;
+			candFacing[candidates] = me->facingAfter;
+			candWall[candidates] = M_NULL_MOVE;
+			candidates++;
+		}
+		else {
+			candX[candidates] = me->x;
+			candY[candidates] = me->y;
+			candFacing[candidates] = me->facingAfter;
+			candWall[candidates] = M_NULL_MOVE;
+			candidates++;
+		}
+
+		// keep the first outcome under which the rule makes the logged move, the seen one if none does
+		int chosen = 0;
+		int move = M_NULL_MOVE;
+		int facing = M_NULL_MOVE;
+		for (int c = 0; c < candidates; c++) {
+			int walls = getWalls(maze, candX[c], candY[c]);
+			if (candWall[c] != M_NULL_MOVE) {
+				walls |= 1 << candWall[c];
+			}
+			move = decide(avatars, numAvatars, id, candX[c], candY[c], candFacing[c], walls, &facing, disagreements);
+			if (move == logged) {
+				chosen = c;
+				(*reproduced)++;
+				break;
+			}
+		}
+		if (move == logged && candWall[chosen] != M_NULL_MOVE) {
+			addWall(maze, candX[chosen], candY[chosen], candWall[chosen]);
+		}
+		(*decisions)++;
+
+		// carry on from what the log says happened
+		me->x = candX[chosen];
+		me->y = candY[chosen];
+		me->moved = true;
+		me->moveX = candX[chosen];
+		me->moveY = candY[chosen];
+		me->move = logged;
+		me->facingBefore = candFacing[chosen];
+		me->facingAfter = move == logged ? facing : (logged == M_NULL_MOVE ? candFacing[chosen] : logged);
+	}
+	deleteAvatars(avatars, numAvatars);
+	mazeDelete(maze);
+	fclose(fp);
+}
+
+// Testing function
+int main(int argc, char *argv[]) {
+	int disagreements = 0;
+
+	// every facing an avatar can have (M_NULL_MOVE included) against every wall mask
+	avatar_t **avatars = createAvatars(2);
+	setPosition(avatars[1], 0, 0);
+	int cases = 0;
+	for (int facing = 0; facing <= M_NULL_MOVE; facing++) {
+		for (int walls = 0; walls < 16; walls++) {
+			int newFacing;
+			decide(avatars, 2, 0, 1, 1, facing, walls, &newFacing, &disagreements);
+			cases++;
+		}
+	}
+	printf("%d (facing, wall mask) cases checked against the if/else rule\n", cases);
+
+	// the moves of real games
+	int decisions = 0;
+	int reproduced = 0;
+	for (int i = 1; i < argc; i++) {
+		replayLog(argv[i], &decisions, &reproduced, &disagreements);
+	}
+	if (argc > 1) {
+		printf("Replayed %d logs: %d of %d logged moves reproduced (the rest were made on state the logs do not record)\n", argc - 1, reproduced, decisions);
+	}
+	printf("%d disagreements between the table and the if/else rule\n", disagreements);
+
+	// time both kernels on random inputs
+	unsigned int seed = 9;
+	int facings[BENCH_INPUTS];
+	int masks[BENCH_INPUTS];
+	for (int i = 0; i < BENCH_INPUTS; i++) {
+		facings[i] = rand_r(&seed) % M_NUM_DIRECTIONS;
+		masks[i] = rand_r(&seed) % 16;
+	}
+	int lastTurn;
+	long sink = 0;
+	double ladderSeconds = 0;
+	double tableSeconds = 0;
+	setPosition(avatars[0], 1, 1);
+
+	// best of several alternating rounds, so a noisy machine does not favour either kernel
+	for (int round = 0; round < BENCH_ROUNDS; round++) {
+		long long start = now();
+		for (int i = 0; i < BENCH_CALLS; i++) {
+			avatars[0]->direction = facings[i & (BENCH_INPUTS - 1)];
+			sink += ladderLeftHandRule(avatars[0], masks[i & (BENCH_INPUTS - 1)], &lastTurn, 2, avatars);
+		}
+		double seconds = (now() - start) / 1e9;
+		ladderSeconds = (round == 0 || seconds < ladderSeconds) ? seconds : ladderSeconds;
+
+		start = now();
+		for (int i = 0; i < BENCH_CALLS; i++) {
+			avatars[0]->direction = facings[i & (BENCH_INPUTS - 1)];
+			sink -= leftHandRule(avatars[0], masks[i & (BENCH_INPUTS - 1)], &lastTurn, 2, avatars);
+		}
+		seconds = (now() - start) / 1e9;
+		tableSeconds = (round == 0 || seconds < tableSeconds) ? seconds : tableSeconds;
+	}
+	printf("if/else rule: %.1f million calls per second\n", BENCH_CALLS / ladderSeconds / 1e6);
+	printf("table rule:   %.1f million calls per second\n", BENCH_CALLS / tableSeconds / 1e6);
+	deleteAvatars(avatars, 2);
+
+	if (disagreements != 0 || sink != 0) {
+		printf("Test Results Failed\n");
+		return 1;
+	}
+	printf("Test Results Successful\n");
+	return 0;
+}
@@ -0,0 +1,157 @@
+/*
+ * latency.c - 'latency' module
+ *
+ * see latency.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include "latency.h"
+
+typedef struct histogram {
+	long buckets[LATENCY_BUCKETS];
+	long count;
+	long long max;
+} histogram_t;
+
+/*
+ * 'histograms' holds LATENCY_NUM_PHASES histograms per avatar, avatar by avatar.
+ */
+typedef struct latency {
+	int nAvatars;
+	histogram_t *histograms;
+} latency_t;
+
+static const char *phaseNames[LATENCY_NUM_PHASES] = { "network wait", "decision", "render", "log" };
+
+latency_t *latencyNew(int nAvatars) {
+	latency_t *latency = malloc(sizeof(latency_t));
+	histogram_t *histograms = calloc(nAvatars * LATENCY_NUM_PHASES, sizeof(histogram_t));
+	if (latency == NULL || histograms == NULL) {
+		fprintf(stderr, "Failed to malloc for latency histograms\n");
+		free(latency);
+		free(histograms);
+		return NULL;
+	}
+	latency->nAvatars = nAvatars;
+	latency->histograms = histograms;
+	return latency;
+}
+
+void latencyDelete(latency_t *latency) {
+	if (latency != NULL) {
+		free(latency->histograms);
+		free(latency);
+	}
+}
+
+long long latencyNow(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// index of the highest set bit, so 2^b <= nanoseconds < 2^(b+1)
+static int bucketOf(long long nanoseconds) {
+	int bucket = 0;
+	while (nanoseconds > 1 && bucket < LATENCY_BUCKETS - 1) {
+		nanoseconds >>= 1;
+		bucket++;
+	}
+	return bucket;
+}
+
+void latencyRecord(latency_t *latency, int avatarID, latencyPhase_t phase, long long nanoseconds) {
+	if (latency == NULL) {
+		return;
+	}
+	if (nanoseconds < 0) {
+		nanoseconds = 0;
+	}
+	histogram_t *histogram = &latency->histograms[avatarID * LATENCY_NUM_PHASES + phase];
+	histogram->buckets[bucketOf(nanoseconds)]++;
+	histogram->count++;
+	if (nanoseconds > histogram->max) {
+		histogram->max = nanoseconds;
+	}
+}
+
+// one avatar's histogram, or every avatar's added together when avatarID is -1
+static histogram_t collect(latency_t *latency, int avatarID, latencyPhase_t phase) {
+	histogram_t sum = { { 0 }, 0, 0 };
+	for (int k = 0; k < latency->nAvatars; k++) {
+		if (avatarID >= 0 && k != avatarID) {
+			continue;
+		}
+		histogram_t *histogram = &latency->histograms[k * LATENCY_NUM_PHASES + phase];
+		for (int b = 0; b < LATENCY_BUCKETS; b++) {
+			sum.buckets[b] += histogram->buckets[b];
+		}
+		sum.count += histogram->count;
+		if (histogram->max > sum.max) {
+			sum.max = histogram->max;
+		}
+	}
+	return sum;
+}
+
+// top of the bucket holding the given rank, capped by the largest time seen
+static long long percentileOf(histogram_t *histogram, double percentile) {
+	if (histogram->count == 0) {
+		return 0;
+	}
+	long rank = (long)(percentile / 100.0 * histogram->count + 0.5);
+	if (rank < 1) {
+		rank = 1;
+	}
+	long seen = 0;
+	for (int b = 0; b < LATENCY_BUCKETS; b++) {
+		seen += histogram->buckets[b];
+		if (seen >= rank) {
+			long long top = (2LL << b) - 1;
+			return top < histogram->max ? top : histogram->max;
+		}
+	}
+	return histogram->max;
+}
+
+long latencyCount(latency_t *latency, int avatarID, latencyPhase_t phase) {
+	return collect(latency, avatarID, phase).count;
+}
+
+long long latencyPercentile(latency_t *latency, int avatarID, latencyPhase_t phase, double percentile) {
+	histogram_t histogram = collect(latency, avatarID, phase);
+	return percentileOf(&histogram, percentile);
+}
+
+long long latencyMax(latency_t *latency, int avatarID, latencyPhase_t phase) {
+	return collect(latency, avatarID, phase).max;
+}
+
+// one line of the report, times in microseconds
+static void reportLine(FILE *fp, const char *name, histogram_t *histogram) {
+	fprintf(fp, "%-16s %8ld %10.1f %10.1f %10.1f %10.1f\n", name, histogram->count,
+			percentileOf(histogram, 50) / 1e3, percentileOf(histogram, 90) / 1e3,
+			percentileOf(histogram, 99) / 1e3, histogram->max / 1e3);
+}
+
+void latencyReport(latency_t *latency, FILE *fp, bool perAvatar) {
+	fprintf(fp, "%-16s %8s %10s %10s %10s %10s\n", "Latency (us)", "count", "p50", "p90", "p99", "max");
+	for (int phase = 0; phase < LATENCY_NUM_PHASES; phase++) {
+		histogram_t histogram = collect(latency, -1, phase);
+		reportLine(fp, phaseNames[phase], &histogram);
+		for (int k = 0; perAvatar && k < latency->nAvatars; k++) {
+			char name[32];
+			sprintf(name, "  avatar %d", k);
+			histogram = collect(latency, k, phase);
+			reportLine(fp, name, &histogram);
+		}
+	}
+}
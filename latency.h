@@ -0,0 +1,128 @@
+/*
+ * latency.h - header file for latency module
+ *
+ * This module keeps log-bucketed histograms of how long each part of a turn takes, one set per
+ * avatar: waiting for the server after a move, choosing the move, drawing the maze and writing
+ * the log. Each avatar only ever records into its own histograms, so threads need no lock;
+ * reports are read once the game is over.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __LATENCY_H
+#define __LATENCY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/**************** constants ****************/
+
+/*
+ * Number of buckets per histogram. Bucket b counts times from 2^b up to 2^(b+1) nanoseconds
+ * (bucket 0 also counts 0), so 40 buckets reach past 18 minutes.
+ */
+#define LATENCY_BUCKETS 40
+
+/*
+ * The phases of a turn that are timed.
+ */
+typedef enum latencyPhase {
+	LATENCY_NETWORK,          // move sent until the next message arrived
+	LATENCY_DECISION,         // the strategy's chooseMove hook
+	LATENCY_RENDER,           // handing the turn to the render thread (renderPublish), which draws it
+	LATENCY_LOG,              // pushing the turn's lines onto the log ring; the writer thread writes them
+	LATENCY_NUM_PHASES
+} latencyPhase_t;
+
+/**************** structs ****************/
+
+/**************** latency ****************/
+/*
+ * One histogram per avatar and phase. See latency.c for details.
+ */
+typedef struct latency latency_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** latencyNew ****************/
+/*
+ * Function which creates empty histograms for a game.
+ *
+ * Input: Number of avatars.
+ *
+ * Output: The histograms, or NULL if memory could not be allocated.
+ *
+ */
+latency_t *latencyNew(int nAvatars);
+
+/**************** latencyDelete ****************/
+/*
+ * Input: Histograms created by latencyNew(), or NULL.
+ *
+ * Output: None.
+ *
+ */
+void latencyDelete(latency_t *latency);
+
+/**************** latencyNow ****************/
+/*
+ * Output: Nanoseconds on the monotonic clock, for timing phases.
+ *
+ */
+long long latencyNow(void);
+
+/**************** latencyRecord ****************/
+/*
+ * Function which counts one timed phase. Only the avatar's own thread may record for it.
+ *
+ * Input: Histograms (NULL records nothing), avatar ID, phase, time taken in nanoseconds.
+ *
+ * Output: None.
+ *
+ */
+void latencyRecord(latency_t *latency, int avatarID, latencyPhase_t phase, long long nanoseconds);
+
+/**************** latencyCount ****************/
+/*
+ * Input: Histograms, avatar ID or -1 for all avatars together, phase.
+ *
+ * Output: Number of times recorded.
+ *
+ */
+long latencyCount(latency_t *latency, int avatarID, latencyPhase_t phase);
+
+/**************** latencyPercentile ****************/
+/*
+ * Function which estimates a percentile from the buckets.
+ *
+ * Input: Histograms, avatar ID or -1 for all avatars together, phase, percentile from 0 to 100.
+ *
+ * Output: The top of the bucket the percentile falls in, but no more than the largest time
+ * recorded, in nanoseconds; so at most twice the true value. 0 if nothing was recorded.
+ *
+ */
+long long latencyPercentile(latency_t *latency, int avatarID, latencyPhase_t phase, double percentile);
+
+/**************** latencyMax ****************/
+/*
+ * Input: Histograms, avatar ID or -1 for all avatars together, phase.
+ *
+ * Output: The largest time recorded, in nanoseconds.
+ *
+ */
+long long latencyMax(latency_t *latency, int avatarID, latencyPhase_t phase);
+
+/**************** latencyReport ****************/
+/*
+ * Function which prints count, p50, p90, p99 and max of every phase in microseconds.
+ *
+ * Input: Histograms, where to print, whether to add a line per avatar under each phase.
+ *
+ * Output: None.
+ *
+ */
+void latencyReport(latency_t *latency, FILE *fp, bool perAvatar);
+
+#endif // __LATENCY_H
@@ -0,0 +1,71 @@
+/*
+ * latencytest.c, a testing module for the turn histograms in latency.c
+ *
+ * Records known times and checks that counts, maxima and percentiles come out where the
+ * log2 buckets put them: never below the true value and never more than twice it. Each
+ * avatar's histograms must stay separate, and all avatars together must add up. Last,
+ * latencyRecord() is timed, since it runs several times per turn.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "latency.h"
+#include "testing.h"
+
+/**************** file-local constants ****************/
+#define NUM_AVATARS 3
+#define NUM_TIMED 10000000
+
+/**************** file-local functions ****************/
+
+// a bucketed percentile may overstate the true value by up to a factor of two
+static bool near(long long estimate, long long truth) {
+	return estimate >= truth && estimate < 2 * truth;
+}
+
+// Testing function
+int main(int argc, char *argv[]) {
+	latency_t *latency = latencyNew(NUM_AVATARS);
+	check(latency != NULL, "latencyNew allocates the histograms");
+	check(latencyCount(latency, -1, LATENCY_NETWORK) == 0 && latencyPercentile(latency, -1, LATENCY_NETWORK, 50) == 0,
+			"new histograms are empty");
+
+	// avatar 0 waits 1..1000 us for the network, avatar 1 takes 5 ms to decide once
+	for (int us = 1; us <= 1000; us++) {
+		latencyRecord(latency, 0, LATENCY_NETWORK, us * 1000LL);
+	}
+	latencyRecord(latency, 1, LATENCY_DECISION, 5000000LL);
+	latencyRecord(latency, 2, LATENCY_NETWORK, 3000000LL);
+	latencyRecord(NULL, 0, LATENCY_NETWORK, 1);
+
+	check(latencyCount(latency, 0, LATENCY_NETWORK) == 1000, "avatar 0 has 1000 network waits");
+	check(latencyMax(latency, 0, LATENCY_NETWORK) == 1000000LL, "avatar 0's longest network wait is 1 ms");
+	check(near(latencyPercentile(latency, 0, LATENCY_NETWORK, 50), 500000LL), "avatar 0's p50 is within a bucket of 500 us");
+	check(near(latencyPercentile(latency, 0, LATENCY_NETWORK, 90), 900000LL), "avatar 0's p90 is within a bucket of 900 us");
+	check(latencyPercentile(latency, 0, LATENCY_NETWORK, 99) <= 1000000LL, "no percentile is above the maximum");
+	check(latencyCount(latency, 0, LATENCY_DECISION) == 0 && latencyCount(latency, 1, LATENCY_NETWORK) == 0,
+			"phases and avatars are kept apart");
+	check(latencyPercentile(latency, 1, LATENCY_DECISION, 50) == 5000000LL, "a single time is its own percentile");
+	check(latencyCount(latency, -1, LATENCY_NETWORK) == 1001 && latencyMax(latency, -1, LATENCY_NETWORK) == 3000000LL,
+			"all avatars together add up");
+
+	latencyReport(latency, stdout, true);
+	latencyDelete(latency);
+
+	// the cost of one record
+	latency = latencyNew(1);
+	long long start = latencyNow();
+	for (int i = 0; i < NUM_TIMED; i++) {
+		latencyRecord(latency, 0, LATENCY_RENDER, i & 0xffff);
+	}
+	double seconds = (latencyNow() - start) / 1e9;
+	printf("latencyRecord: %.1f ns per call\n", seconds * 1e9 / NUM_TIMED);
+	check(latencyCount(latency, 0, LATENCY_RENDER) == NUM_TIMED, "every timed record is counted");
+	latencyDelete(latency);
+
+	return testResults();
+}
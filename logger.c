@@ -0,0 +1,609 @@
+/*
+ * logger.c - 'logger' module
+ *
+ * see logger.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // nanosleep
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include "logger.h"
+
+#define LOGGER_BATCH 65536        // bytes the writer formats before each fwrite
+#define LOGGER_LINE_MAX 256       // longest line a record formats to
+#define LOGGER_IDLE_NANOS 1000000L  // how long the writer sleeps when every ring is empty
+
+#define TRACE_MAX_AVATARS 16      // avatars whose positions and turns a trace keeps differences of (IDs fit in 4 bits)
+
+// tags in the high 4 bits of the first byte of each trace record
+#define TRACE_POSITION 0          // LOG_POSITION of the avatar in the low bits, at most a tile from where it was; one more byte
+#define TRACE_MOVE 1              // LOG_MOVE of the avatar in the low bits, on its next turn; one more byte
+#define TRACE_RECORD 2            // any record of the kind in the low bits, its arguments as varints
+#define TRACE_TEXT 3              // text of the caller's own: its length as a varint, then the bytes
+
+/*
+ * One line waiting to be written. 'seq' is its place in the log; 'text' is the one string
+ * argument a kind may have, which is always a literal (see parseDirection() in avatar.c).
+ */
+typedef struct logRecord {
+	unsigned long long seq;
+	int kind;
+	int args[6];
+	const char *text;
+} logRecord_t;
+
+/*
+ * One avatar's ring. Only its avatar writes 'head' and the records, only the writer thread
+ * writes 'tail'; each sits on a cache line of its own so the two never share one.
+ */
+typedef struct logRing {
+	_Alignas(64) atomic_size_t head;    // records pushed
+	_Alignas(64) atomic_size_t tail;    // records written
+	_Alignas(64) long stalls;           // pushes that found the ring full, written by the avatar only
+	logRecord_t records[LOGGER_RING_SIZE];
+} logRing_t;
+
+/*
+ * What trace records are differences from: every avatar's last logged position and own turn,
+ * and the last turn logged. The writer and loggerConvert() keep one each, updated alike.
+ */
+typedef struct traceState {
+	int x[TRACE_MAX_AVATARS];
+	int y[TRACE_MAX_AVATARS];
+	int turns[TRACE_MAX_AVATARS];
+	int turn;
+} traceState_t;
+
+typedef struct logger {
+	FILE *fp;
+	bool trace;                       // write a binary trace instead of text
+	traceState_t state;               // written by the writer thread only, or by pushes once it stopped
+	int nAvatars;
+	logRing_t *rings;
+	atomic_ullong nextSeq;            // records pushed by everyone, and the seq of the next one
+	atomic_ullong flushed;            // records written and flushed to fp
+	atomic_bool stopping;
+	bool running;
+	long writes;                      // fwrite calls, written by the writer thread only
+	pthread_t thread;
+} logger_t;
+
+// the arguments of each kind, in order: 'd' an int, 's' the string
+static const char *signatures[LOG_NUM_KINDS] = {
+	[LOG_INITIAL_POSITION] = "ddd",
+	[LOG_POSITION] = "dddd",
+	[LOG_MOVE] = "dsdd",
+	[LOG_SOLVED] = "dddd",
+	[LOG_MOVE_LIMIT] = "d",
+	[LOG_NO_SUCH_AVATAR] = "d",
+	[LOG_OUT_OF_TURN] = "dd",
+	[LOG_SERVER_TIMEOUT] = "d",
+	[LOG_UNKNOWN_MESSAGE] = "d",
+	[LOG_UNEXPECTED_MESSAGE] = "dd",
+	[LOG_LOOP] = "dddsdd",
+	[LOG_WASTED] = "dddd",
+	[LOG_RENDEZVOUS] = "dddd",
+};
+
+// the strings a direction argument can be, numbered as in a trace; anything else is the last
+static const char *directions[] = { "west", "north", "south", "east", "no direction (NULL_MOVE)" };
+#define NUM_DIRECTIONS 5
+
+// moves of a position record, numbered as in a trace: none, then one tile left, up, down or right
+static const int stepX[] = { 0, -1, 0, 0, 1 };
+static const int stepY[] = { 0, 0, -1, 1, 0 };
+#define NUM_STEPS 5
+
+// formats a record into the line the avatars used to fprintf; returns its length
+static int formatRecord(char *buf, size_t size, logRecord_t *record) {
+	int *a = record->args;
+	switch (record->kind) {
+	case LOG_INITIAL_POSITION:
+		return snprintf(buf, size, "Initial position of Avatar %d is (%d, %d)\n", a[0], a[1], a[2]);
+	case LOG_POSITION:
+		return snprintf(buf, size, "Avatar %d at (%d,%d) on turn %d\n", a[0], a[1], a[2], a[3]);
+	case LOG_MOVE:
+		return snprintf(buf, size, "Avatar %d tries to move in direction %s on turn %d, which is turn %d for the  avatar\n",
+				a[0], record->text, a[1], a[2]);
+	case LOG_SOLVED:
+		return snprintf(buf, size, "Solved!  Number of avatars: %d, difficulty: %d number of moves: %d, hash: %d\n",
+				a[0], a[1], a[2], a[3]);
+	case LOG_MOVE_LIMIT:
+		return snprintf(buf, size, "Move limit reached at turn %d\n", a[0]);
+	case LOG_NO_SUCH_AVATAR:
+		return snprintf(buf, size, "Avatar %d does not exist\n", a[0]);
+	case LOG_OUT_OF_TURN:
+		return snprintf(buf, size, "Avatar %d moving out of turn on turn %d\n", a[0], a[1]);
+	case LOG_SERVER_TIMEOUT:
+		return snprintf(buf, size, "Server timeout occured on turn %d\n", a[0]);
+	case LOG_UNKNOWN_MESSAGE:
+		return snprintf(buf, size, "Unknown message received on turn %d\n", a[0]);
+	case LOG_UNEXPECTED_MESSAGE:
+		return snprintf(buf, size, "Unexpected message of type %d received on turn %d\n", a[0], a[1]);
+	case LOG_LOOP:
+		return snprintf(buf, size, "Avatar %d is back on (%d,%d) facing %s after a %d move loop on turn %d, switching to Tremaux marking\n",
+				a[0], a[1], a[2], record->text, a[3], a[4]);
+	case LOG_WASTED:
+		return snprintf(buf, size, "Avatar %d wasted %d moves: %d into walls, %d going round loops\n", a[0], a[1], a[2], a[3]);
+	case LOG_RENDEZVOUS:
+		return snprintf(buf, size, "Avatars now meet at (%d,%d), %d steps away, on turn %d\n", a[0], a[1], a[2], a[3]);
+	default:
+		return 0;
+	}
+}
+
+// a direction's number in a trace
+static int directionCode(const char *direction) {
+	for (int d = 0; d < NUM_DIRECTIONS - 1; d++) {
+		if (direction != NULL && strcmp(direction, directions[d]) == 0) {
+			return d;
+		}
+	}
+	return NUM_DIRECTIONS - 1;
+}
+
+// signed numbers are stored zigzagged, so that small negative ones stay short
+static unsigned long long zigzag(long long value) {
+	return ((unsigned long long)value << 1) ^ (value < 0 ? ~0ULL : 0);
+}
+
+static long long unzigzag(unsigned long long value) {
+	return (long long)(value >> 1) ^ -(long long)(value & 1);
+}
+
+// appends 7 bits per byte, low bits first, the top bit set on all but the last; returns the bytes used
+static int putVarint(unsigned char *out, unsigned long long value) {
+	int n = 0;
+	while (value >= 0x80) {
+		out[n++] = (value & 0x7f) | 0x80;
+		value >>= 7;
+	}
+	out[n++] = value;
+	return n;
+}
+
+static bool getVarint(FILE *fp, unsigned long long *value) {
+	*value = 0;
+	for (int shift = 0; shift < 64; shift += 7) {
+		int c = getc(fp);
+		if (c == EOF) {
+			return false;
+		}
+		*value |= (unsigned long long)(c & 0x7f) << shift;
+		if ((c & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// an int argument of a generic record
+static bool getInt(FILE *fp, int *value) {
+	unsigned long long raw;
+	if (!getVarint(fp, &raw)) {
+		return false;
+	}
+	*value = unzigzag(raw);
+	return true;
+}
+
+// moves the state on past a record, whether it was encoded or decoded
+static void traceUpdate(traceState_t *state, logRecord_t *record) {
+	int *a = record->args;
+	bool known = a[0] >= 0 && a[0] < TRACE_MAX_AVATARS;
+	if (record->kind == LOG_INITIAL_POSITION && known) {
+		state->x[a[0]] = a[1];
+		state->y[a[0]] = a[2];
+	} else if (record->kind == LOG_POSITION) {
+		if (known) {
+			state->x[a[0]] = a[1];
+			state->y[a[0]] = a[2];
+		}
+		state->turn = a[3];
+	} else if (record->kind == LOG_MOVE) {
+		if (known) {
+			state->turns[a[0]] = a[2];
+		}
+		state->turn = a[1];
+	}
+}
+
+/*
+ * Encodes a record into at most LOGGER_LINE_MAX bytes; returns how many. A turn's positions and
+ * move, nearly all of a game's records, take two bytes each.
+ */
+static int encodeRecord(unsigned char *out, traceState_t *state, logRecord_t *record) {
+	int *a = record->args;
+	int n = 0;
+	bool known = a[0] >= 0 && a[0] < TRACE_MAX_AVATARS;
+	if (record->kind == LOG_POSITION && known && (a[3] == state->turn || a[3] == state->turn + 1)) {
+		for (int step = 0; step < NUM_STEPS; step++) {
+			if (a[1] == state->x[a[0]] + stepX[step] && a[2] == state->y[a[0]] + stepY[step]) {
+				out[n++] = TRACE_POSITION << 4 | a[0];
+				out[n++] = step | (a[3] - state->turn) << 3;
+				traceUpdate(state, record);
+				return n;
+			}
+		}
+	}
+	if (record->kind == LOG_MOVE && known && (a[1] == state->turn || a[1] == state->turn + 1) && a[2] == state->turns[a[0]] + 1) {
+		out[n++] = TRACE_MOVE << 4 | a[0];
+		out[n++] = directionCode(record->text) | (a[1] - state->turn) << 3;
+		traceUpdate(state, record);
+		return n;
+	}
+	out[n++] = TRACE_RECORD << 4 | record->kind;
+	int arg = 0;
+	for (const char *sig = signatures[record->kind]; *sig != '\0'; sig++) {
+		if (*sig == 's') {
+			n += putVarint(out + n, zigzag(directionCode(record->text)));
+		} else {
+			n += putVarint(out + n, zigzag(a[arg++]));
+		}
+	}
+	traceUpdate(state, record);
+	return n;
+}
+
+// decodes the record whose first byte was 'first'; false if it is not one
+static bool decodeRecord(FILE *trace, int first, traceState_t *state, logRecord_t *record) {
+	int tag = first >> 4;
+	int low = first & 0xf;
+	int *a = record->args;
+	memset(record, 0, sizeof(*record));
+	if (tag == TRACE_POSITION || tag == TRACE_MOVE) {
+		int second = getc(trace);
+		int code = second & 0x7;
+		int next = (second >> 3) & 1;
+		if (second == EOF || (second >> 4) != 0 || code >= (tag == TRACE_POSITION ? NUM_STEPS : NUM_DIRECTIONS)) {
+			return false;
+		}
+		a[0] = low;
+		if (tag == TRACE_POSITION) {
+			record->kind = LOG_POSITION;
+			a[1] = state->x[low] + stepX[code];
+			a[2] = state->y[low] + stepY[code];
+			a[3] = state->turn + next;
+		} else {
+			record->kind = LOG_MOVE;
+			record->text = directions[code];
+			a[1] = state->turn + next;
+			a[2] = state->turns[low] + 1;
+		}
+	} else if (tag == TRACE_RECORD && low < LOG_NUM_KINDS) {
+		record->kind = low;
+		int arg = 0;
+		for (const char *sig = signatures[low]; *sig != '\0'; sig++) {
+			int value;
+			if (!getInt(trace, &value)) {
+				return false;
+			}
+			if (*sig != 's') {
+				a[arg++] = value;
+			} else if (value >= 0 && value < NUM_DIRECTIONS) {
+				record->text = directions[value];
+			} else {
+				return false;
+			}
+		}
+	} else {
+		return false;
+	}
+	traceUpdate(state, record);
+	return true;
+}
+
+// puts a record into buf as a line of text or as trace bytes; returns the bytes used
+static int emitRecord(logger_t *logger, char *buf, logRecord_t *record) {
+	if (logger->trace) {
+		return encodeRecord((unsigned char *)buf, &logger->state, record);
+	}
+	int n = formatRecord(buf, LOGGER_LINE_MAX, record);
+	return n < LOGGER_LINE_MAX ? n : LOGGER_LINE_MAX - 1;
+}
+
+static void sleepNanos(long nanos) {
+	struct timespec pause = { 0, nanos };
+	nanosleep(&pause, NULL);
+}
+
+/*
+ * Moves the record numbered 'seq' into the batch if it has been pushed. Every ring holds its
+ * records in seq order, so the next record to write is always at the tail of one of them.
+ */
+static bool takeRecord(logger_t *logger, unsigned long long seq, char *batch, size_t *length) {
+	for (int k = 0; k < logger->nAvatars; k++) {
+		logRing_t *ring = &logger->rings[k];
+		size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+		if (tail == atomic_load_explicit(&ring->head, memory_order_acquire)) {
+			continue;
+		}
+		logRecord_t *record = &ring->records[tail % LOGGER_RING_SIZE];
+		if (record->seq != seq) {
+			continue;
+		}
+		*length += emitRecord(logger, batch + *length, record);
+		atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+		return true;
+	}
+	return false;
+}
+
+/*
+ *	Writer thread: writes records in seq order, a batch at a time, until stopped with every ring empty
+ */
+static void *writeLoop(void *arg) {
+	logger_t *logger = arg;
+	char *batch = malloc(LOGGER_BATCH);
+	unsigned long long expected = 0;
+	bool unflushed = false;
+	while (true) {
+		bool stopping = atomic_load(&logger->stopping);
+		size_t length = 0;
+		while (length + LOGGER_LINE_MAX <= LOGGER_BATCH && takeRecord(logger, expected, batch, &length)) {
+			expected++;
+		}
+		if (length > 0) {
+			fwrite(batch, 1, length, logger->fp);
+			logger->writes++;
+			unflushed = true;
+			continue;
+		}
+
+		// nothing to write: either every ring is empty or the next record is still being pushed
+		if (atomic_load(&logger->nextSeq) == expected) {
+			if (unflushed) {
+				fflush(logger->fp);
+				unflushed = false;
+			}
+			atomic_store(&logger->flushed, expected);
+			if (stopping) {
+				break;
+			}
+			sleepNanos(LOGGER_IDLE_NANOS);
+		} else {
+			sched_yield();
+		}
+	}
+	free(batch);
+	return NULL;
+}
+
+logger_t *loggerNew(FILE *fp, int nAvatars) {
+	logger_t *logger = malloc(sizeof(logger_t));
+	logRing_t *rings = aligned_alloc(_Alignof(logRing_t), nAvatars * sizeof(logRing_t));
+	if (logger == NULL || rings == NULL) {
+		fprintf(stderr, "Failed to malloc for logger\n");
+		free(logger);
+		free(rings);
+		return NULL;
+	}
+	for (int k = 0; k < nAvatars; k++) {
+		atomic_init(&rings[k].head, 0);
+		atomic_init(&rings[k].tail, 0);
+		rings[k].stalls = 0;
+	}
+	logger->fp = fp;
+	logger->trace = false;
+	memset(&logger->state, 0, sizeof(logger->state));
+	logger->nAvatars = nAvatars;
+	logger->rings = rings;
+	logger->writes = 0;
+	atomic_init(&logger->nextSeq, 0);
+	atomic_init(&logger->flushed, 0);
+	atomic_init(&logger->stopping, false);
+	logger->running = pthread_create(&logger->thread, NULL, writeLoop, logger) == 0;
+	if (!logger->running) {
+		fprintf(stderr, "Failed to start the log writer thread\n");
+		free(rings);
+		free(logger);
+		return NULL;
+	}
+	return logger;
+}
+
+logger_t *loggerNewTrace(FILE *fp, const traceHeader_t *header) {
+	// the header, then the writer starts on the records
+	unsigned char out[LOGGER_LINE_MAX];
+	size_t userLength = strnlen(header->user, sizeof(header->user) - 1);
+	size_t n = strlen(LOGGER_TRACE_MAGIC);
+	memcpy(out, LOGGER_TRACE_MAGIC, n);
+	n += putVarint(out + n, userLength);
+	memcpy(out + n, header->user, userLength);
+	n += userLength;
+	n += putVarint(out + n, zigzag(header->mazePort));
+	n += putVarint(out + n, zigzag(header->startTime));
+	n += putVarint(out + n, zigzag(header->difficulty));
+	n += putVarint(out + n, zigzag(header->nAvatars));
+	n += putVarint(out + n, zigzag(header->height));
+	n += putVarint(out + n, zigzag(header->width));
+	if (fwrite(out, 1, n, fp) != n) {
+		fprintf(stderr, "Failed to write the trace header\n");
+		return NULL;
+	}
+	logger_t *logger = loggerNew(fp, header->nAvatars);
+	if (logger != NULL) {
+		logger->trace = true;
+	}
+	return logger;
+}
+
+void loggerPush(logger_t *logger, int avatarID, logKind_t kind, ...) {
+	if (logger == NULL || kind < 0 || kind >= LOG_NUM_KINDS) {
+		return;
+	}
+	logRecord_t record = { 0, kind, { 0 }, NULL };
+	va_list ap;
+	va_start(ap, kind);
+	int nArgs = 0;
+	for (const char *sig = signatures[kind]; *sig != '\0'; sig++) {
+		if (*sig == 's') {
+			record.text = va_arg(ap, const char *);
+		} else {
+			record.args[nArgs++] = va_arg(ap, int);
+		}
+	}
+	va_end(ap);
+
+	// once the writer has stopped, whoever pushes writes the line
+	if (!logger->running) {
+		char line[LOGGER_LINE_MAX];
+		record.seq = atomic_fetch_add(&logger->nextSeq, 1);
+		fwrite(line, 1, emitRecord(logger, line, &record), logger->fp);
+		atomic_store(&logger->flushed, record.seq + 1);
+		return;
+	}
+
+	// wait for room first, so that a seq once taken is published straight away
+	logRing_t *ring = &logger->rings[avatarID];
+	size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+	if (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= LOGGER_RING_SIZE) {
+		ring->stalls++;
+		while (head - atomic_load_explicit(&ring->tail, memory_order_acquire) >= LOGGER_RING_SIZE) {
+			sched_yield();
+		}
+	}
+	record.seq = atomic_fetch_add(&logger->nextSeq, 1);
+	ring->records[head % LOGGER_RING_SIZE] = record;
+	atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+}
+
+void loggerFlush(logger_t *logger) {
+	if (logger == NULL) {
+		return;
+	}
+	if (!logger->running) {
+		fflush(logger->fp);
+		return;
+	}
+	unsigned long long target = atomic_load(&logger->nextSeq);
+	while (atomic_load(&logger->flushed) < target) {
+		sched_yield();
+	}
+}
+
+void loggerLine(logger_t *logger, const char *format, ...) {
+	if (logger == NULL) {
+		return;
+	}
+	loggerFlush(logger);
+	va_list ap;
+	va_start(ap, format);
+	int length = vsnprintf(NULL, 0, format, ap);
+	va_end(ap);
+	char *text = malloc(length + 1);
+	if (length < 0 || text == NULL) {
+		free(text);
+		return;
+	}
+	va_start(ap, format);
+	vsnprintf(text, length + 1, format, ap);
+	va_end(ap);
+	if (logger->trace) {
+		unsigned char head[16];
+		head[0] = TRACE_TEXT << 4;
+		fwrite(head, 1, 1 + putVarint(head + 1, length), logger->fp);
+	}
+	fwrite(text, 1, length, logger->fp);
+	free(text);
+}
+
+void loggerStop(logger_t *logger) {
+	if (logger == NULL || !logger->running) {
+		return;
+	}
+	atomic_store(&logger->stopping, true);
+	pthread_join(logger->thread, NULL);
+	logger->running = false;
+}
+
+void loggerReport(logger_t *logger, FILE *fp) {
+	long stalls = 0;
+	for (int k = 0; k < logger->nAvatars; k++) {
+		stalls += logger->rings[k].stalls;
+	}
+	unsigned long long records = atomic_load(&logger->nextSeq);
+	fprintf(fp, "Log writer: %llu lines in %ld writes (%.1f lines per write), %ld pushes waited for a full ring\n",
+			records, logger->writes, logger->writes > 0 ? (double)records / logger->writes : 0.0, stalls);
+}
+
+long loggerConvert(FILE *trace, FILE *text, traceHeader_t *header) {
+	// the header, and from it the first line of the log
+	traceHeader_t read;
+	memset(&read, 0, sizeof(read));
+	char magic[sizeof(LOGGER_TRACE_MAGIC)];
+	size_t magicLength = strlen(LOGGER_TRACE_MAGIC);
+	unsigned long long userLength;
+	if (fread(magic, 1, magicLength, trace) != magicLength || memcmp(magic, LOGGER_TRACE_MAGIC, magicLength) != 0
+			|| !getVarint(trace, &userLength) || userLength >= sizeof(read.user)
+			|| fread(read.user, 1, userLength, trace) != userLength) {
+		return -1;
+	}
+	unsigned long long fields[6];
+	for (int f = 0; f < 6; f++) {
+		if (!getVarint(trace, &fields[f])) {
+			return -1;
+		}
+	}
+	read.mazePort = unzigzag(fields[0]);
+	read.startTime = unzigzag(fields[1]);
+	read.difficulty = unzigzag(fields[2]);
+	read.nAvatars = unzigzag(fields[3]);
+	read.height = unzigzag(fields[4]);
+	read.width = unzigzag(fields[5]);
+	if (header != NULL) {
+		*header = read;
+	}
+	time_t startTime = read.startTime;
+	fprintf(text, "%s, %d, %s\n", read.user, read.mazePort, asctime(localtime(&startTime)));
+
+	// then the records, each as the line it stands for
+	traceState_t state;
+	memset(&state, 0, sizeof(state));
+	long records = 0;
+	int first;
+	while ((first = getc(trace)) != EOF) {
+		if (first == TRACE_TEXT << 4) {
+			unsigned long long length;
+			if (!getVarint(trace, &length)) {
+				return -1;
+			}
+			for (unsigned long long i = 0; i < length; i++) {
+				int c = getc(trace);
+				if (c == EOF) {
+					return -1;
+				}
+				putc(c, text);
+			}
+			continue;
+		}
+		logRecord_t record;
+		char line[LOGGER_LINE_MAX];
+		if (!decodeRecord(trace, first, &state, &record)) {
+			return -1;
+		}
+		formatRecord(line, sizeof(line), &record);
+		fputs(line, text);
+		records++;
+	}
+	return records;
+}
+
+void loggerDelete(logger_t *logger) {
+	if (logger != NULL) {
+		loggerStop(logger);
+		free(logger->rings);
+		free(logger);
+	}
+}
@@ -0,0 +1,184 @@
+/*
+ * logger.h - header file for logger module
+ *
+ * This module writes the game log off the avatars' threads. An avatar pushes a small fixed-size
+ * record (what happened and its numbers) into a ring of its own, which no other thread writes, and
+ * carries on; a writer thread takes the records from all the rings in the order they were pushed,
+ * formats them into the same lines the avatars used to fprintf, and writes them in batches.
+ *
+ * A logger made with loggerNewTrace() writes a binary trace instead: a header, then each record
+ * in a few bytes, positions and turns as differences from the ones before. loggerConvert() (and
+ * the amtrace program) turns a trace back into the text log, line for line.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __LOGGER_H
+#define __LOGGER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/**************** constants ****************/
+
+// records each avatar's ring holds; a push waits while its ring is full (a power of two)
+#define LOGGER_RING_SIZE 4096
+
+// first bytes of a trace file
+#define LOGGER_TRACE_MAGIC "AMTRACE1"
+
+/*
+ * The lines of the log. The arguments each kind takes after the kind are in the comment;
+ * 'direction' is one of parseDirection()'s strings (see avatar.h), everything else an int.
+ * A trace keeps each kind in 4 bits, so there can be at most 16.
+ */
+typedef enum logKind {
+	LOG_INITIAL_POSITION,     // avatar, x, y
+	LOG_POSITION,             // avatar, x, y, turn
+	LOG_MOVE,                 // avatar, direction, turn, avatar's turn
+	LOG_SOLVED,               // avatars, difficulty, moves, hash
+	LOG_MOVE_LIMIT,           // turn
+	LOG_NO_SUCH_AVATAR,       // avatar
+	LOG_OUT_OF_TURN,          // avatar, turn
+	LOG_SERVER_TIMEOUT,       // turn
+	LOG_UNKNOWN_MESSAGE,      // turn
+	LOG_UNEXPECTED_MESSAGE,   // message type, turn
+	LOG_LOOP,                 // avatar, x, y, direction, loop length, turn
+	LOG_WASTED,               // avatar, moves wasted, into walls, round loops
+	LOG_RENDEZVOUS,           // x, y, steps away, turn
+	LOG_NUM_KINDS
+} logKind_t;
+
+/**************** structs ****************/
+
+/**************** traceHeader ****************/
+/*
+ * What a trace starts with: everything the first line of a text log shows, and the game's size.
+ */
+typedef struct traceHeader {
+	char user[64];
+	int mazePort;
+	long long startTime;      // seconds since the epoch, as from time()
+	int difficulty;
+	int nAvatars;
+	int height;
+	int width;
+} traceHeader_t;
+
+/**************** logger ****************/
+/*
+ * The rings, the writer thread and the log file. See logger.c for details.
+ */
+typedef struct logger logger_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** loggerNew ****************/
+/*
+ * Function which starts the writer thread.
+ *
+ * Input: File to write the log to (left open), number of avatars, each of which gets a ring.
+ *
+ * Output: The logger, or NULL if memory could not be allocated or the thread not started.
+ *
+ */
+logger_t *loggerNew(FILE *fp, int nAvatars);
+
+/**************** loggerNewTrace ****************/
+/*
+ * Function which writes a trace header and starts a writer thread that writes a binary trace.
+ *
+ * Input: File to write the trace to (left open), header, whose nAvatars avatars each get a ring.
+ *
+ * Output: The logger, or NULL if memory could not be allocated, the thread not started or the header not written.
+ *
+ */
+logger_t *loggerNewTrace(FILE *fp, const traceHeader_t *header);
+
+/**************** loggerPush ****************/
+/*
+ * Function which logs one line without formatting or writing it. Only one thread may push for a
+ * given avatar at a time (its own thread, or the event loop). Waits only while the avatar's ring
+ * is full. Lines come out in the order they were pushed, whichever avatars pushed them.
+ *
+ * Input: Logger (NULL logs nothing), avatar whose ring to use, kind of line, its arguments.
+ *
+ * Output: None.
+ *
+ */
+void loggerPush(logger_t *logger, int avatarID, logKind_t kind, ...);
+
+/**************** loggerFlush ****************/
+/*
+ * Function which waits until every line pushed so far is written and the file flushed, e.g.
+ * before writing to the file directly.
+ *
+ * Input: Logger, or NULL.
+ *
+ * Output: None.
+ *
+ */
+void loggerFlush(logger_t *logger);
+
+/**************** loggerLine ****************/
+/*
+ * Function which writes text of the caller's own, e.g. a report, after every line pushed so far:
+ * as it is to a text log, as a text record to a trace. Call it while no avatar is pushing.
+ *
+ * Input: Logger, printf format and its arguments.
+ *
+ * Output: None.
+ *
+ */
+void loggerLine(logger_t *logger, const char *format, ...);
+
+/**************** loggerStop ****************/
+/*
+ * Function which writes every line pushed so far and stops the writer thread. Lines pushed after
+ * this are written straight away by the caller, so call it once no avatar is pushing any more.
+ *
+ * Input: Logger, or NULL.
+ *
+ * Output: None.
+ *
+ */
+void loggerStop(logger_t *logger);
+
+/**************** loggerReport ****************/
+/*
+ * Function which prints how many lines were logged, in how many writes, and how often a push
+ * had to wait for a full ring. Call it after loggerStop().
+ *
+ * Input: Logger, where to print.
+ *
+ * Output: None.
+ *
+ */
+void loggerReport(logger_t *logger, FILE *fp);
+
+/**************** loggerConvert ****************/
+/*
+ * Function which writes the text log a trace stands for: the first line, then every line logged,
+ * exactly as a text logger would have written them.
+ *
+ * Input: Trace to read from the start, file to write the text to, where to put the trace's header (or NULL).
+ *
+ * Output: Number of records converted, or -1 if the trace is not one or is cut short.
+ *
+ */
+long loggerConvert(FILE *trace, FILE *text, traceHeader_t *header);
+
+/**************** loggerDelete ****************/
+/*
+ * Function which stops the logger if it is still running and frees it. The file is left open.
+ *
+ * Input: Logger, or NULL.
+ *
+ * Output: None.
+ *
+ */
+void loggerDelete(logger_t *logger);
+
+#endif // __LOGGER_H
@@ -0,0 +1,271 @@
+/*
+ * loggertest.c, a testing module for the log writer in logger.c
+ *
+ * Every kind of line must come out exactly as the avatars used to fprintf it. Several threads
+ * then push at once, taking turns through a lock as avatars do; the file must hold every line,
+ * in the order they were pushed. Lines pushed after the writer stops must still be written.
+ * A game of random walks is then logged both as text and as a binary trace; converted back, the
+ * trace must give the text byte for byte, and both sizes and times are printed. Last, a push is
+ * timed against formatting and writing the same line with fprintf.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include "latency.h"
+#include "logger.h"
+#include "testing.h"
+
+/**************** file-local constants ****************/
+#define NUM_THREADS 8
+#define NUM_PUSHES 100000         // per thread
+#define NUM_TIMED (256 * LOGGER_RING_SIZE)
+#define GAME_AVATARS 4
+#define GAME_TURNS 50000
+
+static pthread_mutex_t turnLock = PTHREAD_MUTEX_INITIALIZER;
+static int turn = 0;              // lines pushed so far by all threads, under turnLock
+
+typedef struct producer {
+	logger_t *logger;
+	int id;
+} producer_t;
+
+/**************** file-local functions ****************/
+
+// reads all of a file
+static char *slurp(FILE *fp) {
+	fflush(fp);
+	long size = ftell(fp);
+	char *text = calloc(size + 1, 1);
+	rewind(fp);
+	if (fread(text, 1, size, fp) != size) {
+		text[0] = '\0';
+	}
+	fseek(fp, 0, SEEK_END);
+	return text;
+}
+
+// pushes lines numbered by the turn they were pushed on, like an avatar logging its turn
+static void *produce(void *arg) {
+	producer_t *producer = arg;
+	for (int i = 0; i < NUM_PUSHES; i++) {
+		pthread_mutex_lock(&turnLock);
+		loggerPush(producer->logger, producer->id, LOG_POSITION, producer->id, i, i % 7, turn++);
+		pthread_mutex_unlock(&turnLock);
+	}
+	return NULL;
+}
+
+// logs a made-up game of random walks: every turn each avatar's position, then one avatar's move
+static void playGame(logger_t *logger) {
+	const char *names[] = { "west", "north", "south", "east", "no direction (NULL_MOVE)" };
+	int x[GAME_AVATARS], y[GAME_AVATARS], turns[GAME_AVATARS] = { 0 };
+	unsigned int seed = 1;
+	for (int id = 0; id < GAME_AVATARS; id++) {
+		x[id] = rand_r(&seed) % 100;
+		y[id] = rand_r(&seed) % 100;
+		loggerPush(logger, id, LOG_INITIAL_POSITION, id, x[id], y[id]);
+	}
+	for (int turn = 1; turn <= GAME_TURNS; turn++) {
+		int mover = turn % GAME_AVATARS;
+		for (int id = 0; id < GAME_AVATARS; id++) {
+			loggerPush(logger, mover, LOG_POSITION, id, x[id], y[id], turn);
+		}
+		int direction = rand_r(&seed) % 5;
+		if (direction < 4 && rand_r(&seed) % 3 != 0) {
+			x[mover] += direction == 0 ? -1 : direction == 3 ? 1 : 0;
+			y[mover] += direction == 1 ? -1 : direction == 2 ? 1 : 0;
+		} else if (rand_r(&seed) % 50 == 0) {
+			x[mover] = rand_r(&seed) % 100;   // a jump no step explains
+		}
+		loggerPush(logger, mover, LOG_MOVE, mover, names[direction], turn, ++turns[mover]);
+		if (turn % 1000 == 0) {
+			loggerPush(logger, mover, LOG_RENDEZVOUS, x[mover], y[mover], turn % 37, turn + 1);
+		}
+	}
+	loggerPush(logger, 0, LOG_SOLVED, GAME_AVATARS, 3, GAME_TURNS, -123456789);
+}
+
+// Testing function
+int main(int argc, char *argv[]) {
+	// one line of each kind, against the formats avatar.c and strategy.c used
+	FILE *logged = tmpfile();
+	FILE *expected = tmpfile();
+	logger_t *logger = loggerNew(logged, 2);
+	check(logger != NULL, "loggerNew starts the writer");
+	loggerPush(logger, 0, LOG_INITIAL_POSITION, 0, 3, 4);
+	fprintf(expected, "Initial position of Avatar %d is (%d, %d)\n", 0, 3, 4);
+	loggerPush(logger, 1, LOG_POSITION, 1, 5, 6, 7);
+	fprintf(expected, "Avatar %d at (%d,%d) on turn %d\n", 1, 5, 6, 7);
+	loggerPush(logger, 0, LOG_MOVE, 0, "north", 8, 4);
+	fprintf(expected, "Avatar %d tries to move in direction %s on turn %d, which is turn %d for the  avatar\n", 0, "north", 8, 4);
+	loggerPush(logger, 1, LOG_SOLVED, 2, 3, 120, -5);
+	fprintf(expected, "Solved!  Number of avatars: %d, difficulty: %d number of moves: %d, hash: %d\n", 2, 3, 120, -5);
+	loggerPush(logger, 0, LOG_MOVE_LIMIT, 9);
+	fprintf(expected, "Move limit reached at turn %d\n", 9);
+	loggerPush(logger, 1, LOG_NO_SUCH_AVATAR, 1);
+	fprintf(expected, "Avatar %d does not exist\n", 1);
+	loggerPush(logger, 1, LOG_OUT_OF_TURN, 1, 10);
+	fprintf(expected, "Avatar %d moving out of turn on turn %d\n", 1, 10);
+	loggerPush(logger, 0, LOG_SERVER_TIMEOUT, 11);
+	fprintf(expected, "Server timeout occured on turn %d\n", 11);
+	loggerPush(logger, 0, LOG_UNKNOWN_MESSAGE, 12);
+	fprintf(expected, "Unknown message received on turn %d\n", 12);
+	loggerPush(logger, 1, LOG_UNEXPECTED_MESSAGE, 4, 13);
+	fprintf(expected, "Unexpected message of type %d received on turn %d\n", 4, 13);
+	loggerPush(logger, 0, LOG_LOOP, 0, 1, 2, "west", 16, 14);
+	fprintf(expected, "Avatar %d is back on (%d,%d) facing %s after a %d move loop on turn %d, switching to Tremaux marking\n", 0, 1, 2, "west", 16, 14);
+	loggerPush(logger, 1, LOG_WASTED, 1, 30, 20, 10);
+	fprintf(expected, "Avatar %d wasted %d moves: %d into walls, %d going round loops\n", 1, 30, 20, 10);
+	loggerPush(logger, 0, LOG_RENDEZVOUS, 5, 5, 12, 15);
+	fprintf(expected, "Avatars now meet at (%d,%d), %d steps away, on turn %d\n", 5, 5, 12, 15);
+	loggerPush(NULL, 0, LOG_MOVE_LIMIT, 1);
+	loggerFlush(logger);
+	char *got = slurp(logged);
+	char *want = slurp(expected);
+	check(strcmp(got, want) == 0, "every kind of line is written as it was fprintf'd");
+	free(got);
+	free(want);
+
+	// after the writer stops, pushes are written straight away
+	loggerStop(logger);
+	loggerPush(logger, 0, LOG_MOVE_LIMIT, 99);
+	fprintf(expected, "Move limit reached at turn %d\n", 99);
+	got = slurp(logged);
+	want = slurp(expected);
+	check(strcmp(got, want) == 0, "a push after loggerStop is written");
+	free(got);
+	free(want);
+	loggerDelete(logger);
+	fclose(logged);
+	fclose(expected);
+
+	// several threads at once: every line, in the order they were pushed
+	logged = tmpfile();
+	logger = loggerNew(logged, NUM_THREADS);
+	pthread_t threads[NUM_THREADS];
+	producer_t producers[NUM_THREADS];
+	long long start = latencyNow();
+	for (int t = 0; t < NUM_THREADS; t++) {
+		producers[t].logger = logger;
+		producers[t].id = t;
+		pthread_create(&threads[t], NULL, produce, &producers[t]);
+	}
+	for (int t = 0; t < NUM_THREADS; t++) {
+		pthread_join(threads[t], NULL);
+	}
+	loggerStop(logger);
+	double seconds = (latencyNow() - start) / 1e9;
+	loggerReport(logger, stdout);
+	printf("%d threads pushed %d lines in %.3f s\n", NUM_THREADS, NUM_THREADS * NUM_PUSHES, seconds);
+
+	rewind(logged);
+	int lines = 0, inOrder = 0, exact = 0;
+	int next[NUM_THREADS] = { 0 };
+	char line[256], again[256];
+	while (fgets(line, sizeof(line), logged) != NULL) {
+		int id, i, y, on;
+		if (sscanf(line, "Avatar %d at (%d,%d) on turn %d", &id, &i, &y, &on) == 4 && id >= 0 && id < NUM_THREADS) {
+			if (on == lines && i == next[id]) {
+				inOrder++;
+			}
+			next[id] = i + 1;
+			snprintf(again, sizeof(again), "Avatar %d at (%d,%d) on turn %d\n", id, i, i % 7, lines);
+			exact += strcmp(line, again) == 0;
+		}
+		lines++;
+	}
+	check(lines == NUM_THREADS * NUM_PUSHES, "every pushed line is written");
+	check(inOrder == lines, "lines are written in the order they were pushed");
+	check(exact == lines, "every line is written whole");
+	loggerDelete(logger);
+	fclose(logged);
+
+	// the same game as text and as a trace
+	logged = tmpfile();
+	expected = tmpfile();
+	traceHeader_t header = { "amtest", 10829, 1583800000, 3, GAME_AVATARS, 100, 100 };
+	fprintf(expected, "%s, %d, %s\n", header.user, header.mazePort, asctime(localtime(&(time_t){ header.startTime })));
+	start = latencyNow();
+	logger = loggerNew(expected, GAME_AVATARS);
+	playGame(logger);
+	loggerLine(logger, "Connected %d avatars\n", GAME_AVATARS);
+	loggerStop(logger);
+	double textSeconds = (latencyNow() - start) / 1e9;
+	loggerDelete(logger);
+	start = latencyNow();
+	logger = loggerNewTrace(logged, &header);
+	check(logger != NULL, "loggerNewTrace writes the header");
+	playGame(logger);
+	loggerLine(logger, "Connected %d avatars\n", GAME_AVATARS);
+	loggerStop(logger);
+	double traceSeconds = (latencyNow() - start) / 1e9;
+	loggerDelete(logger);
+	long textBytes = ftell(expected);
+	long traceBytes = ftell(logged);
+	printf("Game of %d turns: text %ld bytes in %.3f s, trace %ld bytes in %.3f s (%.1fx smaller)\n", GAME_TURNS,
+			textBytes, textSeconds, traceBytes, traceSeconds, (double)textBytes / traceBytes);
+	check(traceBytes * 10 <= textBytes, "a trace is at least 10x smaller than the text");
+
+	FILE *converted = tmpfile();
+	rewind(logged);
+	traceHeader_t read;
+	long records = loggerConvert(logged, converted, &read);
+	check(records == GAME_AVATARS + GAME_TURNS * (GAME_AVATARS + 1) + GAME_TURNS / 1000 + 1, "every record is converted");
+	check(strcmp(read.user, "amtest") == 0 && read.mazePort == 10829 && read.difficulty == 3 && read.nAvatars == GAME_AVATARS
+			&& read.height == 100 && read.width == 100, "the header comes back");
+	got = slurp(converted);
+	want = slurp(expected);
+	check(strcmp(got, want) == 0, "a converted trace is the text log byte for byte");
+	free(got);
+	free(want);
+
+	// a trace cut short is refused
+	rewind(logged);
+	FILE *cut = tmpfile();
+	for (long i = 0; i < traceBytes - 1; i++) {
+		putc(getc(logged), cut);
+	}
+	rewind(cut);
+	check(loggerConvert(cut, converted, NULL) == -1, "a trace cut short is refused");
+	fclose(cut);
+	fclose(converted);
+	fclose(logged);
+	fclose(expected);
+
+	// the cost of a push, in bursts the ring holds as a game's turns do, next to fprintf'ing the line
+	logged = tmpfile();
+	logger = loggerNew(logged, 1);
+	double pushed = 0;
+	for (int i = 0; i < NUM_TIMED; i += LOGGER_RING_SIZE) {
+		start = latencyNow();
+		for (int j = i; j < i + LOGGER_RING_SIZE; j++) {
+			loggerPush(logger, 0, LOG_MOVE, 0, "south", j, j);
+		}
+		pushed += (latencyNow() - start) / 1e9;
+		loggerFlush(logger);
+	}
+	loggerStop(logger);
+	loggerDelete(logger);
+	fclose(logged);
+
+	logged = tmpfile();
+	start = latencyNow();
+	for (int i = 0; i < NUM_TIMED; i++) {
+		fprintf(logged, "Avatar %d tries to move in direction %s on turn %d, which is turn %d for the  avatar\n", 0, "south", i, i);
+	}
+	double printed = (latencyNow() - start) / 1e9;
+	fclose(logged);
+	printf("loggerPush: %.1f ns per line, fprintf: %.1f ns per line\n", pushed * 1e9 / NUM_TIMED, printed * 1e9 / NUM_TIMED);
+
+	return testResults();
+}
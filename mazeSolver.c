@@ -1,5 +1,5 @@
 /* 
- * mazeSolver.c, a module containing many useful functions for creating and deleting a 2D array of mazetiles. 
+ * mazeSolver.c, a module containing many useful functions for creating, updating and deleting the maze wall grid. 
  *
  * Written by:
  * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
@@ -9,136 +9,242 @@
 #include <stdlib.h>
 #include <string.h>           // memcpy, memset
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>    // lock-free wall updates shared by all avatar threads
 #include "amazing.h"
 #include "avatar.h"
 #include "mazeSolver.h"
 
-// Function which takes in an xcoordinate, y coordinate and initilaises a new mazeTile_t struct
-mazeTile_t *mazeTileNew(int xCoord, int yCoord){
+const int deltaX[M_NUM_DIRECTIONS] = { -1, 0, 0, 1 };
+const int deltaY[M_NUM_DIRECTIONS] = { 0, -1, 1, 0 };
 
-	// allocate memory space for mazeTile creation 
-	mazeTile_t *mazeTile = malloc(sizeof(mazeTile_t));
-
-	// check that the memory space was allocated 
-	if (mazeTile != NULL){
-
-		// set pointers to desired initialised values 
-		mazeTile->xCoord = xCoord;
-		mazeTile->yCoord = yCoord; 
-		mazeTile->northWall = false;
-		mazeTile->southWall = false;
-		mazeTile->eastWall = false;
-		mazeTile->westWall = false;
-		mazeTile->visited = -1;
-
-		// return the mazetile
-		return mazeTile; 
-	} 
-
-	// if there was a failure in allocating memory space
-	else {
-		fprintf(stderr, "Failed to malloc for mazeTile\n");
-		return NULL;
-	}
+/*
+ * The whole maze lives in one allocation: the header below followed by two edge bitsets,
+ * one marking edges known to be walls and one marking edges known to be open. An edge in
+ * neither set has not been probed yet. Every edge is stored exactly once, so the wall west
+ * of (x,y) is the same bit as the wall east of (x-1,y).
+ *
+ * Edges are numbered horizontal first: (height+1) rows of width edges (the edge north of
+ * row y is row y, south of it is row y+1). The vertical edges follow from the word-aligned
+ * verticalBase: height rows of (width+1) edges (the edge west of column x is column x, east
+ * of it is column x+1).
+ *
+ * The words are atomic: avatar threads publish edges with a release fetch-or and read
+ * them with acquire loads, so no lock is needed to share the map between threads.
+ *
+ * Every wall that is newly set is also appended to an event log, so planners can repair
+ * their paths around just the walls discovered since they last looked. The log follows the
+ * bitsets and holds one 32-bit slot per real edge, since each wall is logged once. A writer
+ * reserves a slot with a release fetch-add, after setting the wall bit, and then publishes
+ * (edge + 1) into it; a reader stops at the first slot that is still 0. Reading the count
+ * with acquire therefore also shows the wall bits of every slot below it.
+ */
+typedef struct maze {
+	int height;
+	int width;
+	size_t verticalBase;
+	size_t words;
+	size_t edges;
+	_Atomic uint64_t *walls;
+	_Atomic uint64_t *open;
+	_Atomic uint32_t *events;     // one slot per edge, since each wall is logged once
+	_Atomic size_t eventCount;
+	_Atomic uint64_t bits[];
+} maze_t;
+
+#define WORD_BITS 64
+
+// number of 64-bit words needed to hold 'count' edge bits
+static size_t edgeWords(size_t count) {
+	return (count + WORD_BITS - 1) / WORD_BITS;
 }
 
-// Function that adds wall to the 2D MazeTile Array after an avatar runs into a wall
-void addWall(mazeTile_t ***maze, int x, int y, int direction) {
-
-	// if the direction that the avatar failed to move in was north, set north wall true
+// finds the bit index of the edge on the given side of a tile
+static size_t edgeIndex(maze_t *maze, int x, int y, int direction) {
 	if (direction == M_NORTH) {
-		maze[y][x]->northWall = true;
-		maze[y-1][x]->southWall = true;
+		return (size_t)y * maze->width + x;
 	}
-
-	// if the direction that the avatar failed to move in was south, set north wall true
 	else if (direction == M_SOUTH) {
-		maze[y][x]->southWall = true;
-		maze[y+1][x]->northWall = true;
-	}
-
-	// if the direction that the avatar failed to move in was east, set east wall true
-	else if (direction == M_EAST) {
-		maze[y][x]->eastWall = true;
-		maze[y][x+1]->westWall = true;
+		return (size_t)(y + 1) * maze->width + x;
 	}
-
-	// if the direction that the avatar failed to move in was west, set west wall true
 	else if (direction == M_WEST) {
-		maze[y][x]->westWall = true;
-		maze[y][x-1]->eastWall = true;
+		return maze->verticalBase + (size_t)y * (maze->width + 1) + x;
+	}
+	else {
+		return maze->verticalBase + (size_t)y * (maze->width + 1) + x + 1;
 	}
 }
 
+// sets a single edge bit in a bitset, publishing it to other threads; returns true if it was not already set
+static bool setEdge(_Atomic uint64_t *set, size_t bit) {
+	uint64_t mask = (uint64_t)1 << (bit % WORD_BITS);
+	return !(atomic_fetch_or_explicit(&set[bit / WORD_BITS], mask, memory_order_release) & mask);
+}
+
+// reads a single edge bit from a bitset, seeing every edge published before it
+static int getEdge(_Atomic uint64_t *set, size_t bit) {
+	return (atomic_load_explicit(&set[bit / WORD_BITS], memory_order_acquire) >> (bit % WORD_BITS)) & 1;
+}
 
-// function that creates the 2D array representing the maze 
-mazeTile_t ***createMaze(int height, int width) {
+// function that creates the wall grid representing the maze 
+maze_t *createMaze(int height, int width) {
 
-	// allocate space for the column of mazeTiles of a user-inputted height 
-	mazeTile_t ***tiles = (mazeTile_t ***)malloc(height * sizeof(mazeTile_t **));
+	// allocate the header, both edge bitsets and the wall event log in one block
+	size_t horizontalWords = edgeWords((size_t)(height + 1) * width);
+	size_t words = horizontalWords + edgeWords((size_t)height * (width + 1));
+	size_t edges = (size_t)(height + 1) * width + (size_t)height * (width + 1);
+	maze_t *maze = malloc(sizeof(maze_t) + 2 * words * sizeof(_Atomic uint64_t) + edges * sizeof(_Atomic uint32_t));
 
 	// safety check
-	if (tiles == NULL) {
-		fprintf(stderr, "Failed to malloc for tiles\n");
+	if (maze == NULL) {
+		fprintf(stderr, "Failed to malloc for maze\n");
 		return NULL;
 	}
+	maze->height = height;
+	maze->width = width;
+	maze->verticalBase = horizontalWords * WORD_BITS;
+	maze->words = words;
+	maze->edges = edges;
+	maze->walls = maze->bits;
+	maze->open = maze->bits + words;
+	maze->events = (_Atomic uint32_t *)(maze->bits + 2 * words);
+	atomic_init(&maze->eventCount, 0);
+	for (size_t i = 0; i < 2 * words; i++) {
+		atomic_init(&maze->bits[i], 0);
+	}
+	for (size_t i = 0; i < edges; i++) {
+		atomic_init(&maze->events[i], 0);
+	}
+
+	// the first and last rows have walls to the north and south respectively
+	for (int j = 0; j < width; j++) {
+		addWall(maze, j, 0, M_NORTH);
+		addWall(maze, j, height - 1, M_SOUTH);
+	}
 
-	// for whatever height the maze is
+	// the first and last columns have walls to the west and east respectively
 	for (int i = 0; i < height; i++) {
+		addWall(maze, 0, i, M_WEST);
+		addWall(maze, width - 1, i, M_EAST);
+	}
+	return maze;
+}
 
-		// allocate space for the row of mazeTiles of a user-inputted width 
-		tiles[i] = (mazeTile_t **)malloc(width * sizeof(mazeTile_t *));
+// function that frees all the memory space allocated in createMaze()
+void mazeDelete(maze_t *maze) {
+	free(maze);
+}
 
-		// safety check for memory allocation
-		if (tiles[i] == NULL) {
-			fprintf(stderr, "Failed to malloc for tiles[i]\n");
-			return NULL;
-		}
+int getMazeHeight(maze_t *maze) {
+	return maze->height;
+}
 
-		// loop through width number of times 
-		for (int j = 0; j < width; j++) {
+int getMazeWidth(maze_t *maze) {
+	return maze->width;
+}
 
-			// initialise a new mazeTile struct
-			tiles[i][j] = mazeTileNew(j, i);
+// Function that adds wall to the maze after an avatar runs into a wall
+void addWall(maze_t *maze, int x, int y, int direction) {
 
-			// for the entire first column, set the northwall to true
-			if (i == 0) {
-				tiles[i][j]->northWall = true;
-			}	
+	// ignore null moves and anything else that is not a wall
+	if (direction < 0 || direction >= M_NUM_DIRECTIONS) {
+		return;
+	}
 
-			// for the entire last column, set the southwall to true
-			if (i == height-1) {
-				tiles[i][j]->southWall = true;
-			}
+	// one bit is shared by this tile and its neighbour, so a single write records the wall for both
+	size_t bit = edgeIndex(maze, x, y, direction);
+	if (setEdge(maze->walls, bit)) {
+
+		// only the thread that set the bit logs it, so each wall appears in the log once
+		size_t slot = atomic_fetch_add_explicit(&maze->eventCount, 1, memory_order_acq_rel);
+		atomic_store_explicit(&maze->events[slot], (uint32_t)(bit + 1), memory_order_release);
+	}
+}
 
-			// for the entire first row, set westwall to true
-			if (j == 0) {
-				tiles[i][j]->westWall = true;
-			}
+// Function that returns the next wall added to the maze after the given point in the event log
+bool nextWallEvent(maze_t *maze, size_t *cursor, int *x, int *y, int *direction) {
 
-			// for the entire last row, set eastwall to true
-			if (j == width-1) {
-				tiles[i][j]->eastWall = true;
-			}
-		}
+	// a slot that is reserved but not yet published reads as 0; wait for it on a later call
+	if (*cursor >= maze->edges) {
+		return false;
 	}
-	return tiles;
+	uint32_t event = atomic_load_explicit(&maze->events[*cursor], memory_order_acquire);
+	if (event == 0) {
+		return false;
+	}
+	(*cursor)++;
+
+	// turn the edge number back into a tile and the side of it the wall is on
+	size_t bit = event - 1;
+	if (bit < maze->verticalBase) {
+		int row = bit / maze->width;
+		*x = bit % maze->width;
+		*y = row < maze->height ? row : row - 1;
+		*direction = row < maze->height ? M_NORTH : M_SOUTH;
+	}
+	else {
+		int column = (bit - maze->verticalBase) % (maze->width + 1);
+		*y = (bit - maze->verticalBase) / (maze->width + 1);
+		*x = column < maze->width ? column : column - 1;
+		*direction = column < maze->width ? M_WEST : M_EAST;
+	}
+	return true;
 }
 
+// Function that returns how many walls have been logged so far
+size_t getWallEventCount(maze_t *maze) {
+	return atomic_load_explicit(&maze->eventCount, memory_order_acquire);
+}
 
-// function that frees all the memory space allocated in createMaze()
-void mazeDelete(int height, int width, mazeTile_t ***tiles){
-	// loop through every column of the 2D array
-	for (int i = 0; i < height; i++) {
-		// loop through every row of the 2D array
-		for (int j = 0; j < width; j++) {
-			// free memory of every tile in the row
-			free(tiles[i][j]);
-		}
-		// free every column
-		free(tiles[i]);
+// Function that records an edge an avatar has moved through
+void addOpening(maze_t *maze, int x, int y, int direction) {
+
+	// ignore null moves and edges on the outer border
+	if (direction < 0 || direction >= M_NUM_DIRECTIONS) {
+		return;
+	}
+	if ((direction == M_WEST && x == 0) || (direction == M_EAST && x == maze->width - 1)
+			|| (direction == M_NORTH && y == 0) || (direction == M_SOUTH && y == maze->height - 1)) {
+		return;
 	}
-	// free the large 2D array tile struct
-	free(tiles);
+	setEdge(maze->open, edgeIndex(maze, x, y, direction));
+}
+
+// Function that returns the 4-bit wall mask of a tile
+int getWalls(maze_t *maze, int x, int y) {
+	return (getEdge(maze->walls, edgeIndex(maze, x, y, M_WEST)) << M_WEST)
+		| (getEdge(maze->walls, edgeIndex(maze, x, y, M_NORTH)) << M_NORTH)
+		| (getEdge(maze->walls, edgeIndex(maze, x, y, M_SOUTH)) << M_SOUTH)
+		| (getEdge(maze->walls, edgeIndex(maze, x, y, M_EAST)) << M_EAST);
 }
 
+// Function that returns the 4-bit mask of a tile's edges known to be open
+int getOpenings(maze_t *maze, int x, int y) {
+	return (getEdge(maze->open, edgeIndex(maze, x, y, M_WEST)) << M_WEST)
+		| (getEdge(maze->open, edgeIndex(maze, x, y, M_NORTH)) << M_NORTH)
+		| (getEdge(maze->open, edgeIndex(maze, x, y, M_SOUTH)) << M_SOUTH)
+		| (getEdge(maze->open, edgeIndex(maze, x, y, M_EAST)) << M_EAST);
+}
+
+// Function that checks for a single wall of a tile
+bool hasWall(maze_t *maze, int x, int y, int direction) {
+	if (direction < 0 || direction >= M_NUM_DIRECTIONS) {
+		return false;
+	}
+	return getEdge(maze->walls, edgeIndex(maze, x, y, direction));
+}
+
+// Function that returns what is known about a single edge of a tile
+int getEdgeState(maze_t *maze, int x, int y, int direction) {
+	if (direction < 0 || direction >= M_NUM_DIRECTIONS) {
+		return EDGE_UNKNOWN;
+	}
+	size_t bit = edgeIndex(maze, x, y, direction);
+	if (getEdge(maze->walls, bit)) {
+		return EDGE_WALL;
+	}
+	if (getEdge(maze->open, bit)) {
+		return EDGE_OPEN;
+	}
+	return EDGE_UNKNOWN;
+}
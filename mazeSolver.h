@@ -18,67 +18,174 @@
 #include "amazing.h"
 #include "avatar.h"
 
+/**************** Constants ****************/
+
+/*
+ * Bits of the 4-bit wall mask returned by getWalls(). Each bit is indexed by the
+ * M_* direction constant from amazing.h, so (1 << direction) tests a single wall.
+ */
+#define WALL_WEST  (1 << M_WEST)
+#define WALL_NORTH (1 << M_NORTH)
+#define WALL_SOUTH (1 << M_SOUTH)
+#define WALL_EAST  (1 << M_EAST)
+
+/*
+ * What is known about a single edge between two tiles, as returned by getEdgeState().
+ */
+#define EDGE_UNKNOWN 0
+#define EDGE_OPEN    1
+#define EDGE_WALL    2
+
+/*
+ * Offset to the neighbouring tile per M_* direction: a step in direction d goes from (x, y)
+ * to (x + deltaX[d], y + deltaY[d]), with y growing southward.
+ */
+extern const int deltaX[M_NUM_DIRECTIONS];
+extern const int deltaY[M_NUM_DIRECTIONS];
+
 /**************** Structs ****************/
 
-/**************** mazeTile ****************/
+/**************** maze ****************/
 /*
- * Defines a mazeTile struct, which represents one coordinate pair on the maze
+ * Defines a maze struct, which holds what is known about every edge of the maze: unknown,
+ * open or wall. Each edge is stored once, as a bit in a wall bitset and a bit in an open
+ * bitset inside a single allocation, so neighbouring tiles always agree. The bitsets are updated atomically, so
+ * every function below is safe to call from any number of avatar threads without a lock;
+ * use them rather than touching the representation directly.
  */
-typedef struct mazeTile {
-	int xCoord;
-	int yCoord;
-	bool northWall;
-	bool southWall;
-	bool eastWall;
-	bool westWall;
-	int visited;	
-} mazeTile_t;
+typedef struct maze maze_t;  // opaque to users of the module
 
 /**************** Functions ****************/
 
-/**************** mazeTileNew ****************/
+/**************** createMaze ****************/
 /*
- * Function which initializes a new mazeTile struct.
+ * Function which creates the wall grid which represents the maze.
  *
- * Input: Coordinate pair.
+ * Input: Maze dimensions.
  *
- * Output: mazeTile struct representing that coordinate pair with walls intialized.
+ * Output: A maze with only the outer border walls set, or NULL if memory could not be allocated.
  *
  */
-mazeTile_t *mazeTileNew(int xCoord, int yCoord);
+maze_t *createMaze(int height, int width);
 
-/**************** createMaze ****************/
+/**************** mazeDelete ****************/
 /*
- * Function which creates a 2D array of mazeTiles which represents the maze.
+ * Function which frees all the memory space allocated in createMaze().
  *
- * Input: Maze dimensions, number of avatars playing.
+ * Input: Maze created by createMaze().
  *
- * Output: A 2D array of mazeTiles representing the initial state of the maze.
+ * Output: Frees memory, returns and prints nothing.
  *
  */
-mazeTile_t ***createMaze(int height, int width);
+void mazeDelete(maze_t *maze);
 
-/**************** mazeDelete ****************/
+/**************** getMazeHeight ****************/
 /*
- * Function which frees all the memory space allocated in createMaze().
+ * Input: Maze.
  *
- * Input: Maze dimensions, 2D array of mazeTiles representing a maze.
+ * Output: Maze height.
  *
- * Output: Frees memory, returns and prints nothing.
+ */
+int getMazeHeight(maze_t *maze);
+
+/**************** getMazeWidth ****************/
+/*
+ * Input: Maze.
+ *
+ * Output: Maze width.
  *
  */
-void mazeDelete(int height, int width, mazeTile_t ***tiles);
+int getMazeWidth(maze_t *maze);
 
+/**************** addWall ****************/
 /*
- * Function which adds a wall into a maze array at a given mazeTile location.
+ * Function which adds a wall into a maze at a given tile location.
  *
- * Intput: 2D array of mazeTiles representing a maze, coordinates of tile to add wall at, cardinal direction of the wall relative
+ * Intput: Maze, coordinates of tile to add wall at, cardinal direction of the wall relative
  * to the center of the tile.
  *
- * Output: Adds a wall into the maze at the given location and orientation. Returns and prints nothing.
+ * Output: Sets the single edge bit shared by the tile and its neighbour in that direction.
+ * Returns and prints nothing.
  *
  */
-void addWall(mazeTile_t ***maze, int x, int y, int direction);
+void addWall(maze_t *maze, int x, int y, int direction);
 
-#endif // __MAZESOLVER_H
+/**************** addOpening ****************/
+/*
+ * Function which records that an edge of the maze is open, e.g. after an avatar moves through it.
+ *
+ * Input: Maze, coordinates of tile, cardinal direction of the open edge relative to the center of the tile.
+ *
+ * Output: Sets the single open bit shared by the tile and its neighbour in that direction. Edges on the
+ * outer border are never marked open. Returns and prints nothing.
+ *
+ */
+void addOpening(maze_t *maze, int x, int y, int direction);
+
+/**************** getWalls ****************/
+/*
+ * Function which looks up every known wall of a tile at once.
+ *
+ * Input: Maze, coordinates of tile.
+ *
+ * Output: 4-bit mask of WALL_* bits for that tile.
+ *
+ */
+int getWalls(maze_t *maze, int x, int y);
+
+/**************** getOpenings ****************/
+/*
+ * Function which looks up every edge of a tile known to be open at once.
+ *
+ * Input: Maze, coordinates of tile.
+ *
+ * Output: 4-bit mask of WALL_* bits for the tile's open edges.
+ *
+ */
+int getOpenings(maze_t *maze, int x, int y);
+
+/**************** hasWall ****************/
+/*
+ * Function which checks a single wall of a tile.
+ *
+ * Input: Maze, coordinates of tile, cardinal direction of the wall relative to the center of the tile.
+ *
+ * Output: true if a wall is known to exist there, false otherwise.
+ *
+ */
+bool hasWall(maze_t *maze, int x, int y, int direction);
+
+/**************** nextWallEvent ****************/
+/*
+ * Function which reads the wall event log, in which every newly added wall appears exactly once.
+ * Start a cursor at 0 (or at getWallEventCount()) and call this until it returns false.
+ *
+ * Input: Maze, the caller's cursor into the log, and where to store the wall's tile and direction.
+ *
+ * Output: true and advances the cursor if another wall has been published, false otherwise.
+ *
+ */
+bool nextWallEvent(maze_t *maze, size_t *cursor, int *x, int *y, int *direction);
+
+/**************** getWallEventCount ****************/
+/*
+ * Input: Maze.
+ *
+ * Output: Number of walls added to the maze so far, including the outer border. The wall bits of
+ * all of them are visible to the caller once this returns.
+ *
+ */
+size_t getWallEventCount(maze_t *maze);
+
+/**************** getEdgeState ****************/
+/*
+ * Function which checks what is known about a single edge of a tile.
+ *
+ * Input: Maze, coordinates of tile, cardinal direction of the edge relative to the center of the tile.
+ *
+ * Output: EDGE_WALL, EDGE_OPEN or EDGE_UNKNOWN.
+ *
+ */
+int getEdgeState(maze_t *maze, int x, int y, int direction);
 
+#endif // __MAZESOLVER_H
@@ -0,0 +1,129 @@
+/*
+ * mazegen.c - 'mazegen' module
+ *
+ * see mazegen.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+#include "mazegen.h"
+
+// the direction back from the neighbouring tile, per direction
+static const int opposite[M_NUM_DIRECTIONS] = { M_EAST, M_SOUTH, M_NORTH, M_WEST };
+
+void mazegenSize(int difficulty, int *width, int *height) {
+	*width = 10 + 10 * difficulty;
+	*height = 10 + 10 * difficulty;
+}
+
+/*
+ *	Carves the maze with an explicit stack so large mazes do not overflow the call stack
+ */
+uint8_t *mazegenCarve(int width, int height, unsigned int seed) {
+	int tiles = width * height;
+	uint8_t *open = calloc(tiles, sizeof(uint8_t));
+	int *stack = malloc(tiles * sizeof(int));
+	bool *visited = calloc(tiles, sizeof(bool));
+	if (open == NULL || stack == NULL || visited == NULL) {
+		fprintf(stderr, "Failed to malloc for maze generation\n");
+		free(open);
+		free(stack);
+		free(visited);
+		return NULL;
+	}
+
+	int top = 0;
+	stack[top++] = 0;
+	visited[0] = true;
+	while (top > 0) {
+		int tile = stack[top - 1];
+		int x = tile % width;
+		int y = tile / width;
+
+		// unvisited neighbours of the tile on top of the stack
+		int choices[M_NUM_DIRECTIONS];
+		int count = 0;
+		for (int d = 0; d < M_NUM_DIRECTIONS; d++) {
+			int nx = x + deltaX[d];
+			int ny = y + deltaY[d];
+			if (nx >= 0 && ny >= 0 && nx < width && ny < height && !visited[ny * width + nx]) {
+				choices[count++] = d;
+			}
+		}
+		if (count == 0) {
+			top--;
+			continue;
+		}
+
+		// knock down the wall to one of them and carry on from there
+		int d = choices[rand_r(&seed) % count];
+		int next = (y + deltaY[d]) * width + x + deltaX[d];
+		open[tile] |= 1 << d;
+		open[next] |= 1 << opposite[d];
+		visited[next] = true;
+		stack[top++] = next;
+	}
+	free(stack);
+	free(visited);
+	return open;
+}
+
+/*
+ *	Visits every inner wall once, east and south of each tile, and opens each with the chance asked for
+ */
+void mazegenLoops(uint8_t *open, int width, int height, int percent, unsigned int seed) {
+	// a stream of its own, so the walls knocked down do not follow the carving's choices
+	unsigned int state = seed ^ 0x5bd1e995u;
+	for (int y = 0; y < height; y++) {
+		for (int x = 0; x < width; x++) {
+			int tile = y * width + x;
+			if (x + 1 < width && !(open[tile] & (1 << M_EAST)) && rand_r(&state) % 100 < (unsigned)percent) {
+				open[tile] |= 1 << M_EAST;
+				open[tile + 1] |= 1 << M_WEST;
+			}
+			if (y + 1 < height && !(open[tile] & (1 << M_SOUTH)) && rand_r(&state) % 100 < (unsigned)percent) {
+				open[tile] |= 1 << M_SOUTH;
+				open[tile + width] |= 1 << M_NORTH;
+			}
+		}
+	}
+}
+
+void mazegenPlace(int width, int height, int nAvatars, unsigned int seed, int *x, int *y) {
+	int tiles = width * height;
+	for (int k = 0; k < nAvatars; k++) {
+		bool clash = true;
+		while (clash) {
+			int tile = rand_r(&seed) % tiles;
+			x[k] = tile % width;
+			y[k] = tile / width;
+			clash = false;
+			for (int other = 0; other < k && tiles >= nAvatars; other++) {
+				clash = clash || (x[other] == x[k] && y[other] == y[k]);
+			}
+		}
+	}
+}
+
+/*
+ *	FNV-1a over the game's parameters and result
+ */
+uint32_t mazegenHash(unsigned int seed, int width, int height, int nAvatars, int difficulty, int moves) {
+	uint32_t values[] = { seed, width, height, nAvatars, difficulty, moves };
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+		for (int byte = 0; byte < 4; byte++) {
+			hash = (hash ^ ((values[i] >> (8 * byte)) & 0xff)) * 16777619u;
+		}
+	}
+	return hash;
+}
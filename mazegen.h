@@ -0,0 +1,81 @@
+/*
+ * mazegen.h - header file for mazegen module
+ *
+ * This module builds the true mazes that amserver plays games on. A maze is carved from a
+ * seed, so the same seed, width and height always give the same maze. Carved mazes are perfect;
+ * mazegenLoops knocks out extra walls so that there is more than one way round.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __MAZEGEN_H
+#define __MAZEGEN_H
+
+#include <stdint.h>
+#include "amazing.h"
+
+/**************** functions ****************/
+
+/**************** mazegenSize ****************/
+/*
+ * Function which gives the size of the maze for a difficulty level.
+ *
+ * Input: Difficulty from 0 to AM_MAX_DIFFICULTY, pointers for the width and height.
+ *
+ * Output: Sets width and height; difficulty 0 is 10x10 and every level adds 10 to both.
+ *
+ */
+void mazegenSize(int difficulty, int *width, int *height);
+
+/**************** mazegenCarve ****************/
+/*
+ * Function which carves a perfect maze (exactly one path between any two tiles) with a
+ * randomized depth-first search starting from (0, 0).
+ *
+ * Input: Width and height in tiles, seed for rand_r.
+ *
+ * Output: A width*height array, row by row, holding the WALL_* bits (1 << direction) of every
+ * open edge of each tile, or NULL if memory could not be allocated. The caller frees it.
+ *
+ */
+uint8_t *mazegenCarve(int width, int height, unsigned int seed);
+
+/**************** mazegenLoops ****************/
+/*
+ * Function which knocks down some of the walls left between tiles of a carved maze, so it has
+ * loops, as the course server's mazes do. Walls on the border stay up.
+ *
+ * Input: Open-edge array from mazegenCarve, width and height in tiles, percent of the inner
+ * walls to knock down (0 leaves the maze perfect), seed the maze was carved from.
+ *
+ * Output: Updates the array in place; the same seed and percent always knock down the same walls.
+ *
+ */
+void mazegenLoops(uint8_t *open, int width, int height, int percent, unsigned int seed);
+
+/**************** mazegenPlace ****************/
+/*
+ * Function which scatters the avatars over distinct tiles (any tiles, if there are more avatars
+ * than tiles), from the same seed the maze was carved from.
+ *
+ * Input: Width and height in tiles, number of avatars, seed, arrays for each avatar's x and y.
+ *
+ * Output: Fills in x and y.
+ *
+ */
+void mazegenPlace(int width, int height, int nAvatars, unsigned int seed, int *x, int *y);
+
+/**************** mazegenHash ****************/
+/*
+ * Function which gives the hash AM_MAZE_SOLVED carries for a game.
+ *
+ * Input: Seed, width, height, number of avatars, difficulty, and the moves it took.
+ *
+ * Output: FNV-1a hash of those values.
+ *
+ */
+uint32_t mazegenHash(unsigned int seed, int width, int height, int nAvatars, int difficulty, int moves);
+
+#endif // __MAZEGEN_H
@@ -0,0 +1,179 @@
+/*
+ * mazetest.c, a stress test for the shared wall map in mazeSolver.c
+ *
+ * Ten threads add walls to one maze at the same time while reading it back, the
+ * way avatar threads do during a game. Each thread raises a "done" wall after its
+ * own walls; any thread that sees that flag must already see every wall published
+ * before it, and the wall event log must list every wall exactly once. Build with
+ * `make tsan` to run the same test under ThreadSanitizer.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+
+/**************** file-local constants ****************/
+#define NUM_THREADS 10        // one per possible avatar
+#define WALLS_PER_THREAD 20000
+#define MAZE_HEIGHT 200
+#define MAZE_WIDTH 200
+
+/**************** file-local types ****************/
+typedef struct wall {
+	int x;
+	int y;
+	int direction;
+} wall_t;
+
+typedef struct worker {
+	int id;
+	maze_t *maze;
+	wall_t walls[WALLS_PER_THREAD];
+	int failures;
+} worker_t;
+
+static worker_t workers[NUM_THREADS];
+
+/**************** file-local functions ****************/
+
+// the wall raised by thread 'id' once all of its other walls are published
+static bool doneFlag(maze_t *maze, int id) {
+	return hasWall(maze, id * 2 + 1, 0, M_SOUTH);
+}
+
+// checks that every wall of thread 'id' is visible, counting the ones that are not
+static int missingWalls(maze_t *maze, int id) {
+	int missing = 0;
+	for (int i = 0; i < WALLS_PER_THREAD; i++) {
+		wall_t *w = &workers[id].walls[i];
+		if (!hasWall(maze, w->x, w->y, w->direction)) {
+			missing++;
+		}
+	}
+	return missing;
+}
+
+// adds this thread's walls while reading the maze, then verifies the other threads' walls
+static void *runWorker(void *arg) {
+	worker_t *me = arg;
+	maze_t *maze = me->maze;
+	unsigned int seed = me->id;
+
+	// publish every wall, interleaved with reads of random tiles
+	for (int i = 0; i < WALLS_PER_THREAD; i++) {
+		addWall(maze, me->walls[i].x, me->walls[i].y, me->walls[i].direction);
+		getWalls(maze, rand_r(&seed) % MAZE_WIDTH, rand_r(&seed) % MAZE_HEIGHT);
+	}
+	addWall(maze, me->id * 2 + 1, 0, M_SOUTH);
+
+	// wait for each other thread's flag, and check its walls as soon as it is seen
+	bool checked[NUM_THREADS] = { false };
+	int remaining = NUM_THREADS - 1;
+	while (remaining > 0) {
+		for (int j = 0; j < NUM_THREADS; j++) {
+			if (j != me->id && !checked[j] && doneFlag(maze, j)) {
+				me->failures += missingWalls(maze, j);
+				checked[j] = true;
+				remaining--;
+			}
+		}
+	}
+	return NULL;
+}
+
+// Testing function
+int main(int argc, char *argv[]) {
+
+	maze_t *maze = createMaze(MAZE_HEIGHT, MAZE_WIDTH);
+	maze_t *expected = createMaze(MAZE_HEIGHT, MAZE_WIDTH);
+	if (maze == NULL || expected == NULL) {
+		exit(1);
+	}
+
+	// generate each thread's walls below row 1, so they never touch the done flags
+	for (int id = 0; id < NUM_THREADS; id++) {
+		unsigned int seed = 1000 + id;
+		workers[id].id = id;
+		workers[id].maze = maze;
+		for (int i = 0; i < WALLS_PER_THREAD; i++) {
+			wall_t *w = &workers[id].walls[i];
+			w->x = rand_r(&seed) % MAZE_WIDTH;
+			w->y = 2 + rand_r(&seed) % (MAZE_HEIGHT - 2);
+			w->direction = rand_r(&seed) % M_NUM_DIRECTIONS;
+			addWall(expected, w->x, w->y, w->direction);
+		}
+		addWall(expected, id * 2 + 1, 0, M_SOUTH);
+	}
+
+	// hammer the shared maze from every thread at once
+	pthread_t threads[NUM_THREADS];
+	for (int id = 0; id < NUM_THREADS; id++) {
+		if (pthread_create(&threads[id], NULL, runWorker, &workers[id]) != 0) {
+			fprintf(stderr, "Error when creating thread %d\n", id);
+			exit(2);
+		}
+	}
+	int failures = 0;
+	for (int id = 0; id < NUM_THREADS; id++) {
+		pthread_join(threads[id], NULL);
+		failures += workers[id].failures;
+	}
+	printf("%d walls missing after a done flag was seen\n", failures);
+
+	// the final maze must match the one built by a single thread, tile for tile
+	int mismatches = 0;
+	for (int y = 0; y < MAZE_HEIGHT; y++) {
+		for (int x = 0; x < MAZE_WIDTH; x++) {
+			if (getWalls(maze, x, y) != getWalls(expected, x, y)) {
+				mismatches++;
+			}
+		}
+	}
+	printf("%d tiles differ from the single-threaded maze\n", mismatches);
+
+	// the event log must hold every wall exactly once, in both mazes
+	int logged = 0;
+	int duplicates = 0;
+	size_t cursor = 0;
+	int x, y, direction;
+	maze_t *replayed = createMaze(MAZE_HEIGHT, MAZE_WIDTH);
+	while (nextWallEvent(maze, &cursor, &x, &y, &direction)) {
+
+		// the outer border is logged first, by createMaze, and is already set in 'replayed'
+		if (logged >= 2 * (MAZE_HEIGHT + MAZE_WIDTH) && hasWall(replayed, x, y, direction)) {
+			duplicates++;
+		}
+		addWall(replayed, x, y, direction);
+		logged++;
+	}
+	if (getWallEventCount(maze) != getWallEventCount(expected) || cursor != getWallEventCount(maze)) {
+		mismatches++;
+	}
+	for (int y = 0; y < MAZE_HEIGHT; y++) {
+		for (int x = 0; x < MAZE_WIDTH; x++) {
+			if (getWalls(replayed, x, y) != getWalls(maze, x, y)) {
+				mismatches++;
+			}
+		}
+	}
+	printf("%d walls logged, %d logged twice\n", logged, duplicates);
+	mazeDelete(replayed);
+
+	mazeDelete(maze);
+	mazeDelete(expected);
+
+	if (failures != 0 || mismatches != 0 || duplicates != 0) {
+		printf("Test Results Failed\n");
+		return 1;
+	}
+	printf("Test Results Successful\n");
+	return 0;
+}
@@ -0,0 +1,494 @@
+/*
+ * planner.c - 'planner' module
+ *
+ * see planner.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>       // memcpy
+#include "amazing.h"
+#include "mazeSolver.h"
+#include "planner.h"
+
+/*
+ * Scratch space is sized once for the whole maze. Instead of clearing 'seen' before every
+ * search, each search bumps 'stamp' and treats only tiles stamped with it as discovered.
+ *
+ * A PLANNER_BFS planner caches one path and searches again when it breaks. A
+ * PLANNER_INCREMENTAL planner instead keeps the distance from every tile to the goal and,
+ * like LPA* / D* Lite, repairs only the tiles whose distance a new wall can change. It reads
+ * new walls from the maze's wall event log, starting at 'cursor'. A field can also be copied
+ * from another planner with the same goal, which is then repaired from that planner's cursor.
+ */
+typedef struct planner {
+	maze_t *maze;
+	int mode;
+	int width;
+	int height;
+	uint32_t stamp;
+	uint32_t *seen;       // search stamp of the last BFS (or repair) that reached each tile
+	uint8_t *toward;      // direction from each tile one step closer to the goal
+	int *queue;           // BFS frontier, one slot per tile
+	uint8_t *path;        // directions from pathStart to the goal
+	int pathLength;
+	int pathIndex;        // next step of path to take
+	int pathX;            // tile the avatar should be on before taking path[pathIndex]
+	int pathY;
+	int goalX;
+	int goalY;
+	int replans;
+	int *distance;        // incremental mode: steps from each tile to the goal
+	int *heap;            // incremental mode: (distance, tile) pairs being repaired
+	int heapSize;
+	size_t cursor;        // incremental mode: next unread entry of the wall event log
+	int copies;
+	int repairs;
+	long repairedTiles;
+} planner_t;
+
+// distance of a tile walled off from the goal
+#define UNREACHABLE (1 << 30)
+
+// the direction back from the neighbouring tile, per direction
+static const int opposite[M_NUM_DIRECTIONS] = { M_EAST, M_SOUTH, M_NORTH, M_WEST };
+
+/*
+ *	Creates a planner with scratch space for every tile of the maze
+ */
+planner_t *plannerNew(maze_t *maze, int mode) {
+	planner_t *planner = malloc(sizeof(planner_t));
+	if (planner == NULL) {
+		fprintf(stderr, "Failed to malloc for planner\n");
+		return NULL;
+	}
+	planner->maze = maze;
+	planner->mode = mode;
+	planner->width = getMazeWidth(maze);
+	planner->height = getMazeHeight(maze);
+	int tiles = planner->width * planner->height;
+
+	planner->stamp = 0;
+	planner->seen = calloc(tiles, sizeof(uint32_t));
+	planner->toward = malloc(tiles * sizeof(uint8_t));
+	planner->queue = malloc(tiles * sizeof(int));
+	planner->path = malloc(tiles * sizeof(uint8_t));
+	planner->distance = NULL;
+	planner->heap = NULL;
+	if (mode == PLANNER_INCREMENTAL) {
+		// each repaired tile is pushed at most once per neighbour, plus once to start
+		planner->distance = malloc(tiles * sizeof(int));
+		planner->heap = malloc(2 * (M_NUM_DIRECTIONS + 1) * tiles * sizeof(int));
+	}
+	if (planner->seen == NULL || planner->toward == NULL || planner->queue == NULL || planner->path == NULL
+			|| (mode == PLANNER_INCREMENTAL && (planner->distance == NULL || planner->heap == NULL))) {
+		fprintf(stderr, "Failed to malloc for planner scratch space\n");
+		plannerDelete(planner);
+		return NULL;
+	}
+	planner->pathLength = 0;
+	planner->pathIndex = 0;
+	planner->pathX = -1;
+	planner->pathY = -1;
+	planner->goalX = -1;
+	planner->goalY = -1;
+	planner->replans = 0;
+	planner->heapSize = 0;
+	planner->cursor = 0;
+	planner->copies = 0;
+	planner->repairs = 0;
+	planner->repairedTiles = 0;
+	return planner;
+}
+
+/*
+ *	Frees a planner and its scratch space
+ */
+void plannerDelete(planner_t *planner) {
+	if (planner != NULL) {
+		free(planner->seen);
+		free(planner->toward);
+		free(planner->queue);
+		free(planner->path);
+		free(planner->distance);
+		free(planner->heap);
+		free(planner);
+	}
+}
+
+int plannerReplans(planner_t *planner) {
+	return planner->replans;
+}
+
+int plannerCopies(planner_t *planner) {
+	return planner->copies;
+}
+
+int plannerRepairs(planner_t *planner) {
+	return planner->repairs;
+}
+
+long plannerRepairedTiles(planner_t *planner) {
+	return planner->repairedTiles;
+}
+
+int plannerDistance(planner_t *planner, int x, int y) {
+	if (planner->mode != PLANNER_INCREMENTAL || planner->goalX < 0) {
+		return -1;
+	}
+	int distance = planner->distance[y * planner->width + x];
+	return distance >= UNREACHABLE ? -1 : distance;
+}
+
+/*
+ *	Checks that the rest of the cached path still starts at (x,y), ends at the goal and crosses no known wall
+ */
+static bool pathValid(planner_t *planner, int x, int y, int goalX, int goalY) {
+	if (goalX != planner->goalX || goalY != planner->goalY) {
+		return false;
+	}
+	if (x != planner->pathX || y != planner->pathY || planner->pathIndex >= planner->pathLength) {
+		return false;
+	}
+	for (int i = planner->pathIndex; i < planner->pathLength; i++) {
+		int direction = planner->path[i];
+		if (hasWall(planner->maze, x, y, direction)) {
+			return false;
+		}
+		x += deltaX[direction];
+		y += deltaY[direction];
+	}
+	return true;
+}
+
+/*
+ *	Runs a BFS outward from the goal until it reaches (x,y), then stores the path from (x,y) to the goal
+ */
+static bool replan(planner_t *planner, int x, int y, int goalX, int goalY) {
+	int width = planner->width;
+	int start = y * width + x;
+	int goal = goalY * width + goalX;
+	uint32_t stamp = ++planner->stamp;
+	int head = 0;
+	int tail = 0;
+	bool found = false;
+
+	planner->replans++;
+	planner->goalX = goalX;
+	planner->goalY = goalY;
+	planner->pathLength = 0;
+	planner->pathIndex = 0;
+
+	// search from the goal, so every discovered tile already knows its step toward it
+	planner->seen[goal] = stamp;
+	planner->queue[tail++] = goal;
+	while (head < tail && !found) {
+		int tile = planner->queue[head++];
+		int tileX = tile % width;
+		int tileY = tile / width;
+		int walls = getWalls(planner->maze, tileX, tileY);
+
+		// unknown edges are optimistically treated as open
+		for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+			if (walls & (1 << direction)) {
+				continue;
+			}
+			int next = (tileY + deltaY[direction]) * width + tileX + deltaX[direction];
+			if (planner->seen[next] != stamp) {
+				planner->seen[next] = stamp;
+				planner->toward[next] = opposite[direction];
+				planner->queue[tail++] = next;
+				if (next == start) {
+					found = true;
+					break;
+				}
+			}
+		}
+	}
+	if (!found) {
+		return false;
+	}
+
+	// walk the steps from the avatar back to the goal to build the path
+	int tile = start;
+	while (tile != goal) {
+		int direction = planner->toward[tile];
+		planner->path[planner->pathLength++] = direction;
+		tile += deltaY[direction] * width + deltaX[direction];
+	}
+	planner->pathX = x;
+	planner->pathY = y;
+	return true;
+}
+
+/*
+ *	Returns the next step of the cached BFS path, replanning only when it is no longer usable
+ */
+static int bfsMove(planner_t *planner, int x, int y, int goalX, int goalY) {
+	if (!pathValid(planner, x, y, goalX, goalY) && !replan(planner, x, y, goalX, goalY)) {
+		return M_NULL_MOVE;
+	}
+
+	// take the step, and expect to be on the next tile of the path when called again
+	int direction = planner->path[planner->pathIndex++];
+	planner->pathX = x + deltaX[direction];
+	planner->pathY = y + deltaY[direction];
+	return direction;
+}
+
+/*
+ *	Pushes a (distance, tile) pair onto the binary min-heap used by repairs
+ */
+static void heapPush(planner_t *planner, int distance, int tile) {
+	int *heap = planner->heap;
+	int child = planner->heapSize++;
+	while (child > 0) {
+		int parent = (child - 1) / 2;
+		if (heap[2 * parent] <= distance) {
+			break;
+		}
+		heap[2 * child] = heap[2 * parent];
+		heap[2 * child + 1] = heap[2 * parent + 1];
+		child = parent;
+	}
+	heap[2 * child] = distance;
+	heap[2 * child + 1] = tile;
+}
+
+/*
+ *	Pops the pair with the smallest distance off the repair heap
+ */
+static void heapPop(planner_t *planner, int *distance, int *tile) {
+	int *heap = planner->heap;
+	*distance = heap[0];
+	*tile = heap[1];
+	int lastDistance = heap[2 * (planner->heapSize - 1)];
+	int lastTile = heap[2 * (planner->heapSize - 1) + 1];
+	int size = --planner->heapSize;
+	int parent = 0;
+	while (2 * parent + 1 < size) {
+		int child = 2 * parent + 1;
+		if (child + 1 < size && heap[2 * (child + 1)] < heap[2 * child]) {
+			child++;
+		}
+		if (heap[2 * child] >= lastDistance) {
+			break;
+		}
+		heap[2 * parent] = heap[2 * child];
+		heap[2 * parent + 1] = heap[2 * child + 1];
+		parent = child;
+	}
+	heap[2 * parent] = lastDistance;
+	heap[2 * parent + 1] = lastTile;
+}
+
+/*
+ *	Computes every tile's distance to the goal from scratch with one BFS
+ */
+static void computeDistances(planner_t *planner, int goalX, int goalY) {
+	int width = planner->width;
+	int tiles = width * planner->height;
+	int goal = goalY * width + goalX;
+	int head = 0;
+	int tail = 0;
+
+	// walls logged before this point are already set, so the BFS sees them
+	planner->cursor = getWallEventCount(planner->maze);
+	planner->replans++;
+	planner->goalX = goalX;
+	planner->goalY = goalY;
+	for (int tile = 0; tile < tiles; tile++) {
+		planner->distance[tile] = UNREACHABLE;
+	}
+	planner->distance[goal] = 0;
+	planner->queue[tail++] = goal;
+	while (head < tail) {
+		int tile = planner->queue[head++];
+		int walls = getWalls(planner->maze, tile % width, tile / width);
+		for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+			if (walls & (1 << direction)) {
+				continue;
+			}
+			int next = tile + deltaY[direction] * width + deltaX[direction];
+			if (planner->distance[next] == UNREACHABLE) {
+				planner->distance[next] = planner->distance[tile] + 1;
+				planner->queue[tail++] = next;
+			}
+		}
+	}
+}
+
+/*
+ *	Checks whether a tile still has an open neighbour one step closer to the goal that is not being repaired
+ */
+static bool hasSupport(planner_t *planner, int tile) {
+	int width = planner->width;
+	int walls = getWalls(planner->maze, tile % width, tile / width);
+	for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+		int next = tile + deltaY[direction] * width + deltaX[direction];
+		if (!(walls & (1 << direction)) && planner->seen[next] != planner->stamp
+				&& planner->distance[next] == planner->distance[tile] - 1) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ *	Repairs the distances a new wall on the given side of (x,y) can lengthen, leaving every other tile alone
+ */
+static void repairWall(planner_t *planner, int x, int y, int direction) {
+	int width = planner->width;
+	int nextX = x + deltaX[direction];
+	int nextY = y + deltaY[direction];
+	if (nextX < 0 || nextY < 0 || nextX >= width || nextY >= planner->height) {
+		return;
+	}
+	int ends[2] = { y * width + x, nextY * width + nextX };
+	int *distance = planner->distance;
+	uint32_t stamp = ++planner->stamp;
+	int head = 0;
+	int tail = 0;
+
+	// an end of the new wall that has lost every step toward the goal is the start of the damage
+	for (int i = 0; i < 2; i++) {
+		int tile = ends[i];
+		if (distance[tile] > 0 && distance[tile] < UNREACHABLE && planner->seen[tile] != stamp && !hasSupport(planner, tile)) {
+			planner->seen[tile] = stamp;
+			planner->queue[tail++] = tile;
+		}
+	}
+	if (tail == 0) {
+		return;
+	}
+
+	// collect every tile that only reached the goal through collected tiles; the last of a tile's
+	// supporters to be expanded sees all the others already collected, so order does not matter
+	while (head < tail) {
+		int tile = planner->queue[head++];
+		int walls = getWalls(planner->maze, tile % width, tile / width);
+		for (int d = 0; d < M_NUM_DIRECTIONS; d++) {
+			int next = tile + deltaY[d] * width + deltaX[d];
+			if (!(walls & (1 << d)) && planner->seen[next] != stamp
+					&& distance[next] == distance[tile] + 1 && !hasSupport(planner, next)) {
+				planner->seen[next] = stamp;
+				planner->queue[tail++] = next;
+			}
+		}
+	}
+
+	// give each collected tile its best distance through the tiles that were not collected
+	planner->heapSize = 0;
+	for (int i = 0; i < tail; i++) {
+		int tile = planner->queue[i];
+		int walls = getWalls(planner->maze, tile % width, tile / width);
+		distance[tile] = UNREACHABLE;
+		for (int d = 0; d < M_NUM_DIRECTIONS; d++) {
+			int next = tile + deltaY[d] * width + deltaX[d];
+			if (!(walls & (1 << d)) && planner->seen[next] != stamp && distance[next] + 1 < distance[tile]) {
+				distance[tile] = distance[next] + 1;
+			}
+		}
+		if (distance[tile] < UNREACHABLE) {
+			heapPush(planner, distance[tile], tile);
+		}
+	}
+
+	// then let the shortest of those distances flow through the collected tiles, Dijkstra style
+	while (planner->heapSize > 0) {
+		int tileDistance, tile;
+		heapPop(planner, &tileDistance, &tile);
+		if (tileDistance != distance[tile]) {
+			continue;
+		}
+		int walls = getWalls(planner->maze, tile % width, tile / width);
+		for (int d = 0; d < M_NUM_DIRECTIONS; d++) {
+			int next = tile + deltaY[d] * width + deltaX[d];
+			if (!(walls & (1 << d)) && planner->seen[next] == stamp && tileDistance + 1 < distance[next]) {
+				distance[next] = tileDistance + 1;
+				heapPush(planner, distance[next], next);
+			}
+		}
+	}
+	planner->repairs++;
+	planner->repairedTiles += tail;
+}
+
+/*
+ *	Brings the distance field up to date for the goal and every wall logged so far
+ */
+void plannerUpdate(planner_t *planner, int goalX, int goalY) {
+	int wallX, wallY, wallDirection;
+	if (planner->mode != PLANNER_INCREMENTAL) {
+		return;
+	}
+
+	// a new goal needs a new field; then repair around the walls found since it was last used
+	if (goalX != planner->goalX || goalY != planner->goalY) {
+		computeDistances(planner, goalX, goalY);
+	}
+	while (nextWallEvent(planner->maze, &planner->cursor, &wallX, &wallY, &wallDirection)) {
+		repairWall(planner, wallX, wallY, wallDirection);
+	}
+}
+
+/*
+ *	Takes over another planner's field, and its place in the wall event log, if it has a different goal
+ */
+bool plannerCopyField(planner_t *planner, planner_t *source) {
+	if (planner->mode != PLANNER_INCREMENTAL || source->mode != PLANNER_INCREMENTAL || source->goalX < 0
+			|| (planner->goalX == source->goalX && planner->goalY == source->goalY)) {
+		return false;
+	}
+	memcpy(planner->distance, source->distance, planner->width * planner->height * sizeof(int));
+	planner->goalX = source->goalX;
+	planner->goalY = source->goalY;
+	planner->cursor = source->cursor;
+	planner->copies++;
+	return true;
+}
+
+/*
+ *	Returns the downhill step of the incrementally repaired distance field
+ */
+static int incrementalMove(planner_t *planner, int x, int y, int goalX, int goalY) {
+	plannerUpdate(planner, goalX, goalY);
+
+	// step to the closest neighbour, preferring edges already known to be open over unknown ones
+	int width = planner->width;
+	int tile = y * width + x;
+	int walls = getWalls(planner->maze, x, y);
+	int openings = getOpenings(planner->maze, x, y);
+	int best = M_NULL_MOVE;
+	int bestDistance = planner->distance[tile];
+	for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+		if (walls & (1 << direction)) {
+			continue;
+		}
+		int next = planner->distance[tile + deltaY[direction] * width + deltaX[direction]];
+		if (next < bestDistance || (next == bestDistance && best != M_NULL_MOVE
+				&& (openings & (1 << direction)) && !(openings & (1 << best)))) {
+			best = direction;
+			bestDistance = next;
+		}
+	}
+	return best;
+}
+
+/*
+ *	Returns the next step toward the goal using the planner's mode
+ */
+int plannerMove(planner_t *planner, int x, int y, int goalX, int goalY) {
+	if (x == goalX && y == goalY) {
+		return M_NULL_MOVE;
+	}
+	if (planner->mode == PLANNER_INCREMENTAL) {
+		return incrementalMove(planner, x, y, goalX, goalY);
+	}
+	return bfsMove(planner, x, y, goalX, goalY);
+}
@@ -0,0 +1,158 @@
+/*
+ * planner.h - header file for planner module
+ *
+ * This module plans shortest paths over the maze the avatars have discovered so far.
+ * Edges that have not been probed yet are treated as open, so a planner always has a route
+ * to try; when a wall turns up on that route it plans again around it.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __PLANNER_H
+#define __PLANNER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+
+/**************** constants ****************/
+
+/*
+ * Planner modes, passed to plannerNew().
+ * PLANNER_BFS caches one path and runs a full BFS again whenever a wall turns up on it.
+ * PLANNER_INCREMENTAL keeps every tile's distance to the goal and, in the style of LPA* / D* Lite,
+ * repairs only the part of it a newly added wall can lengthen.
+ */
+#define PLANNER_BFS         0
+#define PLANNER_INCREMENTAL 1
+
+/**************** structs ****************/
+
+/**************** planner ****************/
+/*
+ * Per-avatar planner holding the BFS scratch space and the path currently being followed.
+ * See planner.c for details.
+ */
+typedef struct planner planner_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** plannerNew ****************/
+/*
+ * Function which creates a planner for one avatar.
+ *
+ * Input: The shared maze the planner reads walls from, PLANNER_BFS or PLANNER_INCREMENTAL.
+ *
+ * Output: A planner with no path yet, or NULL if memory could not be allocated.
+ *
+ */
+planner_t *plannerNew(maze_t *maze, int mode);
+
+/**************** plannerDelete ****************/
+/*
+ * Function which frees all memory held by a planner.
+ *
+ * Input: Planner created by plannerNew().
+ *
+ * Output: None.
+ *
+ */
+void plannerDelete(planner_t *planner);
+
+/**************** plannerMove ****************/
+/*
+ * Function which picks the next step of a shortest path from a tile to a goal tile.
+ *
+ * PLANNER_BFS: the cached path is reused as long as the goal has not moved, the avatar is where
+ * the path expects it to be and no wall has been discovered on the rest of the path; otherwise a
+ * new BFS is run from the goal over every edge not known to be a wall.
+ *
+ * PLANNER_INCREMENTAL: the distance field is built from scratch when the goal moves, unless it was
+ * copied for the new goal with plannerCopyField. Every wall added to the maze since the field was
+ * last brought up to date (see nextWallEvent) repairs just the tiles whose distance it lengthens,
+ * and the avatar steps to its closest neighbour, preferring edges known to be open.
+ *
+ * Input: Planner, coordinates of the avatar, coordinates of the goal.
+ *
+ * Output: Direction of the next step, or M_NULL_MOVE if the avatar is on the goal or the goal cannot be reached.
+ *
+ */
+int plannerMove(planner_t *planner, int x, int y, int goalX, int goalY);
+
+/**************** plannerUpdate ****************/
+/*
+ * Function which brings the distance field of a PLANNER_INCREMENTAL planner up to date for a goal,
+ * as plannerMove does before it steps, for callers that only read distances (see plannerDistance).
+ * Does nothing for a PLANNER_BFS planner.
+ *
+ * Input: Planner, coordinates of the goal.
+ *
+ * Output: None.
+ *
+ */
+void plannerUpdate(planner_t *planner, int goalX, int goalY);
+
+/**************** plannerCopyField ****************/
+/*
+ * Function which gives a PLANNER_INCREMENTAL planner a copy of another's distance field when their
+ * goals differ, so a goal change costs a copy instead of a BFS over the whole maze. The copy is
+ * repaired for the walls the source had not yet read on the next plannerUpdate or plannerMove.
+ * Both planners must read the same maze; the caller keeps the source from changing meanwhile.
+ *
+ * Input: Planner, PLANNER_INCREMENTAL planner to copy from.
+ *
+ * Output: True if the field was copied, false if either planner is not incremental, the source has
+ * no goal or both already have the same goal.
+ *
+ */
+bool plannerCopyField(planner_t *planner, planner_t *source);
+
+/**************** plannerReplans ****************/
+/*
+ * Input: Planner.
+ *
+ * Output: Number of times the planner has run a full BFS.
+ *
+ */
+int plannerReplans(planner_t *planner);
+
+/**************** plannerCopies ****************/
+/*
+ * Input: Planner.
+ *
+ * Output: Number of fields a PLANNER_INCREMENTAL planner took over with plannerCopyField.
+ *
+ */
+int plannerCopies(planner_t *planner);
+
+/**************** plannerRepairs ****************/
+/*
+ * Input: Planner.
+ *
+ * Output: Number of incremental repairs (walls that lengthened at least one distance) so far.
+ *
+ */
+int plannerRepairs(planner_t *planner);
+
+/**************** plannerRepairedTiles ****************/
+/*
+ * Input: Planner.
+ *
+ * Output: Total number of tiles whose distance was recomputed by incremental repairs.
+ *
+ */
+long plannerRepairedTiles(planner_t *planner);
+
+/**************** plannerDistance ****************/
+/*
+ * Input: PLANNER_INCREMENTAL planner, coordinates of a tile.
+ *
+ * Output: The tile's current distance to the goal, or -1 if it is walled off or the planner has no goal yet.
+ *
+ */
+int plannerDistance(planner_t *planner, int x, int y);
+
+#endif // __PLANNER_H
@@ -0,0 +1,367 @@
+/*
+ * plannertest.c, a testing module that evaluates the incremental planner in planner.c
+ *
+ * An avatar walks a random 100x100 maze with PLANNER_INCREMENTAL, discovering walls as it
+ * bumps into them while other "avatars" reveal random walls elsewhere. After every move the
+ * repaired distance field is compared against a BFS from scratch, and the time each move took
+ * is reported next to the time of a full BFS replan.
+ *
+ * A field copied from another planner must be repaired like one the planner built itself.
+ *
+ * Then four avatars play a 100x100 maze with loops through the strategy hooks, as sim.c does,
+ * with each planner strategy, so the goal moves with the rendezvous. The rendezvous must only
+ * search again on turns that found a wall, and a turn that found one without a search must keep a
+ * target no tile beats by more than RENDEZVOUS_HYSTERESIS. Its cost must match a BFS from the
+ * target, and a turn without a search must cost less than one with it. The incremental planners
+ * must take every new goal's field from the rendezvous instead of building it. The mean time of each kind of turn and the number of full
+ * searches of the planners are printed.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r, clock_gettime
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <netdb.h>                // htonl
+#include "amazing.h"
+#include "avatar.h"
+#include "mazeSolver.h"
+#include "planner.h"
+#include "rendezvous.h"
+#include "strategy.h"
+#include "mazegen.h"
+
+/**************** file-local constants ****************/
+#define MAZE_SIZE 100
+#define REVEALED_PER_MOVE 3       // walls found by other avatars between two of our moves
+#define MAX_STEPS 20000
+#define GAME_DIFFICULTY 9         // a 100x100 maze
+#define GAME_AVATARS 4
+#define GAME_LOOPS 10
+#define GAME_SEED 7
+
+/**************** file-local functions ****************/
+
+// nanoseconds on the monotonic clock
+static long long now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// BFS from the goal over every edge not known to be a wall, for reference
+static void referenceDistances(maze_t *maze, int goal, int *distance, int *queue) {
+	int width = getMazeWidth(maze);
+	int tiles = width * getMazeHeight(maze);
+	int head = 0;
+	int tail = 0;
+	for (int i = 0; i < tiles; i++) {
+		distance[i] = -1;
+	}
+	distance[goal] = 0;
+	queue[tail++] = goal;
+	while (head < tail) {
+		int tile = queue[head++];
+		int walls = getWalls(maze, tile % width, tile / width);
+		for (int d = 0; d < M_NUM_DIRECTIONS; d++) {
+			int next = tile + deltaY[d] * width + deltaX[d];
+			if (!(walls & (1 << d)) && distance[next] < 0) {
+				distance[next] = distance[tile] + 1;
+				queue[tail++] = next;
+			}
+		}
+	}
+}
+
+// farthest distance of the tile every avatar can reach soonest, by a BFS from each of them
+static int referenceBest(maze_t *maze, int *x, int *y, int *farthest, int *distance, int *queue) {
+	int width = getMazeWidth(maze);
+	int tiles = width * getMazeHeight(maze);
+	for (int i = 0; i < tiles; i++) {
+		farthest[i] = 0;
+	}
+	for (int k = 0; k < GAME_AVATARS; k++) {
+		referenceDistances(maze, y[k] * width + x[k], distance, queue);
+		for (int i = 0; i < tiles; i++) {
+			farthest[i] = distance[i] < 0 || farthest[i] < 0 ? -1 : (distance[i] > farthest[i] ? distance[i] : farthest[i]);
+		}
+	}
+	int best = -1;
+	for (int i = 0; i < tiles; i++) {
+		if (farthest[i] >= 0 && (best < 0 || farthest[i] < best)) {
+			best = farthest[i];
+		}
+	}
+	return best;
+}
+
+// plays one game through the strategy hooks, checking the rendezvous every turn; returns true if it passed
+static bool playGame(const char *name) {
+	const strategy_t *strategy = findStrategy(name);
+	int width, height;
+	mazegenSize(GAME_DIFFICULTY, &width, &height);
+	int tiles = width * height;
+	uint8_t *open = mazegenCarve(width, height, GAME_SEED);
+	mazegenLoops(open, width, height, GAME_LOOPS, GAME_SEED);
+	maze_t *maze = createMaze(height, width);
+	rendezvous_t *rendezvous = rendezvousNew(maze, RENDEZVOUS_MINMAX);
+	avatar_t **avatars = createAvatars(GAME_AVATARS);
+	int *expected = malloc(tiles * sizeof(int));
+	int *queue = malloc(tiles * sizeof(int));
+	int *farthest = malloc(tiles * sizeof(int));
+
+	int x[AM_MAX_AVATAR], y[AM_MAX_AVATAR];
+	XYPos positions[AM_MAX_AVATAR];
+	mazegenPlace(width, height, GAME_AVATARS, GAME_SEED, x, y);
+	for (int k = 0; k < GAME_AVATARS; k++) {
+		avatars[k]->firstTurn = false;
+		setPosition(avatars[k], x[k], y[k]);
+		positions[k].x = htonl(x[k]);
+		positions[k].y = htonl(y[k]);
+	}
+	int lastTurnID = -1;
+	int moveCount = 0;
+	strategyContext_t contexts[AM_MAX_AVATAR];
+	for (int k = 0; k < GAME_AVATARS; k++) {
+		strategyContext_t context = { k, GAME_AVATARS, avatars, maze, rendezvous, &lastTurnID, NULL, &moveCount, NULL };
+		contexts[k] = context;
+		strategy->init(&contexts[k]);
+	}
+
+	int turn = 0;
+	int lastGoal[AM_MAX_AVATAR];
+	int goalTurns = 0;
+	long long goalTime = 0;
+	for (int k = 0; k < GAME_AVATARS; k++) {
+		lastGoal[k] = -1;
+	}
+	int quietTurns = 0;
+	int searchTurns = 0;
+	int needless = 0;
+	int wrongCosts = 0;
+	int wrongKeeps = 0;
+	long long quietTime = 0;
+	long long searchTime = 0;
+	size_t walls = getWallEventCount(maze);
+	bool together = false;
+	while (!together && moveCount < AM_MAX_MOVES * 100) {
+		int searches = rendezvousSearches(rendezvous);
+		long long start = now();
+		int move = strategy->chooseMove(&contexts[turn], positions);
+		long long elapsed = now() - start;
+		moveCount++;
+
+		// a search is only needed on the first turn and on turns that found a wall
+		bool searched = rendezvousSearches(rendezvous) > searches;
+		bool newWall = getWallEventCount(maze) != walls;
+		if (searched) {
+			searchTurns++;
+			searchTime += elapsed;
+			needless += moveCount > 1 && !newWall;
+		}
+		else {
+			quietTurns++;
+			quietTime += elapsed;
+		}
+		walls = getWallEventCount(maze);
+
+		// turns on which the goal had moved since this avatar's last one
+		int targetX, targetY;
+		rendezvousTarget(rendezvous, &targetX, &targetY);
+		if (targetY * width + targetX != lastGoal[turn]) {
+			lastGoal[turn] = targetY * width + targetX;
+			goalTurns++;
+			goalTime += elapsed;
+		}
+
+		// the cost must be the farthest avatar's distance to the target
+		referenceDistances(maze, targetY * width + targetX, expected, queue);
+		int cost = 0;
+		for (int k = 0; k < GAME_AVATARS; k++) {
+			int distance = expected[y[k] * width + x[k]];
+			cost = distance > cost ? distance : cost;
+		}
+		wrongCosts += rendezvousCost(rendezvous) != cost;
+
+		// a wall was found and the search skipped: it would have kept the target too
+		if (newWall && !searched) {
+			wrongKeeps += cost > referenceBest(maze, x, y, farthest, expected, queue) + RENDEZVOUS_HYSTERESIS;
+		}
+
+		// carry the move out as the server would
+		int fromX = x[turn];
+		int fromY = y[turn];
+		bool moved = move >= 0 && move < M_NUM_DIRECTIONS && (open[fromY * width + fromX] & (1 << move));
+		if (moved) {
+			x[turn] += deltaX[move];
+			y[turn] += deltaY[move];
+			positions[turn].x = htonl(x[turn]);
+			positions[turn].y = htonl(y[turn]);
+			addOpening(maze, fromX, fromY, move);
+			setPosition(avatars[turn], x[turn], y[turn]);
+		}
+		else if (move != M_NULL_MOVE) {
+			addWall(maze, fromX, fromY, move);
+		}
+		strategy->onMoveResult(&contexts[turn], move, moved);
+		together = true;
+		for (int k = 1; k < GAME_AVATARS && together; k++) {
+			together = x[k] == x[0] && y[k] == y[0];
+		}
+		turn = (turn + 1) % GAME_AVATARS;
+	}
+
+	int replans = 0;
+	int copies = 0;
+	for (int k = 0; k < GAME_AVATARS; k++) {
+		replans += plannerReplans(contexts[k].state);
+		copies += plannerCopies(contexts[k].state);
+	}
+	bool incremental = strcmp(name, "incremental") == 0;
+	double quietMean = quietTurns > 0 ? quietTime / 1000.0 / quietTurns : 0;
+	double searchMean = searchTurns > 0 ? searchTime / 1000.0 / searchTurns : 0;
+	double goalMean = goalTurns > 0 ? goalTime / 1000.0 / goalTurns : 0;
+	printf("%s: %s in %d moves, %d rendezvous searches, %d retargets\n", name, together ? "met" : "did not meet", moveCount, rendezvousSearches(rendezvous), rendezvousRetargets(rendezvous));
+	printf("%s: turn without a rendezvous search: mean %.1f us over %d turns; turn that searched: mean %.1f us over %d turns\n", name, quietMean, quietTurns, searchMean, searchTurns);
+	printf("%s: turn on which the goal had moved: mean %.1f us over %d turns\n", name, goalMean, goalTurns);
+	printf("%s: %d full planner searches, %d fields copied from the rendezvous\n", name, replans, copies);
+	printf("%s: %d searches with no new wall, %d wrong costs, %d targets kept that a search would have moved\n", name, needless, wrongCosts, wrongKeeps);
+
+	for (int k = 0; k < GAME_AVATARS; k++) {
+		strategy->teardown(&contexts[k]);
+	}
+	deleteAvatars(avatars, GAME_AVATARS);
+	rendezvousDelete(rendezvous);
+	mazeDelete(maze);
+	free(open);
+	free(expected);
+	free(queue);
+	free(farthest);
+	return together && needless == 0 && wrongCosts == 0 && wrongKeeps == 0 && quietMean < searchMean
+			&& (!incremental || (replans == 0 && copies <= goalTurns));
+}
+
+// Testing function
+int main(int argc, char *argv[]) {
+	int tiles = MAZE_SIZE * MAZE_SIZE;
+	unsigned int seed = 50;
+	uint8_t *open = mazegenCarve(MAZE_SIZE, MAZE_SIZE, seed);
+	int *expected = malloc(tiles * sizeof(int));
+	int *queue = malloc(tiles * sizeof(int));
+
+	maze_t *maze = createMaze(MAZE_SIZE, MAZE_SIZE);
+	planner_t *incremental = plannerNew(maze, PLANNER_INCREMENTAL);
+	planner_t *bfs = plannerNew(maze, PLANNER_BFS);
+	int goalX = MAZE_SIZE - 1;
+	int goalY = MAZE_SIZE - 1;
+	int x = 0;
+	int y = 0;
+	int steps = 0;
+	int mismatches = 0;
+	long long incrementalTime = 0;
+	long long worstTime = 0;
+	long long bfsTime = 0;
+
+	// the first call builds the whole field; everything after that is a repair
+	plannerMove(incremental, x, y, goalX, goalY);
+	while ((x != goalX || y != goalY) && steps < MAX_STEPS) {
+
+		// other avatars reveal walls anywhere in the maze
+		for (int i = 0; i < REVEALED_PER_MOVE; i++) {
+			int tile = rand_r(&seed) % tiles;
+			int d = rand_r(&seed) % M_NUM_DIRECTIONS;
+			if (!(open[tile] & (1 << d))) {
+				addWall(maze, tile % MAZE_SIZE, tile / MAZE_SIZE, d);
+			}
+		}
+
+		long long start = now();
+		int move = plannerMove(incremental, x, y, goalX, goalY);
+		long long elapsed = now() - start;
+		incrementalTime += elapsed;
+		worstTime = elapsed > worstTime ? elapsed : worstTime;
+		steps++;
+
+		// a full BFS replan from the same position with a fresh planner, for comparison
+		start = now();
+		plannerDelete(bfs);
+		bfs = plannerNew(maze, PLANNER_BFS);
+		plannerMove(bfs, x, y, goalX, goalY);
+		bfsTime += now() - start;
+
+		// the repaired field must match one computed from scratch
+		referenceDistances(maze, goalY * MAZE_SIZE + goalX, expected, queue);
+		for (int i = 0; i < tiles; i++) {
+			if (plannerDistance(incremental, i % MAZE_SIZE, i / MAZE_SIZE) != expected[i]) {
+				mismatches++;
+			}
+		}
+
+		// bump into a wall, or walk through the open edge
+		if (move == M_NULL_MOVE) {
+			break;
+		}
+		if (open[y * MAZE_SIZE + x] & (1 << move)) {
+			addOpening(maze, x, y, move);
+			x += deltaX[move];
+			y += deltaY[move];
+		}
+		else {
+			addWall(maze, x, y, move);
+		}
+	}
+
+	printf("Reached (%d, %d) from (0, 0) in %d moves\n", x, y, steps);
+	printf("%d repairs recomputed %ld tiles, %d full rebuilds\n", plannerRepairs(incremental), plannerRepairedTiles(incremental), plannerReplans(incremental));
+	printf("Incremental move: mean %.1f us, worst %.1f us\n", incrementalTime / 1000.0 / steps, worstTime / 1000.0);
+	printf("Full BFS replan:  mean %.1f us\n", bfsTime / 1000.0 / steps);
+	printf("%d distances differ from a BFS from scratch\n", mismatches);
+
+	// a field copied from another planner, then repaired for the walls found after it was built
+	int replans = plannerReplans(incremental);
+	planner_t *source = plannerNew(maze, PLANNER_INCREMENTAL);
+	plannerUpdate(source, 0, MAZE_SIZE - 1);
+	bool copied = plannerCopyField(incremental, source);
+	plannerDelete(source);
+	for (int i = 0; i < REVEALED_PER_MOVE * 100; i++) {
+		int tile = rand_r(&seed) % tiles;
+		int d = rand_r(&seed) % M_NUM_DIRECTIONS;
+		if (!(open[tile] & (1 << d))) {
+			addWall(maze, tile % MAZE_SIZE, tile / MAZE_SIZE, d);
+		}
+	}
+	plannerMove(incremental, MAZE_SIZE - 1, MAZE_SIZE - 1, 0, MAZE_SIZE - 1);
+	referenceDistances(maze, (MAZE_SIZE - 1) * MAZE_SIZE, expected, queue);
+	int stale = 0;
+	for (int i = 0; i < tiles; i++) {
+		stale += plannerDistance(incremental, i % MAZE_SIZE, i / MAZE_SIZE) != expected[i];
+	}
+	bool kept = copied && plannerReplans(incremental) == replans && stale == 0;
+	printf("A copied field: %d full rebuilds, %d copies, %d distances differ from a BFS from scratch\n",
+			plannerReplans(incremental) - replans, plannerCopies(incremental), stale);
+
+	plannerDelete(incremental);
+	plannerDelete(bfs);
+	mazeDelete(maze);
+	free(open);
+	free(expected);
+	free(queue);
+
+	// the rendezvous through the strategies that use it
+	bool played = true;
+	played = playGame("bfs") && played;
+	played = playGame("incremental") && played;
+
+	if (mismatches != 0 || x != goalX || y != goalY || !kept || !played) {
+		printf("Test Results Failed\n");
+		return 1;
+	}
+	printf("Test Results Successful\n");
+	return 0;
+}
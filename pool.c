@@ -0,0 +1,190 @@
+/*
+ * pool.c - 'pool' module
+ *
+ * see pool.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // rand_r
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "latency.h"
+#include "pool.h"
+
+/*
+ * Each worker owns the block of tasks [next, end). The owner takes 'next' from the front; a
+ * thief moves 'end' back over the half it takes. Both hold the block's lock, which is only
+ * contended while a steal is going on, and each worker's state sits on cache lines of its own.
+ */
+typedef struct worker {
+	_Alignas(64) pthread_mutex_t lock;
+	long next;                // first task of the block not yet taken
+	long end;                 // one past the last
+	struct pool *pool;
+	int id;
+	unsigned int seed;        // for choosing whom to steal from
+	pthread_t thread;
+	long tasks;               // tasks this worker ran
+	long steals;
+	long long busy;           // nanoseconds spent in them
+	long long finished;       // latencyNow() when it found no work left
+} worker_t;
+
+typedef struct pool {
+	worker_t *workers;
+	int count;
+	void (*run)(void *arg, long task, int worker);
+	void *arg;
+	pthread_mutex_t startLock;
+	pthread_cond_t startCond;
+	int state;                // 0 while starting, 1 once every worker is running, -1 if one failed to start
+	long long started;        // latencyNow() when the workers were let go
+} pool_t;
+
+/*
+ *	Takes the next task from the worker's own block
+ */
+static bool takeTask(worker_t *self, long *task) {
+	pthread_mutex_lock(&self->lock);
+	bool taken = self->next < self->end;
+	if (taken) {
+		*task = self->next++;
+	}
+	pthread_mutex_unlock(&self->lock);
+	return taken;
+}
+
+/*
+ *	Moves the back half of another worker's block into the worker's own, trying every other worker once
+ */
+static bool stealTasks(worker_t *self) {
+	pool_t *pool = self->pool;
+	int first = rand_r(&self->seed) % pool->count;
+	for (int i = 0; i < pool->count; i++) {
+		worker_t *victim = &pool->workers[(first + i) % pool->count];
+		if (victim == self) {
+			continue;
+		}
+		pthread_mutex_lock(&victim->lock);
+		long left = victim->end - victim->next;
+		long end = victim->end;
+		if (left > 0) {
+			victim->end -= (left + 1) / 2;
+		}
+		long next = victim->end;
+		pthread_mutex_unlock(&victim->lock);
+		if (left > 0) {
+			// the worker's block is empty, so no thief is looking at it for anything but that
+			pthread_mutex_lock(&self->lock);
+			self->next = next;
+			self->end = end;
+			pthread_mutex_unlock(&self->lock);
+			self->steals++;
+			return true;
+		}
+	}
+	return false;
+}
+
+/*
+ *	Runs the worker's own tasks, then stolen ones, until no worker has any left
+ */
+static void *workerMain(void *arg) {
+	worker_t *self = arg;
+	pool_t *pool = self->pool;
+	pthread_mutex_lock(&pool->startLock);
+	while (pool->state == 0) {
+		pthread_cond_wait(&pool->startCond, &pool->startLock);
+	}
+	bool go = pool->state > 0;
+	pthread_mutex_unlock(&pool->startLock);
+	if (!go) {
+		return NULL;
+	}
+
+	long task;
+	do {
+		while (takeTask(self, &task)) {
+			long long start = latencyNow();
+			pool->run(pool->arg, task, self->id);
+			self->busy += latencyNow() - start;
+			self->tasks++;
+		}
+	} while (stealTasks(self));
+	self->finished = latencyNow();
+	return NULL;
+}
+
+/*
+ *	Splits the tasks into equal blocks, one per worker, and waits for the workers to run them all
+ */
+bool poolRun(int workers, long tasks, void (*run)(void *arg, long task, int worker), void *arg, poolStats_t *stats) {
+	if (workers < 1 || workers > POOL_MAX_WORKERS) {
+		return false;
+	}
+	pool_t pool;
+	pool.workers = aligned_alloc(64, workers * sizeof(worker_t));
+	if (pool.workers == NULL) {
+		fprintf(stderr, "Failed to malloc for pool workers\n");
+		return false;
+	}
+	pool.count = workers;
+	pool.run = run;
+	pool.arg = arg;
+	pool.state = 0;
+	pthread_mutex_init(&pool.startLock, NULL);
+	pthread_cond_init(&pool.startCond, NULL);
+
+	int started = 0;
+	for (; started < workers; started++) {
+		worker_t *worker = &pool.workers[started];
+		pthread_mutex_init(&worker->lock, NULL);
+		worker->next = tasks * started / workers;
+		worker->end = tasks * (started + 1) / workers;
+		worker->pool = &pool;
+		worker->id = started;
+		worker->seed = started + 1;
+		worker->tasks = 0;
+		worker->steals = 0;
+		worker->busy = 0;
+		worker->finished = 0;
+		if (pthread_create(&worker->thread, NULL, workerMain, worker) != 0) {
+			fprintf(stderr, "Error when creating thread for pool worker %d\n", started);
+			pthread_mutex_destroy(&worker->lock);
+			break;
+		}
+	}
+
+	// let the workers go only once all of them exist, so a failure runs no task
+	pthread_mutex_lock(&pool.startLock);
+	pool.state = started == workers ? 1 : -1;
+	pool.started = latencyNow();
+	pthread_cond_broadcast(&pool.startCond);
+	pthread_mutex_unlock(&pool.startLock);
+
+	poolStats_t total = { workers, 0, 0, 0, 0 };
+	for (int k = 0; k < started; k++) {
+		worker_t *worker = &pool.workers[k];
+		pthread_join(worker->thread, NULL);
+		pthread_mutex_destroy(&worker->lock);
+		total.tasks += worker->tasks;
+		total.steals += worker->steals;
+		total.busyNanos += worker->busy;
+		if (worker->finished - pool.started > total.wallNanos) {
+			total.wallNanos = worker->finished - pool.started;
+		}
+	}
+	if (stats != NULL) {
+		*stats = total;
+	}
+	pthread_cond_destroy(&pool.startCond);
+	pthread_mutex_destroy(&pool.startLock);
+	bool ok = pool.state > 0;
+	free(pool.workers);
+	return ok;
+}
@@ -0,0 +1,54 @@
+/*
+ * pool.h - header file for pool module
+ *
+ * This module runs a fixed number of independent tasks, numbered from 0, over a set of worker
+ * threads. Each worker starts with an equal block of the task numbers and runs them from the
+ * front; a worker that runs out steals the back half of the block of another, so tasks that
+ * take longer than their neighbours do not leave the other workers idle. Used by amtournament.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __POOL_H
+#define __POOL_H
+
+#include <stdbool.h>
+
+/**************** constants ****************/
+
+// most workers a pool runs
+#define POOL_MAX_WORKERS 256
+
+/**************** structs ****************/
+
+/**************** poolStats ****************/
+/*
+ * What a run of the pool did.
+ */
+typedef struct poolStats {
+	int workers;              // threads the tasks ran on
+	long tasks;               // tasks run
+	long steals;              // blocks taken from another worker
+	long long busyNanos;      // time spent in tasks, summed over the workers
+	long long wallNanos;      // time from the start of the first task to the end of the last
+} poolStats_t;
+
+/**************** functions ****************/
+
+/**************** poolRun ****************/
+/*
+ * Function which runs every task once and returns when all have finished. Tasks must not depend
+ * on each other, and may run in any order on any worker.
+ *
+ * Input: Number of workers (1 to POOL_MAX_WORKERS), number of tasks, the function to run for
+ * each, called with 'arg', the task's number and the worker running it (0 to workers - 1),
+ * 'arg', where to put the statistics (or NULL).
+ *
+ * Output: False if the workers could not be started; no task has run then.
+ *
+ */
+bool poolRun(int workers, long tasks, void (*run)(void *arg, long task, int worker), void *arg, poolStats_t *stats);
+
+#endif // __POOL_H
@@ -0,0 +1,91 @@
+/*
+ * pooltest.c, a testing module for the work-stealing pool in pool.c
+ *
+ * Every task must run exactly once, on a worker the pool named, however many workers there are
+ * and however few tasks. When a few tasks take far longer than the rest, the workers that run out
+ * must steal from the one still busy. Last, the tasks run per second through the pool are printed.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include "latency.h"
+#include "pool.h"
+#include "testing.h"
+
+/**************** file-local constants ****************/
+#define TASKS 100000
+#define WORKERS 8
+#define SLOW_TASKS 64             // the first ones, all in the first worker's block
+#define SLOW_NANOS 2000000LL
+
+/**************** file-local types ****************/
+typedef struct counts {
+	_Atomic int *runs;            // times each task ran
+	int workers;
+	_Atomic int badWorker;        // tasks run by a worker outside 0 to workers - 1
+	bool slow;                    // make the first tasks slow
+} counts_t;
+
+/**************** file-local functions ****************/
+
+// counts the task's run, spinning first if it is one of the slow ones
+static void countTask(void *arg, long task, int worker) {
+	counts_t *counts = arg;
+	if (counts->slow && task < SLOW_TASKS) {
+		long long start = latencyNow();
+		while (latencyNow() - start < SLOW_NANOS) {
+		}
+	}
+	atomic_fetch_add(&counts->runs[task], 1);
+	if (worker < 0 || worker >= counts->workers) {
+		atomic_fetch_add(&counts->badWorker, 1);
+	}
+}
+
+// runs the tasks through a pool and checks each ran once
+static poolStats_t runCounted(int workers, long tasks, bool slow) {
+	counts_t counts;
+	counts.runs = calloc(tasks > 0 ? tasks : 1, sizeof(_Atomic int));
+	counts.workers = workers;
+	atomic_init(&counts.badWorker, 0);
+	counts.slow = slow;
+	poolStats_t stats;
+	check(poolRun(workers, tasks, countTask, &counts, &stats), "the pool starts");
+	long once = 0;
+	for (long task = 0; task < tasks; task++) {
+		once += atomic_load(&counts.runs[task]) == 1;
+	}
+	check(once == tasks, "every task runs exactly once");
+	check(stats.tasks == tasks, "the pool counts every task");
+	check(stats.workers == workers, "the pool counts its workers");
+	check(atomic_load(&counts.badWorker) == 0, "tasks are told a worker the pool has");
+	free(counts.runs);
+	return stats;
+}
+
+/**************** main() ****************/
+int main(int argc, char *argv[]) {
+	// the odd cases: no tasks, one worker, more workers than tasks
+	runCounted(4, 0, false);
+	runCounted(1, 1000, false);
+	runCounted(WORKERS, 3, false);
+	check(!poolRun(0, 10, countTask, NULL, NULL), "a pool needs a worker");
+	check(!poolRun(POOL_MAX_WORKERS + 1, 10, countTask, NULL, NULL), "a pool has at most POOL_MAX_WORKERS workers");
+
+	// the first worker's block is slow, so the others must take from it
+	poolStats_t stats = runCounted(WORKERS, TASKS, true);
+	printf("%d workers, %d tasks with %d slow: %ld steals\n", WORKERS, TASKS, SLOW_TASKS, stats.steals);
+	check(stats.steals > 0, "idle workers steal from a busy one");
+
+	// tasks per second through the pool when the tasks themselves cost nothing
+	stats = runCounted(WORKERS, TASKS * 10, false);
+	printf("%d workers, %d empty tasks: %.3f s, %.0f tasks per second, %ld steals\n", WORKERS, TASKS * 10,
+			stats.wallNanos / 1e9, stats.wallNanos > 0 ? stats.tasks * 1e9 / stats.wallNanos : 0.0, stats.steals);
+
+	return testResults();
+}
@@ -0,0 +1,272 @@
+/*
+ * render.c - 'render' module
+ *
+ * see render.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // clock_nanosleep
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <curses.h>
+#include <unistd.h>	      // STDOUT_FILENO
+#include <sys/ioctl.h>	      // TIOCGWINSZ
+#include <netdb.h>	      // ntohl
+#include "amazing.h"
+#include "mazeSolver.h"
+#include "graphics.h"
+#include "latency.h"
+#include "framebuffer.h"
+#include "render.h"
+
+#ifndef HEADLESS
+
+#define FRAME_NANOS (1000000000LL / RENDER_FPS)
+
+/*
+ * Avatars write the back buffer and set 'fresh' while holding 'lock'; the render thread swaps
+ * 'front' and 'back' under the same lock and then draws 'front' without it.
+ */
+typedef struct renderer {
+	maze_t *maze;
+	WINDOW *window;                   // curses window, or NULL to write ANSI sequences to stdout
+	framebuffer_t *fb;                // draws frames, or NULL where graphics.c draws the whole maze on the window
+	int nAvatars;
+	pthread_mutex_t lock;
+	XYPos buffers[2][AM_MAX_AVATAR];
+	XYPos *front;
+	XYPos *back;
+	bool fresh;                       // back holds a turn not drawn yet
+	atomic_bool stopping;
+	atomic_bool redraw;               // draw the next frame whole
+	atomic_int frames;
+	int fullFrames;                   // frames drawn whole, written by the render thread only
+	long cells;                       // walls and tiles (or ANSI cells) drawn, written by the render thread only
+	latency_t *frameTimes;            // time per frame, under LATENCY_RENDER of "avatar" 0
+	pthread_mutex_t stopLock;         // lets only one caller join the thread
+	bool running;
+	pthread_t thread;
+} renderer_t;
+
+// sleeps until an absolute time on the monotonic clock
+static void sleepUntil(struct timespec *when) {
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, when, NULL) != 0) {
+	}
+}
+
+// adds the length of one frame to a time
+static void nextFrame(struct timespec *when) {
+	when->tv_nsec += FRAME_NANOS;
+	while (when->tv_nsec >= 1000000000L) {
+		when->tv_nsec -= 1000000000L;
+		when->tv_sec++;
+	}
+}
+
+// draws one frame with whichever backend the renderer has; returns the cells drawn
+static int drawFrame(renderer_t *renderer, bool whole) {
+	if (renderer->fb != NULL) {
+		if (whole) {
+			framebufferRedraw(renderer->fb);
+		}
+		framebufferDraw(renderer->fb, renderer->nAvatars, renderer->front, renderer->maze);
+		int cells = renderer->window != NULL ? framebufferFlushCurses(renderer->fb) : framebufferFlush(renderer->fb, STDOUT_FILENO);
+		return cells < 0 ? 0 : cells;
+	}
+	if (whole) {
+		return redrawMaze(renderer->nAvatars, renderer->front, renderer->maze);
+	}
+	return drawMaze(renderer->nAvatars, renderer->front, renderer->maze);
+}
+
+/*
+ *	Render thread: once a frame, draws the latest published turn if there is a new one
+ */
+static void *renderLoop(void *arg) {
+	renderer_t *renderer = arg;
+	bool drawn = false;
+	struct timespec next;
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (true) {
+		bool stopping = atomic_load(&renderer->stopping);
+
+		// take the newest turn, if any came since the last frame
+		pthread_mutex_lock(&renderer->lock);
+		bool fresh = renderer->fresh;
+		if (fresh) {
+			XYPos *newest = renderer->back;
+			renderer->back = renderer->front;
+			renderer->front = newest;
+			renderer->fresh = false;
+		}
+		pthread_mutex_unlock(&renderer->lock);
+
+		// front is only ever touched by this thread; the first and last frames are drawn whole
+		if (fresh || (stopping && drawn)) {
+			long long start = latencyNow();
+			bool whole = !drawn || stopping || atomic_exchange(&renderer->redraw, false);
+			renderer->cells += drawFrame(renderer, whole);
+			if (whole) {
+				renderer->fullFrames++;
+			}
+			latencyRecord(renderer->frameTimes, 0, LATENCY_RENDER, latencyNow() - start);
+			atomic_fetch_add(&renderer->frames, 1);
+			drawn = true;
+		}
+		if (stopping) {
+			return NULL;
+		}
+
+		// wait for the next frame; a frame that ran late does not make the next ones hurry
+		nextFrame(&next);
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		if (now.tv_sec > next.tv_sec || (now.tv_sec == next.tv_sec && now.tv_nsec > next.tv_nsec)) {
+			next = now;
+		}
+		sleepUntil(&next);
+	}
+}
+
+// a framebuffer sized to the screen, or NULL if graphics.c can draw the whole maze on the curses window
+static framebuffer_t *newFramebuffer(maze_t *maze, WINDOW *window, int zoom, int follow, bool *failed) {
+	// the curses window's size, or the terminal's; 0 if stdout is not a terminal, to show everything
+	int rows = 0, cols = 0;
+	if (window != NULL) {
+		getmaxyx(window, rows, cols);
+	} else {
+		struct winsize size;
+		if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0) {
+			rows = size.ws_row;
+			cols = size.ws_col;
+		}
+	}
+	int height = getMazeHeight(maze);
+	int width = getMazeWidth(maze);
+
+	// a maze bigger than the screen follows avatar 0 unless told otherwise
+	bool fits = (rows == 0 || height * 2 + 1 <= rows) && (cols == 0 || width * 4 + 2 <= cols);
+	if (!fits && follow < 0) {
+		follow = 0;
+	}
+	*failed = false;
+	if (window != NULL && zoom <= 1 && follow < 0) {
+		return NULL;
+	}
+	framebuffer_t *fb = framebufferNew(height, width, rows, cols, zoom, follow);
+	*failed = fb == NULL;
+	return fb;
+}
+
+renderer_t *renderNew(maze_t *maze, int nAvatars, WINDOW *window, int zoom, int follow) {
+	renderer_t *renderer = malloc(sizeof(renderer_t));
+	latency_t *frameTimes = latencyNew(1);
+	bool failed;
+	framebuffer_t *fb = newFramebuffer(maze, window, zoom, follow, &failed);
+	if (renderer == NULL || frameTimes == NULL || failed) {
+		fprintf(stderr, "Failed to malloc for renderer\n");
+		free(renderer);
+		latencyDelete(frameTimes);
+		framebufferDelete(fb);
+		return NULL;
+	}
+	renderer->frameTimes = frameTimes;
+	renderer->fb = fb;
+	renderer->fullFrames = 0;
+	renderer->cells = 0;
+	renderer->maze = maze;
+	renderer->window = window;
+	renderer->nAvatars = nAvatars;
+	renderer->front = renderer->buffers[0];
+	renderer->back = renderer->buffers[1];
+	renderer->fresh = false;
+	atomic_init(&renderer->stopping, false);
+	atomic_init(&renderer->redraw, false);
+	atomic_init(&renderer->frames, 0);
+	pthread_mutex_init(&renderer->lock, NULL);
+	pthread_mutex_init(&renderer->stopLock, NULL);
+	renderer->running = pthread_create(&renderer->thread, NULL, renderLoop, renderer) == 0;
+	if (!renderer->running) {
+		fprintf(stderr, "Failed to start the render thread\n");
+		pthread_mutex_destroy(&renderer->lock);
+		pthread_mutex_destroy(&renderer->stopLock);
+		latencyDelete(frameTimes);
+		framebufferDelete(fb);
+		free(renderer);
+		return NULL;
+	}
+	return renderer;
+}
+
+void renderPublish(renderer_t *renderer, XYPos *positions) {
+	if (renderer == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&renderer->lock);
+	for (int k = 0; k < renderer->nAvatars; k++) {
+		renderer->back[k].x = ntohl(positions[k].x);
+		renderer->back[k].y = ntohl(positions[k].y);
+	}
+	renderer->fresh = true;
+	pthread_mutex_unlock(&renderer->lock);
+}
+
+void renderStop(renderer_t *renderer) {
+	if (renderer == NULL) {
+		return;
+	}
+	pthread_mutex_lock(&renderer->stopLock);
+	if (renderer->running) {
+		atomic_store(&renderer->stopping, true);
+		pthread_join(renderer->thread, NULL);
+		renderer->running = false;
+		if (renderer->window != NULL) {
+			delwin(renderer->window);
+			endwin();
+		} else {
+			framebufferClose(renderer->fb, STDOUT_FILENO);
+		}
+	}
+	pthread_mutex_unlock(&renderer->stopLock);
+}
+
+void renderRedraw(renderer_t *renderer) {
+	atomic_store(&renderer->redraw, true);
+}
+
+int renderFrames(renderer_t *renderer) {
+	return atomic_load(&renderer->frames);
+}
+
+void renderReport(renderer_t *renderer, FILE *fp) {
+	int frames = renderFrames(renderer);
+	fprintf(fp, "Render thread: %d frames (%d whole, at most %d per second), %.1f cells per frame, frame time p50 %.1f us, p99 %.1f us, max %.1f us\n",
+			frames, renderer->fullFrames, RENDER_FPS, frames > 0 ? (double)renderer->cells / frames : 0.0,
+			latencyPercentile(renderer->frameTimes, 0, LATENCY_RENDER, 50) / 1e3,
+			latencyPercentile(renderer->frameTimes, 0, LATENCY_RENDER, 99) / 1e3,
+			latencyMax(renderer->frameTimes, 0, LATENCY_RENDER) / 1e3);
+	if (renderer->window == NULL) {
+		fprintf(fp, "ANSI output: %ld bytes, %.1f per frame\n", framebufferBytes(renderer->fb),
+				frames > 0 ? (double)framebufferBytes(renderer->fb) / frames : 0.0);
+	}
+}
+
+void renderDelete(renderer_t *renderer) {
+	if (renderer != NULL) {
+		renderStop(renderer);
+		pthread_mutex_destroy(&renderer->lock);
+		pthread_mutex_destroy(&renderer->stopLock);
+		latencyDelete(renderer->frameTimes);
+		framebufferDelete(renderer->fb);
+		free(renderer);
+	}
+}
+
+#endif // HEADLESS
@@ -0,0 +1,143 @@
+/*
+ * render.h - header file for render module
+ *
+ * This module draws the game from its own thread. Avatars publish the positions of every turn
+ * into the back half of a double buffer and carry on; the render thread swaps the halves at most
+ * RENDER_FPS times a second and draws the front one, reading walls straight from the shared
+ * maze, which is safe without a lock (see mazeSolver.h). No avatar ever waits for curses.
+ * Frames only draw what changed since the one before (see drawMaze() in graphics.h). Without a
+ * curses window, or when the maze must be scrolled or zoomed to fit the screen, the thread draws
+ * through framebuffer.h instead, to the window or as ANSI sequences to stdout.
+ * Built with make TESTING=-DHEADLESS, every function below is an empty inline and nothing is drawn.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __RENDER_H
+#define __RENDER_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <curses.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+
+/**************** constants ****************/
+
+// frames drawn per second at most: make TESTING=-DRENDER_FPS=60
+#ifndef RENDER_FPS
+#define RENDER_FPS 30
+#endif
+
+/**************** structs ****************/
+
+/**************** renderer ****************/
+/*
+ * The render thread and the snapshots it draws. See render.c for details.
+ */
+typedef struct renderer renderer_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+#ifdef HEADLESS
+
+// no render thread at all: every call compiles away
+static inline renderer_t *renderNew(maze_t *maze, int nAvatars, WINDOW *window, int zoom, int follow) { return NULL; }
+static inline void renderPublish(renderer_t *renderer, XYPos *positions) { }
+static inline void renderStop(renderer_t *renderer) { }
+static inline void renderRedraw(renderer_t *renderer) { }
+static inline int renderFrames(renderer_t *renderer) { return 0; }
+static inline void renderReport(renderer_t *renderer, FILE *fp) { }
+static inline void renderDelete(renderer_t *renderer) { }
+
+#else
+
+/**************** renderNew ****************/
+/*
+ * Function which starts the render thread. Nothing is drawn until the first renderPublish().
+ *
+ * Input: Shared maze, number of avatars, curses window set up by the caller, or NULL to leave
+ * curses alone and write ANSI escape sequences straight to stdout (see framebuffer.h); zoom, 1 for
+ * a character per wall or n > 1 for one per n x n tiles; ID of the avatar to keep in view, or -1.
+ * A maze bigger than the screen is shown through a viewport, which follows avatar 0 if no other is given.
+ *
+ * Output: The renderer, or NULL if memory could not be allocated or the thread not started.
+ *
+ */
+renderer_t *renderNew(maze_t *maze, int nAvatars, WINDOW *window, int zoom, int follow);
+
+/**************** renderPublish ****************/
+/*
+ * Function which hands the render thread the positions of a turn. Copies them into the back
+ * buffer under a lock held only for the copy, and returns without drawing anything.
+ *
+ * Input: Renderer (NULL publishes nothing), positions of all avatars in network byte order,
+ * as in AM_AVATAR_TURN.
+ *
+ * Output: None.
+ *
+ */
+void renderPublish(renderer_t *renderer, XYPos *positions);
+
+/**************** renderStop ****************/
+/*
+ * Function which draws the last published state, stops the render thread and ends curses (or
+ * resets the terminal, for the ANSI backend).
+ * Safe to call from several threads and more than once; every caller returns after curses has ended.
+ *
+ * Input: Renderer, or NULL.
+ *
+ * Output: None.
+ *
+ */
+void renderStop(renderer_t *renderer);
+
+/**************** renderRedraw ****************/
+/*
+ * Function which asks for the next frame to be drawn whole, e.g. after the screen was disturbed.
+ *
+ * Input: Renderer.
+ *
+ * Output: None.
+ *
+ */
+void renderRedraw(renderer_t *renderer);
+
+/**************** renderFrames ****************/
+/*
+ * Input: Renderer.
+ *
+ * Output: Number of frames drawn so far.
+ *
+ */
+int renderFrames(renderer_t *renderer);
+
+/**************** renderReport ****************/
+/*
+ * Function which prints the frames drawn, how many were whole, the mean walls and tiles drawn
+ * per frame, and the p50, p99 and max time per frame, plus the bytes written by the ANSI
+ * backend. Call it after renderStop().
+ *
+ * Input: Renderer, where to print.
+ *
+ * Output: None.
+ *
+ */
+void renderReport(renderer_t *renderer, FILE *fp);
+
+/**************** renderDelete ****************/
+/*
+ * Function which stops the renderer if it is still running and frees it.
+ *
+ * Input: Renderer, or NULL.
+ *
+ * Output: None.
+ *
+ */
+void renderDelete(renderer_t *renderer);
+
+#endif // HEADLESS
+
+#endif // __RENDER_H
@@ -0,0 +1,324 @@
+/*
+ * rendezvous.c - 'rendezvous' module
+ *
+ * see rendezvous.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <netdb.h>        // ntohl
+#include <pthread.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+#include "planner.h"
+#include "rendezvous.h"
+
+/*
+ * One BFS per avatar fills 'distance'; every tile then accumulates how many avatars reach it,
+ * the farthest of them and their total distance. 'field', an incremental planner with the target
+ * as its goal, is repaired for each new wall and gives the target's cost from wherever the
+ * avatars have moved to.
+ *
+ * Walls only lengthen distances, and an avatar that took n steps since the last search is at most
+ * n steps closer to any tile, so no tile can now beat 'best' by more than the steps taken ('moved').
+ * While the target is within RENDEZVOUS_HYSTERESIS of that bound the search would keep it, and it
+ * is not run. 'lock' serialises avatar threads.
+ */
+typedef struct rendezvous {
+	maze_t *maze;
+	int mode;
+	int width;
+	int height;
+	int *distance;        // steps from the avatar being searched from, -1 if not reached
+	int *queue;           // BFS frontier, one slot per tile
+	int *reached;         // number of avatars that can reach each tile
+	int *farthest;        // longest distance from any of them
+	int *total;           // sum of their distances
+	planner_t *field;     // distances to the target
+	int best;             // farthest or total distance of the best tile at the last search
+	int moved[AM_MAX_AVATAR];   // steps each avatar has taken since then, LOST_STEPS if unknown
+	int lastX[AM_MAX_AVATAR];
+	int lastY[AM_MAX_AVATAR];
+	size_t lastWalls;
+	int searches;
+	int targetX;
+	int targetY;
+	int cost;
+	int retargets;
+	pthread_mutex_t lock;
+} rendezvous_t;
+
+// steps taken by an avatar seen more than one tile away from where it last was, which bound nothing
+#define LOST_STEPS (1 << 20)
+
+/*
+ *	Creates a rendezvous with scratch space for every tile of the maze
+ */
+rendezvous_t *rendezvousNew(maze_t *maze, int mode) {
+	rendezvous_t *rendezvous = malloc(sizeof(rendezvous_t));
+	if (rendezvous == NULL) {
+		fprintf(stderr, "Failed to malloc for rendezvous\n");
+		return NULL;
+	}
+	if (pthread_mutex_init(&rendezvous->lock, NULL) != 0) {
+		fprintf(stderr, "Failed to init rendezvous lock\n");
+		free(rendezvous);
+		return NULL;
+	}
+	rendezvous->maze = maze;
+	rendezvous->mode = mode;
+	rendezvous->width = getMazeWidth(maze);
+	rendezvous->height = getMazeHeight(maze);
+	int tiles = rendezvous->width * rendezvous->height;
+
+	rendezvous->distance = malloc(tiles * sizeof(int));
+	rendezvous->queue = malloc(tiles * sizeof(int));
+	rendezvous->reached = malloc(tiles * sizeof(int));
+	rendezvous->farthest = malloc(tiles * sizeof(int));
+	rendezvous->total = malloc(tiles * sizeof(int));
+	rendezvous->field = plannerNew(maze, PLANNER_INCREMENTAL);
+	if (rendezvous->distance == NULL || rendezvous->queue == NULL || rendezvous->reached == NULL
+			|| rendezvous->farthest == NULL || rendezvous->total == NULL || rendezvous->field == NULL) {
+		fprintf(stderr, "Failed to malloc for rendezvous scratch space\n");
+		rendezvousDelete(rendezvous);
+		return NULL;
+	}
+	rendezvous->best = 0;
+	for (int k = 0; k < AM_MAX_AVATAR; k++) {
+		rendezvous->moved[k] = LOST_STEPS;
+		rendezvous->lastX[k] = -1;
+		rendezvous->lastY[k] = -1;
+	}
+	rendezvous->lastWalls = 0;
+	rendezvous->searches = 0;
+	rendezvous->targetX = -1;
+	rendezvous->targetY = -1;
+	rendezvous->cost = -1;
+	rendezvous->retargets = 0;
+	return rendezvous;
+}
+
+/*
+ *	Frees a rendezvous and its scratch space
+ */
+void rendezvousDelete(rendezvous_t *rendezvous) {
+	if (rendezvous != NULL) {
+		pthread_mutex_destroy(&rendezvous->lock);
+		free(rendezvous->distance);
+		free(rendezvous->queue);
+		free(rendezvous->reached);
+		free(rendezvous->farthest);
+		free(rendezvous->total);
+		plannerDelete(rendezvous->field);
+		free(rendezvous);
+	}
+}
+
+void rendezvousTarget(rendezvous_t *rendezvous, int *x, int *y) {
+	pthread_mutex_lock(&rendezvous->lock);
+	*x = rendezvous->targetX;
+	*y = rendezvous->targetY;
+	pthread_mutex_unlock(&rendezvous->lock);
+}
+
+int rendezvousCost(rendezvous_t *rendezvous) {
+	pthread_mutex_lock(&rendezvous->lock);
+	int cost = rendezvous->cost;
+	pthread_mutex_unlock(&rendezvous->lock);
+	return cost;
+}
+
+int rendezvousRetargets(rendezvous_t *rendezvous) {
+	pthread_mutex_lock(&rendezvous->lock);
+	int retargets = rendezvous->retargets;
+	pthread_mutex_unlock(&rendezvous->lock);
+	return retargets;
+}
+
+int rendezvousSearches(rendezvous_t *rendezvous) {
+	pthread_mutex_lock(&rendezvous->lock);
+	int searches = rendezvous->searches;
+	pthread_mutex_unlock(&rendezvous->lock);
+	return searches;
+}
+
+/*
+ *	Runs a BFS from one avatar and adds its distance to every tile it reaches
+ */
+static void accumulateDistances(rendezvous_t *rendezvous, int x, int y) {
+	int width = rendezvous->width;
+	int tiles = width * rendezvous->height;
+	int *distance = rendezvous->distance;
+	int head = 0;
+	int tail = 0;
+
+	for (int tile = 0; tile < tiles; tile++) {
+		distance[tile] = -1;
+	}
+	distance[y * width + x] = 0;
+	rendezvous->queue[tail++] = y * width + x;
+	while (head < tail) {
+		int tile = rendezvous->queue[head++];
+		rendezvous->reached[tile]++;
+		rendezvous->total[tile] += distance[tile];
+		if (distance[tile] > rendezvous->farthest[tile]) {
+			rendezvous->farthest[tile] = distance[tile];
+		}
+
+		// unknown edges are optimistically treated as open
+		int walls = getWalls(rendezvous->maze, tile % width, tile / width);
+		for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+			int next = tile + deltaY[direction] * width + deltaX[direction];
+			if (!(walls & (1 << direction)) && distance[next] < 0) {
+				distance[next] = distance[tile] + 1;
+				rendezvous->queue[tail++] = next;
+			}
+		}
+	}
+}
+
+/*
+ *	Copies the target's distance field into an avatar's planner whose goal is not the target yet
+ */
+bool rendezvousShareField(rendezvous_t *rendezvous, planner_t *planner) {
+	pthread_mutex_lock(&rendezvous->lock);
+	bool copied = plannerCopyField(planner, rendezvous->field);
+	pthread_mutex_unlock(&rendezvous->lock);
+	return copied;
+}
+
+/*
+ *	Adds the steps each avatar took since the last update to its count, giving up on one that jumped
+ */
+static void countSteps(rendezvous_t *rendezvous, XYPos *positions, int numAvatars) {
+	for (int k = 0; k < numAvatars; k++) {
+		int x = ntohl(positions[k].x);
+		int y = ntohl(positions[k].y);
+		int steps = abs(x - rendezvous->lastX[k]) + abs(y - rendezvous->lastY[k]);
+		if (steps > 1 || rendezvous->moved[k] >= LOST_STEPS) {
+			rendezvous->moved[k] = LOST_STEPS;
+		}
+		else {
+			rendezvous->moved[k] += steps;
+		}
+		rendezvous->lastX[k] = x;
+		rendezvous->lastY[k] = y;
+	}
+}
+
+/*
+ *	Gives the least farthest (or total) distance any tile can have now, from the last search and the steps taken since
+ */
+static int lowerBound(rendezvous_t *rendezvous, int numAvatars) {
+	int steps = 0;
+	for (int k = 0; k < numAvatars; k++) {
+		int moved = rendezvous->moved[k];
+		steps = rendezvous->mode == RENDEZVOUS_MINSUM ? steps + moved : (moved > steps ? moved : steps);
+	}
+	return rendezvous->best - steps;
+}
+
+/*
+ *	Gives the target's cost from 'field' for the avatars where they stand now, or -1 if one of them cannot reach it
+ */
+static int targetCost(rendezvous_t *rendezvous, XYPos *positions, int numAvatars) {
+	int cost = 0;
+	for (int k = 0; k < numAvatars; k++) {
+		int x = ntohl(positions[k].x);
+		int y = ntohl(positions[k].y);
+		if (x < 0 || y < 0 || x >= rendezvous->width || y >= rendezvous->height) {
+			continue;
+		}
+		int distance = plannerDistance(rendezvous->field, x, y);
+		if (distance < 0) {
+			return -1;
+		}
+		cost = rendezvous->mode == RENDEZVOUS_MINSUM ? cost + distance : (distance > cost ? distance : cost);
+	}
+	return cost;
+}
+
+/*
+ *	Chooses the meeting tile from the latest positions, keeping the current one unless another is clearly better
+ */
+bool rendezvousUpdate(rendezvous_t *rendezvous, XYPos *positions, int numAvatars) {
+	pthread_mutex_lock(&rendezvous->lock);
+	int width = rendezvous->width;
+	int tiles = width * rendezvous->height;
+	size_t walls = getWallEventCount(rendezvous->maze);
+	countSteps(rendezvous, positions, numAvatars);
+
+	// keep the target without a search while no new wall was found, or the new ones leave it close enough to any other tile,
+	// which is what the search would decide
+	if (rendezvous->targetX >= 0) {
+		plannerUpdate(rendezvous->field, rendezvous->targetX, rendezvous->targetY);
+		int cost = targetCost(rendezvous, positions, numAvatars);
+		if (cost >= 0 && (walls == rendezvous->lastWalls || cost <= lowerBound(rendezvous, numAvatars) + RENDEZVOUS_HYSTERESIS)) {
+			rendezvous->cost = cost;
+			rendezvous->lastWalls = walls;
+			pthread_mutex_unlock(&rendezvous->lock);
+			return false;
+		}
+	}
+	rendezvous->searches++;
+
+	// search from every avatar
+	for (int tile = 0; tile < tiles; tile++) {
+		rendezvous->reached[tile] = 0;
+		rendezvous->farthest[tile] = 0;
+		rendezvous->total[tile] = 0;
+	}
+	for (int k = 0; k < numAvatars; k++) {
+		int x = ntohl(positions[k].x);
+		int y = ntohl(positions[k].y);
+		if (x >= 0 && y >= 0 && x < width && y < rendezvous->height) {
+			accumulateDistances(rendezvous, x, y);
+		}
+	}
+
+	// best tile every avatar can reach, breaking ties on the other measure and then on position
+	int *primary = rendezvous->mode == RENDEZVOUS_MINSUM ? rendezvous->total : rendezvous->farthest;
+	int *secondary = rendezvous->mode == RENDEZVOUS_MINSUM ? rendezvous->farthest : rendezvous->total;
+	int best = -1;
+	for (int tile = 0; tile < tiles; tile++) {
+		if (rendezvous->reached[tile] == numAvatars && (best < 0 || primary[tile] < primary[best]
+				|| (primary[tile] == primary[best] && secondary[tile] < secondary[best]))) {
+			best = tile;
+		}
+	}
+
+	// stay on the current target while it is reachable and close enough to the best
+	bool moved = false;
+	if (best >= 0) {
+		int current = rendezvous->targetY * width + rendezvous->targetX;
+		if (rendezvous->targetX >= 0 && rendezvous->reached[current] == numAvatars
+				&& primary[current] <= primary[best] + RENDEZVOUS_HYSTERESIS) {
+			rendezvous->cost = primary[current];
+		}
+		else {
+			rendezvous->retargets += rendezvous->targetX >= 0;
+			rendezvous->targetX = best % width;
+			rendezvous->targetY = best / width;
+			rendezvous->cost = primary[best];
+			moved = true;
+		}
+	}
+
+	// the bound for the following updates starts again from here
+	if (best >= 0) {
+		rendezvous->best = primary[best];
+		for (int k = 0; k < numAvatars; k++) {
+			rendezvous->moved[k] = 0;
+		}
+	}
+	if (rendezvous->targetX >= 0) {
+		plannerUpdate(rendezvous->field, rendezvous->targetX, rendezvous->targetY);
+		rendezvous->lastWalls = walls;
+	}
+	pthread_mutex_unlock(&rendezvous->lock);
+	return moved;
+}
@@ -0,0 +1,140 @@
+/*
+ * rendezvous.h - header file for rendezvous module
+ *
+ * This module picks the tile all avatars meet on. From the walls discovered so far and the
+ * positions in the latest AM_AVATAR_TURN it chooses the tile that minimises the longest (or the
+ * total) distance any avatar has to walk, and moves that target as the map fills in.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __RENDEZVOUS_H
+#define __RENDEZVOUS_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "amazing.h"
+#include "mazeSolver.h"
+#include "planner.h"
+
+/**************** constants ****************/
+
+/*
+ * Rendezvous modes, passed to rendezvousNew().
+ * RENDEZVOUS_MINMAX minimises the distance of the avatar farthest from the target. The server
+ * hands out turns round-robin, so this is the number of rounds, and moves, until everyone meets.
+ * RENDEZVOUS_MINSUM minimises the total distance walked by all avatars.
+ */
+#define RENDEZVOUS_MINMAX 0
+#define RENDEZVOUS_MINSUM 1
+
+/*
+ * A new target must beat the current one by more than this many steps before avatars are sent
+ * to it, so they do not flip between two nearly equal tiles and waste the moves already made.
+ */
+#define RENDEZVOUS_HYSTERESIS 2
+
+/**************** structs ****************/
+
+/**************** rendezvous ****************/
+/*
+ * Meeting point shared by every avatar thread, with the BFS scratch space used to choose it.
+ * See rendezvous.c for details.
+ */
+typedef struct rendezvous rendezvous_t;  // opaque to users of the module
+
+/**************** functions ****************/
+
+/**************** rendezvousNew ****************/
+/*
+ * Function which creates a rendezvous for one game.
+ *
+ * Input: The shared maze the distances are measured over, RENDEZVOUS_MINMAX or RENDEZVOUS_MINSUM.
+ *
+ * Output: A rendezvous with no target yet, or NULL if memory could not be allocated.
+ *
+ */
+rendezvous_t *rendezvousNew(maze_t *maze, int mode);
+
+/**************** rendezvousDelete ****************/
+/*
+ * Function which frees all memory held by a rendezvous.
+ *
+ * Input: Rendezvous created by rendezvousNew().
+ *
+ * Output: None.
+ *
+ */
+void rendezvousDelete(rendezvous_t *rendezvous);
+
+/**************** rendezvousUpdate ****************/
+/*
+ * Function which chooses the meeting tile again. Called by whichever avatar holds the turn, so
+ * the target follows the map as it fills in. Distances are BFS distances over every edge not
+ * known to be a wall. The current target is kept while it is still reachable by every avatar
+ * and no more than RENDEZVOUS_HYSTERESIS steps worse than the best tile. The target's distance
+ * field is repaired for each new wall, as a PLANNER_INCREMENTAL planner does, and gives its cost.
+ * The search from every avatar only runs again when a new wall makes the target unreachable or
+ * leaves it possibly more than RENDEZVOUS_HYSTERESIS behind another tile, bounded from the last
+ * search and the steps taken since; a turn that keeps the target costs a lookup per avatar.
+ * Safe to call from any avatar thread.
+ *
+ * Input: Rendezvous, avatar positions from an AM_AVATAR_TURN (network byte order), number of avatars.
+ *
+ * Output: True if the target moved.
+ *
+ */
+bool rendezvousUpdate(rendezvous_t *rendezvous, XYPos *positions, int numAvatars);
+
+/**************** rendezvousShareField ****************/
+/*
+ * Function which hands the target's distance field to an avatar's PLANNER_INCREMENTAL planner
+ * when the target has moved away from the planner's goal, so every avatar does not build the
+ * same field again. Safe to call from any avatar thread.
+ *
+ * Input: Rendezvous, the avatar's planner.
+ *
+ * Output: True if the field was copied (see plannerCopyField).
+ *
+ */
+bool rendezvousShareField(rendezvous_t *rendezvous, planner_t *planner);
+
+/**************** rendezvousTarget ****************/
+/*
+ * Input: Rendezvous, pointers for the target coordinates.
+ *
+ * Output: Sets x and y to the current meeting tile, or to -1 before the first rendezvousUpdate().
+ *
+ */
+void rendezvousTarget(rendezvous_t *rendezvous, int *x, int *y);
+
+/**************** rendezvousCost ****************/
+/*
+ * Input: Rendezvous.
+ *
+ * Output: Longest (RENDEZVOUS_MINMAX) or total (RENDEZVOUS_MINSUM) distance to the current target, or -1 if there is none.
+ *
+ */
+int rendezvousCost(rendezvous_t *rendezvous);
+
+/**************** rendezvousSearches ****************/
+/*
+ * Input: Rendezvous.
+ *
+ * Output: Number of times the meeting tile was chosen again by searching from every avatar.
+ *
+ */
+int rendezvousSearches(rendezvous_t *rendezvous);
+
+/**************** rendezvousRetargets ****************/
+/*
+ * Input: Rendezvous.
+ *
+ * Output: Number of times the target has moved after it was first chosen.
+ *
+ */
+int rendezvousRetargets(rendezvous_t *rendezvous);
+
+#endif // __RENDEZVOUS_H
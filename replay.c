@@ -0,0 +1,100 @@
+/*
+ * replay.c - 'replay' module
+ *
+ * see replay.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <netdb.h>	      // ntohl
+#include "amazing.h"
+#include "avatar.h"
+#include "capture.h"
+#include "replay.h"
+
+bool replayGame(capture_t *capture, AM_Message *initOk, int *nAvatars, int *difficulty) {
+	captureRecord_t record;
+	bool haveInit = false;
+	while (captureRead(capture, &record) && record.avatarID == CAPTURE_STARTUP) {
+		uint32_t type = ntohl(record.message.type);
+		if (record.sent && type == AM_INIT) {
+			*nAvatars = ntohl(record.message.init.nAvatars);
+			*difficulty = ntohl(record.message.init.Difficulty);
+			haveInit = *nAvatars > 0 && *nAvatars <= AM_MAX_AVATAR;
+		} else if (!record.sent && type == AM_INIT_OK) {
+			*initOk = record.message;
+			return haveInit;
+		} else if (!record.sent) {
+			return false;
+		}
+	}
+	return false;
+}
+
+// notes a recorded move that the session made differently, or did not make
+static void compareMove(replayResult_t *result, avatarSession_t *session, int avatarID, int *recorded, AM_Message *message) {
+	int direction = ntohl(message->avatar_move.Direction);
+	int lastMove;
+	int made = avatarMoves(session, &lastMove);
+	recorded[avatarID]++;
+	result->moves++;
+	if (made == recorded[avatarID] && lastMove == direction) {
+		return;
+	}
+	result->differences++;
+	if (result->firstAvatar < 0) {
+		result->firstAvatar = avatarID;
+		result->firstMove = recorded[avatarID];
+		result->recordedDirection = direction;
+		result->replayedDirection = made >= recorded[avatarID] ? lastMove : -1;
+	}
+}
+
+/*
+ *	Hands each received message to its avatar and checks each sent move, in the order captured
+ */
+void runReplay(capture_t *capture, avatarSession_t **sessions, int numAvatars, replayResult_t *result) {
+	result->messages = 0;
+	result->moves = 0;
+	result->differences = 0;
+	result->firstAvatar = -1;
+	result->firstMove = 0;
+	result->recordedDirection = -1;
+	result->replayedDirection = -1;
+	result->capturedNanos = 0;
+
+	int recorded[AM_MAX_AVATAR] = { 0 };
+	int playing = numAvatars;
+	captureRecord_t record;
+	while (playing > 0 && captureRead(capture, &record)) {
+		result->capturedNanos = record.nanos;
+		int k = record.avatarID;
+		if (k < 0 || k >= numAvatars || sessions[k] == NULL) {
+			continue;
+		}
+		if (record.sent) {
+			if (ntohl(record.message.type) == AM_AVATAR_MOVE) {
+				compareMove(result, sessions[k], k, recorded, &record.message);
+			}
+			continue;
+		}
+		result->messages++;
+		if (!avatarDeliver(sessions[k], &record.message)) {
+			avatarSessionDelete(sessions[k]);
+			sessions[k] = NULL;
+			playing--;
+		}
+	}
+
+	// avatars whose game the capture did not see the end of
+	for (int k = 0; k < numAvatars; k++) {
+		if (sessions[k] != NULL) {
+			avatarSessionDelete(sessions[k]);
+			sessions[k] = NULL;
+		}
+	}
+}
@@ -0,0 +1,66 @@
+/*
+ * replay.h - header file for replay module
+ *
+ * This module plays a game back from a capture (see capture.h) instead of a server: every
+ * message an avatar received is handed to its session, in the order of the capture, and every
+ * move the session makes is checked against the one recorded. The strategy runs at full speed
+ * with no network, and a change to it that makes any avatar move differently is caught at the
+ * first move it changes. Used by amreplay.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __REPLAY_H
+#define __REPLAY_H
+
+#include <stdbool.h>
+#include "amazing.h"
+#include "avatar.h"
+#include "capture.h"
+
+/**************** structs ****************/
+
+/**************** replayResult ****************/
+/*
+ * What a replay found.
+ */
+typedef struct replayResult {
+	long messages;            // messages handed to sessions
+	long moves;               // recorded moves compared
+	long differences;         // of those, moves the sessions made differently
+	int firstAvatar;          // avatar whose move differed first, -1 if none did
+	int firstMove;            // which of its moves (1 for its first)
+	int recordedDirection;    // what it did in the capture
+	int replayedDirection;    // and what it did now (-1 if it made no move)
+	long long capturedNanos;  // how long the game took when captured
+} replayResult_t;
+
+/**************** functions ****************/
+
+/**************** replayGame ****************/
+/*
+ * Function which reads the AM_INIT and AM_INIT_OK a capture starts with.
+ *
+ * Input: Capture from captureOpen(), where to put the AM_INIT_OK, number of avatars and difficulty.
+ *
+ * Output: False if the capture does not start with a game that was accepted.
+ *
+ */
+bool replayGame(capture_t *capture, AM_Message *initOk, int *nAvatars, int *difficulty);
+
+/**************** runReplay ****************/
+/*
+ * Function which plays the rest of a capture through the sessions from the calling thread,
+ * until the capture ends or every avatar's game is over.
+ *
+ * Input: Capture past replayGame(), sessions given connections by avatarConnectOffline, one per
+ * avatar (the replay deletes them), number of avatars, where to put what was found.
+ *
+ * Output: None.
+ *
+ */
+void runReplay(capture_t *capture, avatarSession_t **sessions, int numAvatars, replayResult_t *result);
+
+#endif // __REPLAY_H
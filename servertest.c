@@ -0,0 +1,235 @@
+/*
+ * servertest.c, a testing module that plays games against amserver over loopback
+ *
+ * Starts ./amserver, checks that bad AM_INIT requests, unknown avatars and moves out of turn
+ * get the error the protocol in amazing.h asks for, then plays a whole game: every avatar but
+ * the last follows the left wall until it stands on the last avatar's tile. The game must end
+ * in AM_MAZE_SOLVED with the number of moves sent, and the moves per second over loopback are
+ * reported. A second server with a tiny move limit must end its game with AM_TOO_MANY_MOVES,
+ * and a third started with -f, which sends every message in small pieces, must still be solved.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#define _POSIX_C_SOURCE 200809L   // clock_gettime, kill
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>	      // memset
+#include <unistd.h>	      // fork, exec, close
+#include <signal.h>
+#include <time.h>
+#include <netdb.h>	      // socket-related structures
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include "amazing.h"
+#include "testing.h"
+
+/**************** file-local constants ****************/
+#define NUM_AVATARS 3
+#define DIFFICULTY 2
+#define MAX_MOVES "100000"
+
+// clockwise and anticlockwise neighbour of each direction
+static const int rightOf[M_NUM_DIRECTIONS] = { M_NORTH, M_EAST, M_WEST, M_SOUTH };
+static const int leftOf[M_NUM_DIRECTIONS] = { M_SOUTH, M_WEST, M_EAST, M_NORTH };
+
+/**************** file-local functions ****************/
+
+// nanoseconds on the monotonic clock
+static long long now(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// starts ./amserver on a port with the given move limit, optionally sending messages in pieces
+static pid_t startServer(int port, const char *maxMoves, bool fragment) {
+	char portString[16];
+	sprintf(portString, "%d", port);
+	pid_t pid = fork();
+	if (pid == 0) {
+		execl("./amserver", "amserver", "-p", portString, "-s", "7", "-m", maxMoves, fragment ? "-f" : (char *)NULL, (char *)NULL);
+		perror("starting ./amserver");
+		exit(1);
+	}
+	return pid;
+}
+
+// connects to a loopback port, retrying while the server starts up; reads time out after 5 s
+static int connectTo(int port) {
+	struct sockaddr_in server;
+	memset(&server, 0, sizeof(server));
+	server.sin_family = AF_INET;
+	server.sin_port = htons(port);
+	server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	for (int attempt = 0; attempt < 100; attempt++) {
+		int fd = socket(AF_INET, SOCK_STREAM, 0);
+		if (connect(fd, (struct sockaddr *) &server, sizeof(server)) == 0) {
+			struct timeval timeout = { 5, 0 };
+			setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+			return fd;
+		}
+		close(fd);
+		struct timespec pause = { 0, 20000000 };
+		nanosleep(&pause, NULL);
+	}
+	return -1;
+}
+
+static void sendMessage(int fd, uint32_t type, uint32_t first, uint32_t second) {
+	AM_Message message;
+	memset(&message, 0, sizeof(message));
+	message.type = htonl(type);
+	message.init.nAvatars = htonl(first);
+	message.init.Difficulty = htonl(second);
+	send(fd, &message, sizeof(message), 0);
+}
+
+// reads one whole message; a closed socket or timeout reads as type 0
+static AM_Message receiveMessage(int fd) {
+	AM_Message message;
+	memset(&message, 0, sizeof(message));
+	if (recv(fd, &message, sizeof(message), MSG_WAITALL) != sizeof(message)) {
+		message.type = 0;
+	}
+	message.type = ntohl(message.type);
+	return message;
+}
+
+// sends AM_INIT on a new connection and returns the answer
+static AM_Message requestGame(int port, int nAvatars, int difficulty) {
+	int fd = connectTo(port);
+	sendMessage(fd, AM_INIT, nAvatars, difficulty);
+	AM_Message response = receiveMessage(fd);
+	close(fd);
+	return response;
+}
+
+// plays one game with wall-following avatars; returns the message that ended it
+static AM_Message playGame(int mazePort, int *movesSent, double *seconds) {
+	int fds[NUM_AVATARS];
+	int facing[NUM_AVATARS];
+	int lastX[NUM_AVATARS];
+	int lastY[NUM_AVATARS];
+
+	// an avatar ID outside the game is refused
+	int stranger = connectTo(mazePort);
+	sendMessage(stranger, AM_AVATAR_READY, 7, 0);
+	check(receiveMessage(stranger).type == AM_NO_SUCH_AVATAR, "AM_AVATAR_READY for avatar 7 of 3 answered with AM_NO_SUCH_AVATAR");
+	close(stranger);
+
+	for (int k = 0; k < NUM_AVATARS; k++) {
+		fds[k] = connectTo(mazePort);
+		sendMessage(fds[k], AM_AVATAR_READY, k, 0);
+		facing[k] = M_NORTH;
+		lastX[k] = -1;
+		lastY[k] = -1;
+	}
+
+	*movesSent = 0;
+	bool first = true;
+	long long start = now();
+	while (true) {
+		// every avatar gets the same message
+		AM_Message message = receiveMessage(fds[0]);
+		for (int k = 1; k < NUM_AVATARS; k++) {
+			check(receiveMessage(fds[k]).type == message.type, "every avatar receives the same message");
+		}
+		if (message.type != AM_AVATAR_TURN) {
+			*seconds = (now() - start) / 1e9;
+			for (int k = 0; k < NUM_AVATARS; k++) {
+				close(fds[k]);
+			}
+			return message;
+		}
+		int turn = ntohl(message.avatar_turn.TurnId);
+		int x = ntohl(message.avatar_turn.Pos[turn].x);
+		int y = ntohl(message.avatar_turn.Pos[turn].y);
+		int goalX = ntohl(message.avatar_turn.Pos[NUM_AVATARS - 1].x);
+		int goalY = ntohl(message.avatar_turn.Pos[NUM_AVATARS - 1].y);
+
+		// moving out of turn is refused, on that avatar's socket only
+		if (first) {
+			int other = (turn + 1) % NUM_AVATARS;
+			sendMessage(fds[other], AM_AVATAR_MOVE, other, M_NULL_MOVE);
+			check(receiveMessage(fds[other]).type == AM_AVATAR_OUT_OF_TURN, "a move out of turn is answered with AM_AVATAR_OUT_OF_TURN");
+			first = false;
+		}
+
+		// left wall follower: turn left after a step, turn right after a bump
+		int move = M_NULL_MOVE;
+		if (turn != NUM_AVATARS - 1 && (x != goalX || y != goalY)) {
+			if (lastX[turn] >= 0) {
+				bool moved = x != lastX[turn] || y != lastY[turn];
+				facing[turn] = moved ? leftOf[facing[turn]] : rightOf[facing[turn]];
+			}
+			move = facing[turn];
+			lastX[turn] = x;
+			lastY[turn] = y;
+		}
+		sendMessage(fds[turn], AM_AVATAR_MOVE, turn, move);
+		(*movesSent)++;
+	}
+}
+
+// Testing function
+int main(int argc, char *argv[]) {
+	int port = 17300 + getpid() % 500;
+	pid_t server = startServer(port, MAX_MOVES, false);
+
+	// requests the server must turn down
+	AM_Message response = requestGame(port, NUM_AVATARS, AM_MAX_DIFFICULTY + 1);
+	check(response.type == AM_INIT_FAILED && ntohl(response.init_failed.ErrNum) == AM_INIT_BAD_DIFFICULTY, "difficulty 10 is answered with AM_INIT_BAD_DIFFICULTY");
+	response = requestGame(port, AM_MAX_AVATAR + 1, DIFFICULTY);
+	check(response.type == AM_INIT_FAILED && ntohl(response.init_failed.ErrNum) == AM_INIT_TOO_MANY_AVATARS, "11 avatars are answered with AM_INIT_TOO_MANY_AVATARS");
+	int fd = connectTo(port);
+	sendMessage(fd, 0x12345678, 0, 0);
+	response = receiveMessage(fd);
+	check(response.type == AM_UNKNOWN_MSG_TYPE && ntohl(response.unknown_msg_type.BadType) == 0x12345678, "an unknown message type is answered with AM_UNKNOWN_MSG_TYPE");
+	close(fd);
+
+	// a whole game
+	response = requestGame(port, NUM_AVATARS, DIFFICULTY);
+	check(response.type == AM_INIT_OK, "AM_INIT for 3 avatars at difficulty 2 is answered with AM_INIT_OK");
+	printf("Difficulty %d maze is %dx%d on port %d\n", DIFFICULTY, ntohl(response.init_ok.MazeWidth), ntohl(response.init_ok.MazeHeight), ntohl(response.init_ok.MazePort));
+	check(ntohl(response.init_ok.MazeWidth) == 30 && ntohl(response.init_ok.MazeHeight) == 30, "difficulty 2 maze is 30x30");
+	int moves = 0;
+	double seconds = 0;
+	if (response.type == AM_INIT_OK) {
+		response = playGame(ntohl(response.init_ok.MazePort), &moves, &seconds);
+		check(response.type == AM_MAZE_SOLVED, "the game ends with AM_MAZE_SOLVED");
+		check((int)ntohl(response.maze_solved.nMoves) == moves, "AM_MAZE_SOLVED counts every move sent");
+		check(ntohl(response.maze_solved.nAvatars) == NUM_AVATARS && ntohl(response.maze_solved.Difficulty) == DIFFICULTY, "AM_MAZE_SOLVED repeats the game's avatars and difficulty");
+		printf("Solved in %d moves, hash %u: %.0f moves per second over loopback\n", moves, ntohl(response.maze_solved.Hash), moves / seconds);
+	}
+	kill(server, SIGTERM);
+	waitpid(server, NULL, 0);
+
+	// a server with a move limit of 5 stops the game after the fifth move
+	server = startServer(port + 1, "5", false);
+	response = requestGame(port + 1, NUM_AVATARS, 0);
+	if (response.type == AM_INIT_OK) {
+		response = playGame(ntohl(response.init_ok.MazePort), &moves, &seconds);
+	}
+	check(response.type == AM_TOO_MANY_MOVES && moves == 5, "the game ends with AM_TOO_MANY_MOVES after 5 moves");
+	kill(server, SIGTERM);
+	waitpid(server, NULL, 0);
+
+	// the same first game again with every message sent in pieces
+	server = startServer(port + 2, MAX_MOVES, true);
+	response = requestGame(port + 2, NUM_AVATARS, DIFFICULTY);
+	if (response.type == AM_INIT_OK) {
+		response = playGame(ntohl(response.init_ok.MazePort), &moves, &seconds);
+	}
+	check(response.type == AM_MAZE_SOLVED, "a game sent in pieces by amserver -f ends with AM_MAZE_SOLVED");
+	printf("Fragmented game solved in %d moves: %.0f moves per second over loopback\n", moves, moves / seconds);
+	kill(server, SIGTERM);
+	waitpid(server, NULL, 0);
+
+	return testResults();
+}
@@ -0,0 +1,132 @@
+/*
+ * sim.c - 'sim' module
+ *
+ * see sim.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <netdb.h>	      // htonl
+#include "amazing.h"
+#include "avatar.h"
+#include "mazeSolver.h"
+#include "mazegen.h"
+#include "rendezvous.h"
+#include "strategy.h"
+#include "sim.h"
+
+// how the meeting point of the bfs and incremental strategies is chosen, as in AMStartup
+#ifndef RENDEZVOUS
+#define RENDEZVOUS RENDEZVOUS_MINMAX
+#endif
+
+/*
+ *	Plays the server and every client of one game, turn by turn, until it is solved or out of moves
+ */
+bool simPlay(const strategy_t *strategy, int nAvatars, int difficulty, unsigned int seed, int loops, int maxMoves, simResult_t *result) {
+	int width, height;
+	mazegenSize(difficulty, &width, &height);
+	result->solved = false;
+	result->moves = 0;
+	result->hash = 0;
+	result->width = width;
+	result->height = height;
+
+	// the server's maze and the clients' map of it, which starts empty
+	uint8_t *open = mazegenCarve(width, height, seed);
+	maze_t *maze = createMaze(height, width);
+	rendezvous_t *rendezvous = maze != NULL ? rendezvousNew(maze, RENDEZVOUS) : NULL;
+	avatar_t **avatars = createAvatars(nAvatars);
+	if (open == NULL || maze == NULL || rendezvous == NULL || avatars == NULL) {
+		free(open);
+		rendezvousDelete(rendezvous);
+		mazeDelete(maze);
+		if (avatars != NULL) {
+			deleteAvatars(avatars, nAvatars);
+		}
+		return false;
+	}
+
+	mazegenLoops(open, width, height, loops, seed);
+
+	// where the server puts everyone, as the first AM_AVATAR_TURN tells each avatar
+	int x[AM_MAX_AVATAR], y[AM_MAX_AVATAR];
+	XYPos positions[AM_MAX_AVATAR];
+	mazegenPlace(width, height, nAvatars, seed, x, y);
+	for (int k = 0; k < nAvatars; k++) {
+		avatars[k]->firstTurn = false;
+		setPosition(avatars[k], x[k], y[k]);
+		positions[k].x = htonl(x[k]);
+		positions[k].y = htonl(y[k]);
+	}
+
+	// the same context avatarSessionNew gives each avatar, with nothing to log to
+	int lastTurnID = -1;
+	int moveCount = 0;
+	strategyContext_t contexts[AM_MAX_AVATAR];
+	int ready = 0;
+	bool ok = true;
+	for (; ready < nAvatars && ok; ready++) {
+		strategyContext_t context = { ready, nAvatars, avatars, maze, rendezvous, &lastTurnID, NULL, &moveCount, NULL };
+		contexts[ready] = context;
+		ok = strategy->init(&contexts[ready]);
+	}
+	if (!ok) {
+		ready--;
+	}
+
+	int turn = 0;
+	while (ok) {
+		// the avatar holding the turn decides, as avatarHandleMessage would
+		int move = strategy->chooseMove(&contexts[turn], positions);
+		moveCount++;
+
+		// the server carries the move out
+		int fromX = x[turn];
+		int fromY = y[turn];
+		bool moved = move >= 0 && move < M_NUM_DIRECTIONS && (open[fromY * width + fromX] & (1 << move));
+		if (moved) {
+			x[turn] += deltaX[move];
+			y[turn] += deltaY[move];
+			positions[turn].x = htonl(x[turn]);
+			positions[turn].y = htonl(y[turn]);
+		}
+		result->moves++;
+		bool together = true;
+		for (int k = 1; k < nAvatars && together; k++) {
+			together = x[k] == x[0] && y[k] == y[0];
+		}
+		if (together) {
+			result->solved = true;
+			result->hash = mazegenHash(seed, width, height, nAvatars, difficulty, result->moves);
+			break;
+		}
+		if (result->moves >= maxMoves) {
+			break;
+		}
+
+		// the next turn message shows the mover where it ended up, and everyone the edge it crossed
+		if (moved) {
+			addOpening(maze, fromX, fromY, move);
+			setPosition(avatars[turn], x[turn], y[turn]);
+		} else if (move != M_NULL_MOVE) {
+			addWall(maze, fromX, fromY, move);
+		}
+		strategy->onMoveResult(&contexts[turn], move, moved);
+		turn = (turn + 1) % nAvatars;
+	}
+
+	for (int k = 0; k < ready; k++) {
+		strategy->teardown(&contexts[k]);
+	}
+	deleteAvatars(avatars, nAvatars);
+	rendezvousDelete(rendezvous);
+	mazeDelete(maze);
+	free(open);
+	return ok;
+}
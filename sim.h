@@ -0,0 +1,55 @@
+/*
+ * sim.h - header file for sim module
+ *
+ * This module plays whole games in process, with no server, sockets, window or log: it carves
+ * the maze and places the avatars as amserver does for the same seed, keeps the server's side of
+ * the game (whose turn it is, which moves run into walls, when everyone stands together) and
+ * gives every avatar's strategy exactly what runAvatar would: the positions on its turn, then the
+ * result of its move, recorded into the shared maze first. Strategies can so be tried over
+ * thousands of mazes in the time one live game takes.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __SIM_H
+#define __SIM_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "amazing.h"
+#include "strategy.h"
+
+/**************** structs ****************/
+
+/**************** simResult ****************/
+/*
+ * How a simulated game ended.
+ */
+typedef struct simResult {
+	bool solved;              // everyone met, rather than running out of moves
+	int moves;                // moves made, null moves included, as the server counts them
+	uint32_t hash;            // what AM_MAZE_SOLVED would have carried, 0 if not solved
+	int width;                // size of the maze played
+	int height;
+} simResult_t;
+
+/**************** functions ****************/
+
+/**************** simPlay ****************/
+/*
+ * Function which plays one game to the end from the calling thread. Games share nothing, so any
+ * number may be played at once from different threads.
+ *
+ * Input: Strategy every avatar plays, number of avatars (1 to AM_MAX_AVATAR), difficulty (0 to
+ * AM_MAX_DIFFICULTY), seed of the maze, as given to amserver, percent of inner walls knocked
+ * down for loops, as amserver -l (0 for a perfect maze), moves after which the game is lost
+ * (AM_MAX_MOVES for the server's limit), where to put the result.
+ *
+ * Output: False if memory could not be allocated or the strategy could not set itself up.
+ *
+ */
+bool simPlay(const strategy_t *strategy, int nAvatars, int difficulty, unsigned int seed, int loops, int maxMoves, simResult_t *result);
+
+#endif // __SIM_H
@@ -0,0 +1,148 @@
+/*
+ * simtest.c, a testing module for the game simulator in sim.c
+ *
+ * A lone avatar's game must end after its first move with the hash amserver would send. The
+ * same seed must always play the same game, and a game must stop at its move limit. Knocking
+ * walls down must leave the border alone and only ever open edges. Every strategy must then solve
+ * ten seeded mazes of each small size, with two to four avatars, both perfect and with loops;
+ * with loops lefthand must fall back to Tremaux marking and play differently from tremaux.
+ * Last, each strategy plays games for a second and the moves it simulated per second are printed.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include "amazing.h"
+#include "mazegen.h"
+#include "strategy.h"
+#include "latency.h"
+#include "sim.h"
+#include "testing.h"
+
+/**************** file-local constants ****************/
+#define MAX_MOVES 1000000         // enough for any strategy to finish
+#define GAMES 10                  // per strategy, difficulty and number of avatars
+#define MAX_DIFFICULTY 1          // the shortest path strategies replan over the whole maze on every move
+#define LOOPS 10                  // percent of inner walls knocked down for the mazes with loops
+#define TIMED_NANOS 1000000000LL  // per strategy
+#define TIMED_DIFFICULTY 2
+#define TIMED_AVATARS 3
+
+static const char *names[] = { "lefthand", "tremaux", "bfs", "incremental" };
+#define NUM_NAMES (sizeof(names) / sizeof(names[0]))
+
+/**************** main() ****************/
+int main(int argc, char *argv[]) {
+	simResult_t result, again;
+
+	// alone, the avatar stands with everyone after its first move, whatever it is
+	const strategy_t *lefthand = findStrategy("lefthand");
+	check(simPlay(lefthand, 1, 2, 7, 0, MAX_MOVES, &result), "a game can be set up");
+	check(result.solved && result.moves == 1, "a lone avatar's game ends after one move");
+	check(result.width == 30 && result.height == 30, "a difficulty 2 maze is 30x30");
+	check(result.hash == mazegenHash(7, 30, 30, 1, 2, 1), "the hash is the one amserver sends");
+
+	// a game stops at its move limit
+	check(simPlay(lefthand, 3, 5, 7, 0, 10, &result), "a game can be set up");
+	check(!result.solved && result.moves == 10 && result.hash == 0, "a game ends at its move limit");
+
+	// knocking walls down keeps the border and every edge already open, and opens edges on both sides
+	uint8_t *perfect = mazegenCarve(20, 20, 7);
+	uint8_t *looped = mazegenCarve(20, 20, 7);
+	uint8_t *all = mazegenCarve(20, 20, 7);
+	if (perfect != NULL && looped != NULL && all != NULL) {
+		mazegenLoops(looped, 20, 20, LOOPS, 7);
+		mazegenLoops(all, 20, 20, 100, 7);
+		int added = 0;
+		bool kept = true, border = true, everyInner = true;
+		for (int y = 0; y < 20; y++) {
+			for (int x = 0; x < 20; x++) {
+				int tile = y * 20 + x;
+				kept = kept && (looped[tile] & perfect[tile]) == perfect[tile];
+				for (int d = 0; d < M_NUM_DIRECTIONS; d++) {
+					added += ((looped[tile] & ~perfect[tile]) >> d) & 1;
+				}
+				border = border && !(x == 0 && (all[tile] & (1 << M_WEST))) && !(y == 0 && (all[tile] & (1 << M_NORTH)))
+						&& !(x == 19 && (all[tile] & (1 << M_EAST))) && !(y == 19 && (all[tile] & (1 << M_SOUTH)));
+				everyInner = everyInner && ((x == 19) || (all[tile] & (1 << M_EAST))) && ((y == 19) || (all[tile] & (1 << M_SOUTH)));
+			}
+		}
+		// a perfect 20x20 maze keeps 2 * 20 * 19 - 399 = 361 inner walls, each edge is counted from both tiles
+		printf("%d%% loops opened %d of 361 inner walls\n", LOOPS, added / 2);
+		check(kept && border && everyInner, "loops only open inner edges, and 100%% opens all of them");
+		check(added % 2 == 0 && added / 2 > 361 * LOOPS / 200 && added / 2 < 361 * LOOPS * 2 / 100, "loops open about the share of walls asked for");
+	}
+	else {
+		check(false, "a maze can be carved");
+	}
+	free(perfect);
+	free(looped);
+	free(all);
+
+	// every strategy plays the same game from the same seed, and solves every maze
+	for (size_t s = 0; s < NUM_NAMES; s++) {
+		const strategy_t *strategy = findStrategy(names[s]);
+		check(strategy != NULL, "every strategy is registered");
+		if (strategy == NULL) {
+			continue;
+		}
+		simPlay(strategy, 3, 1, 42, 0, MAX_MOVES, &result);
+		simPlay(strategy, 3, 1, 42, 0, MAX_MOVES, &again);
+		check(result.moves == again.moves && result.hash == again.hash, "a seed always plays the same game");
+
+		int unsolved = 0;
+		long long moves = 0;
+		for (int loops = 0; loops <= LOOPS; loops += LOOPS) {
+			for (int difficulty = 0; difficulty <= MAX_DIFFICULTY; difficulty++) {
+				for (int avatars = 2; avatars <= 4; avatars++) {
+					for (unsigned int seed = 1; seed <= GAMES; seed++) {
+						if (!simPlay(strategy, avatars, difficulty, seed, loops, MAX_MOVES, &result)) {
+							check(false, "a game can be set up");
+						}
+						unsolved += !result.solved;
+						moves += result.moves;
+					}
+				}
+			}
+		}
+		int games = 2 * (MAX_DIFFICULTY + 1) * 3 * GAMES;
+		printf("%-12s solved %d of %d games, %lld moves\n", names[s], games - unsolved, games, moves);
+		check(unsolved == 0, "every strategy solves every maze");
+	}
+
+	// in a perfect maze Tremaux marking walks exactly the left wall; with loops lefthand goes round one first
+	int perfectDiffer = 0, loopedDiffer = 0;
+	const strategy_t *tremaux = findStrategy("tremaux");
+	for (unsigned int seed = 1; seed <= GAMES; seed++) {
+		simPlay(lefthand, 3, MAX_DIFFICULTY, seed, 0, MAX_MOVES, &result);
+		simPlay(tremaux, 3, MAX_DIFFICULTY, seed, 0, MAX_MOVES, &again);
+		perfectDiffer += result.moves != again.moves;
+		simPlay(lefthand, 3, MAX_DIFFICULTY, seed, LOOPS, MAX_MOVES, &result);
+		simPlay(tremaux, 3, MAX_DIFFICULTY, seed, LOOPS, MAX_MOVES, &again);
+		loopedDiffer += result.moves != again.moves;
+	}
+	printf("lefthand and tremaux differ in %d of %d perfect mazes and %d of %d with loops\n", perfectDiffer, GAMES, loopedDiffer, GAMES);
+	check(perfectDiffer == 0, "lefthand and tremaux play perfect mazes alike");
+	check(loopedDiffer > 0, "lefthand and tremaux play mazes with loops differently");
+
+	// moves simulated per second, playing games from seed 1 on for a second
+	for (size_t s = 0; s < NUM_NAMES; s++) {
+		const strategy_t *strategy = findStrategy(names[s]);
+		long long moves = 0;
+		int games = 0;
+		long long start = latencyNow();
+		long long elapsed = 0;
+		while (elapsed < TIMED_NANOS) {
+			simPlay(strategy, TIMED_AVATARS, TIMED_DIFFICULTY, ++games, 0, MAX_MOVES, &result);
+			moves += result.moves;
+			elapsed = latencyNow() - start;
+		}
+		printf("%-12s %d games of %d avatars at difficulty %d: %lld moves in %.3f s, %.0f moves per second\n",
+				names[s], games, TIMED_AVATARS, TIMED_DIFFICULTY, moves, elapsed / 1e9, moves * 1e9 / elapsed);
+	}
+
+	return testResults();
+}
@@ -0,0 +1,325 @@
+/*
+ * strategy.c - 'strategy' module
+ *
+ * see strategy.h for more information.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>       // strcmp, memset
+#include "amazing.h"
+#include "avatar.h"
+#include "mazeSolver.h"
+#include "planner.h"
+#include "rendezvous.h"
+#include "strategy.h"
+#include "logger.h"
+
+// ------------------------ lefthand / tremaux ----------------------
+
+// how many recent (tile, facing) states are kept to measure the length of a loop
+#define LOOP_WINDOW 1024
+
+// Trémaux marks are kept per tile, two bits for each of its four edges
+#define MARK(marks, tile, direction) (((marks)[tile] >> (2 * (direction))) & 3)
+
+static const int opposite[M_NUM_DIRECTIONS] = { M_EAST, M_SOUTH, M_NORTH, M_WEST };
+
+/*
+ *	State of a wall follower. Every (tile, facing) it reaches after a successful move sets a bit in
+ *	'history'; with the walls it knows unchanged, reaching one again means it is going round in
+ *	circles, and it switches to Trémaux marking, from a clean slate, for the rest of the game. Its own blocked moves
+ *	change what it knows, so they clear the history.
+ */
+typedef struct wallFollower {
+	int width;
+	int oldDirection;          // facing before the last move, to turn back to if it is blocked
+	bool tremaux;              // marking edges instead of following the left wall
+	uint64_t *history;         // one bit per (tile, facing)
+	uint32_t recent[LOOP_WINDOW];  // the last states reached, oldest overwritten first
+	long states;               // states reached since the history was cleared
+	uint8_t *marks;            // Trémaux marks, see MARK
+	int entry;                 // edge of the current tile the avatar came in through, or M_NULL_MOVE
+	int moveX;                 // tile the last move was chosen on
+	int moveY;
+	int blockedMoves;          // moves into a wall
+	int circlingMoves;         // moves spent going once round a loop before it was noticed
+} wallFollower_t;
+
+/*
+ *	Allocates the history and marks for every tile; 'tremaux' starts with marking right away
+ */
+static bool wallFollowerInit(strategyContext_t *context, bool tremaux) {
+	int width = getMazeWidth(context->maze);
+	int tiles = width * getMazeHeight(context->maze);
+	wallFollower_t *follower = malloc(sizeof(wallFollower_t));
+	if (follower == NULL) {
+		fprintf(stderr, "Failed to malloc for wall follower\n");
+		return false;
+	}
+	follower->history = calloc((4 * tiles + 63) / 64, sizeof(uint64_t));
+	follower->marks = calloc(tiles, sizeof(uint8_t));
+	if (follower->history == NULL || follower->marks == NULL) {
+		fprintf(stderr, "Failed to malloc for wall follower history\n");
+		free(follower->history);
+		free(follower->marks);
+		free(follower);
+		return false;
+	}
+	follower->width = width;
+	follower->oldDirection = context->avatars[context->avatarID]->direction;
+	follower->tremaux = tremaux;
+	follower->states = 0;
+	follower->entry = M_NULL_MOVE;
+	follower->moveX = -1;
+	follower->moveY = -1;
+	follower->blockedMoves = 0;
+	follower->circlingMoves = 0;
+	context->state = follower;
+	return true;
+}
+
+static bool leftHandInit(strategyContext_t *context) {
+	return wallFollowerInit(context, false);
+}
+
+static bool tremauxInit(strategyContext_t *context) {
+	return wallFollowerInit(context, true);
+}
+
+/*
+ *	Trémaux's rule: never take an edge twice in the same direction. At a tile seen before, arriving
+ *	over a fresh edge, go straight back; otherwise take the least marked open edge, unmarked ones first.
+ */
+static int tremauxRule(strategyContext_t *context, wallFollower_t *follower) {
+	avatar_t *avatar = context->avatars[context->avatarID];
+	avatar_t *goal = context->avatars[context->numAvatars - 1];
+	(*context->lastTurnID) = avatar->avatarID;
+
+	// like leftHandRule, the last avatar waits and everyone else stops on its tile
+	if (avatar->avatarID == context->numAvatars - 1 || (avatar->xCoord == goal->xCoord && avatar->yCoord == goal->yCoord)) {
+		avatar->direction = M_NULL_MOVE;
+		return M_NULL_MOVE;
+	}
+
+	int tile = avatar->yCoord * follower->width + avatar->xCoord;
+	int walls = getWalls(context->maze, avatar->xCoord, avatar->yCoord);
+	int entry = follower->entry;
+	bool seenBefore = false;
+	for (int direction = 0; direction < M_NUM_DIRECTIONS; direction++) {
+		if (direction != entry && MARK(follower->marks, tile, direction) > 0) {
+			seenBefore = true;
+		}
+	}
+	if (seenBefore && entry != M_NULL_MOVE && MARK(follower->marks, tile, entry) == 1 && !(walls & (1 << entry))) {
+		avatar->direction = entry;
+		return entry;
+	}
+
+	// least marked edge, in left hand order from the way the avatar faces, the way back last
+	int facing = avatar->direction < M_NUM_DIRECTIONS ? avatar->direction : M_SOUTH;
+	static const int leftHandOrder[M_NUM_DIRECTIONS][M_NUM_DIRECTIONS] = {
+		{ M_SOUTH, M_WEST, M_NORTH, M_EAST },     // facing west
+		{ M_WEST, M_NORTH, M_EAST, M_SOUTH },     // facing north
+		{ M_EAST, M_SOUTH, M_WEST, M_NORTH },     // facing south
+		{ M_NORTH, M_EAST, M_SOUTH, M_WEST },     // facing east
+	};
+	int best = M_NULL_MOVE;
+	int bestScore = 0;
+	for (int i = 0; i < M_NUM_DIRECTIONS; i++) {
+		int direction = leftHandOrder[facing][i];
+		int mark = MARK(follower->marks, tile, direction);
+		int score = mark + (direction == entry ? 1 : 0);
+		if (!(walls & (1 << direction)) && mark < 2 && (best == M_NULL_MOVE || score < bestScore)) {
+			best = direction;
+			bestScore = score;
+		}
+	}
+	if (best != M_NULL_MOVE) {
+		avatar->direction = best;
+	}
+	return best;
+}
+
+static int leftHandMove(strategyContext_t *context, XYPos *positions) {
+	wallFollower_t *follower = context->state;
+	avatar_t *avatar = context->avatars[context->avatarID];
+	follower->oldDirection = avatar->direction;
+	follower->moveX = avatar->xCoord;
+	follower->moveY = avatar->yCoord;
+	if (follower->tremaux) {
+		return tremauxRule(context, follower);
+	}
+	return leftHandRule(avatar, getWalls(context->maze, avatar->xCoord, avatar->yCoord), context->lastTurnID, context->numAvatars, context->avatars);
+}
+
+/*
+ *	Marks the edge just crossed and, while following the left wall, checks whether this (tile, facing) was reached before
+ */
+static void leftHandResult(strategyContext_t *context, int move, bool moved) {
+	wallFollower_t *follower = context->state;
+	avatar_t *avatar = context->avatars[context->avatarID];
+	if (move == M_NULL_MOVE) {
+		return;
+	}
+
+	// a blocked move leaves the avatar facing the way it did before, to turn from there
+	if (!moved) {
+		setDirection(avatar, follower->oldDirection);
+		follower->blockedMoves++;
+		if (!follower->tremaux && follower->states > 0) {
+			memset(follower->history, 0, (4 * follower->width * getMazeHeight(context->maze) + 63) / 64 * sizeof(uint64_t));
+			follower->states = 0;
+		}
+		return;
+	}
+
+	// a result this avatar missed leaves it further than one step away; start afresh from there
+	if (avatar->xCoord != follower->moveX + deltaX[move] || avatar->yCoord != follower->moveY + deltaY[move]) {
+		follower->entry = M_NULL_MOVE;
+		return;
+	}
+
+	// both ends of the edge get a mark, so it counts the same from either tile
+	int tile = avatar->yCoord * follower->width + avatar->xCoord;
+	int from = tile - deltaY[move] * follower->width - deltaX[move];
+	if (MARK(follower->marks, from, move) < 3) {
+		follower->marks[from] += 1 << (2 * move);
+		follower->marks[tile] += 1 << (2 * opposite[move]);
+	}
+	follower->entry = opposite[move];
+	if (follower->tremaux) {
+		return;
+	}
+
+	uint32_t state = 4 * tile + move;
+	if (follower->history[state / 64] & (1ULL << (state % 64))) {
+		// the loop is as long as the distance back to this state's last visit, if it is still remembered
+		int length = LOOP_WINDOW;
+		for (int back = 1; back <= LOOP_WINDOW && back <= follower->states; back++) {
+			if (follower->recent[(follower->states - back) % LOOP_WINDOW] == state) {
+				length = back;
+				break;
+			}
+		}
+		follower->circlingMoves += length;
+		follower->tremaux = true;
+
+		// marks left by wall following do not form a Trémaux path and can shut the avatar in, so mark afresh from here
+		memset(follower->marks, 0, follower->width * getMazeHeight(context->maze) * sizeof(uint8_t));
+		follower->entry = M_NULL_MOVE;
+		loggerPush(context->log, context->avatarID, LOG_LOOP, avatar->avatarID, avatar->xCoord, avatar->yCoord, parseDirection(move), length, *context->moveCount);
+		return;
+	}
+	follower->history[state / 64] |= 1ULL << (state % 64);
+	follower->recent[follower->states % LOOP_WINDOW] = state;
+	follower->states++;
+}
+
+/*
+ *	Logs the moves the avatar wasted before freeing its state
+ */
+static void leftHandTeardown(strategyContext_t *context) {
+	wallFollower_t *follower = context->state;
+	loggerPush(context->log, context->avatarID, LOG_WASTED, context->avatarID,
+			follower->blockedMoves + follower->circlingMoves, follower->blockedMoves, follower->circlingMoves);
+	free(follower->history);
+	free(follower->marks);
+	free(follower);
+	context->state = NULL;
+}
+
+// ------------------------ bfs / incremental ----------------------
+
+/*
+ *	Gives the avatar its own planner of the given mode; the rendezvous is shared by all of them
+ */
+static bool plannerInit(strategyContext_t *context, int mode) {
+	if (context->rendezvous == NULL) {
+		fprintf(stderr, "Shortest path strategies need a rendezvous\n");
+		return false;
+	}
+	context->state = plannerNew(context->maze, mode);
+	return context->state != NULL;
+}
+
+static bool bfsInit(strategyContext_t *context) {
+	return plannerInit(context, PLANNER_BFS);
+}
+
+static bool incrementalInit(strategyContext_t *context) {
+	return plannerInit(context, PLANNER_INCREMENTAL);
+}
+
+static int plannerStrategyMove(strategyContext_t *context, XYPos *positions) {
+	// Whoever holds the turn moves the meeting point as the map fills in
+	if (rendezvousUpdate(context->rendezvous, positions, context->numAvatars)) {
+		int meetX, meetY;
+		rendezvousTarget(context->rendezvous, &meetX, &meetY);
+		loggerPush(context->log, context->avatarID, LOG_RENDEZVOUS, meetX, meetY, rendezvousCost(context->rendezvous), *context->moveCount+1);
+	}
+
+	// An incremental planner whose goal moved starts from the rendezvous's field instead of building its own
+	rendezvousShareField(context->rendezvous, context->state);
+	return shortestPathRule(context->avatars[context->avatarID], context->state, context->rendezvous, context->lastTurnID);
+}
+
+static void plannerStrategyResult(strategyContext_t *context, int move, bool moved) {
+	// blocked moves are already in the maze, where the planner picks them up
+}
+
+static void plannerTeardown(strategyContext_t *context) {
+	plannerDelete(context->state);
+	context->state = NULL;
+}
+
+// ------------------------ registry ----------------------
+
+static const strategy_t strategies[] = {
+	{ "lefthand", "follow the left wall to the last avatar, which stays put; Tremaux marking once going in circles",
+		leftHandInit, leftHandMove, leftHandResult, leftHandTeardown },
+	{ "tremaux", "walk to the last avatar with Tremaux marking from the start",
+		tremauxInit, leftHandMove, leftHandResult, leftHandTeardown },
+	{ "bfs", "walk a BFS shortest path over the known maze to a shared rendezvous",
+		bfsInit, plannerStrategyMove, plannerStrategyResult, plannerTeardown },
+	{ "incremental", "like bfs, repairing distances incrementally as walls are found",
+		incrementalInit, plannerStrategyMove, plannerStrategyResult, plannerTeardown },
+};
+
+#define NUM_STRATEGIES (sizeof(strategies) / sizeof(strategies[0]))
+
+/*
+ *	Returns the registered strategy with the given name, or NULL
+ */
+const strategy_t *findStrategy(const char *name) {
+	for (size_t i = 0; i < NUM_STRATEGIES; i++) {
+		if (strcmp(strategies[i].name, name) == 0) {
+			return &strategies[i];
+		}
+	}
+	return NULL;
+}
+
+/*
+ *	Prints the name and description of every registered strategy
+ */
+void printStrategies(FILE *fp) {
+	for (size_t i = 0; i < NUM_STRATEGIES; i++) {
+		fprintf(fp, "  %-12s %s\n", strategies[i].name, strategies[i].description);
+	}
+}
+
+/*
+ *	Returns the registered strategy at the given place in the registry, or NULL past its end
+ */
+const strategy_t *strategyAt(int index) {
+	if (index < 0 || (size_t)index >= NUM_STRATEGIES) {
+		return NULL;
+	}
+	return &strategies[index];
+}
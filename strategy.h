@@ -0,0 +1,108 @@
+/*
+ * strategy.h - header file for strategy module
+ *
+ * This module holds the move strategies an avatar can play with. Each strategy is a table of
+ * hooks that runAvatar calls at fixed points of the game, and every strategy is listed by name
+ * in a registry so AMStartup can pick one with `-s <strategy>`.
+ * See function headers for in depth descriptions.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __STRATEGY_H
+#define __STRATEGY_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include "amazing.h"
+#include "avatar.h"
+#include "mazeSolver.h"
+
+/**************** constants ****************/
+
+// strategy used when AMStartup is not given -s
+#define DEFAULT_STRATEGY "lefthand"
+
+/**************** structs ****************/
+
+/**************** strategyContext ****************/
+/*
+ * Everything a strategy may look at or keep for one avatar. runAvatar fills it in before
+ * calling init; 'state' belongs to the strategy.
+ */
+typedef struct strategyContext {
+	int avatarID;
+	int numAvatars;
+	avatar_t **avatars;
+	maze_t *maze;
+	rendezvous_t *rendezvous;
+	int *lastTurnID;
+	logger_t *log;
+	int *moveCount;
+	void *state;
+} strategyContext_t;
+
+/**************** strategy ****************/
+/*
+ * Table of hooks making up a strategy:
+ *
+ * init - called once per avatar by avatarSessionNew, on the main thread before any avatar connects
+ * or any avatar thread is created. Whatever it sets up in 'state' is then used only by the thread
+ * (or event loop) playing that avatar; pthread_create orders the two. Returns false if the strategy
+ * could not set itself up, which ends the game.
+ *
+ * chooseMove - called when the avatar holds the turn, with the positions of every avatar from
+ * the AM_AVATAR_TURN (network byte order). Returns an M_* direction or M_NULL_MOVE.
+ *
+ * onMoveResult - called once the server answered the avatar's move, after runAvatar recorded a
+ * wall if the move was blocked. 'moved' tells whether the avatar changed tiles.
+ *
+ * teardown - called once by avatarSessionDelete, on the thread that played the avatar when it
+ * exits (the main thread with -e); frees whatever init allocated.
+ */
+typedef struct strategy {
+	const char *name;
+	const char *description;
+	bool (*init)(strategyContext_t *context);
+	int (*chooseMove)(strategyContext_t *context, XYPos *positions);
+	void (*onMoveResult)(strategyContext_t *context, int move, bool moved);
+	void (*teardown)(strategyContext_t *context);
+} strategy_t;
+
+/**************** functions ****************/
+
+/**************** findStrategy ****************/
+/*
+ * Function which looks a strategy up in the registry.
+ *
+ * Input: Name of the strategy, as given to AMStartup's -s flag.
+ *
+ * Output: The strategy, or NULL if no strategy has that name.
+ *
+ */
+const strategy_t *findStrategy(const char *name);
+
+/**************** printStrategies ****************/
+/*
+ * Function which lists every registered strategy.
+ *
+ * Input: File to print to.
+ *
+ * Output: One line per strategy with its name and description.
+ *
+ */
+void printStrategies(FILE *fp);
+
+/**************** strategyAt ****************/
+/*
+ * Function which walks the registry, e.g. to play every strategy.
+ *
+ * Input: Place in the registry, from 0.
+ *
+ * Output: The strategy there, or NULL past the last one.
+ *
+ */
+const strategy_t *strategyAt(int index);
+
+#endif // __STRATEGY_H
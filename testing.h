@@ -0,0 +1,49 @@
+/*
+ * testing.h - checks shared by the unit tests
+ *
+ * Each test counts its failed checks here, prints every one as it happens, and ends with the
+ * "Test Results Successful" or "Test Results Failed" line that testing.sh looks for. The
+ * definitions are static, so every test program gets its own count.
+ *
+ * Written by:
+ * Luca Lit, Sean Simons, Connor Davis, and Mack Reiferson Winter 2020
+ */
+
+#ifndef __TESTING_H
+#define __TESTING_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+static int failures = 0;
+
+/**************** check ****************/
+/*
+ * Records a failed check
+ *
+ * Input: whether the check held, and what it checks
+ * Output: prints "FAILED: " and what it checks if it did not hold
+ */
+static inline void check(bool ok, const char *what) {
+	if (!ok) {
+		printf("FAILED: %s\n", what);
+		failures++;
+	}
+}
+
+/**************** testResults ****************/
+/*
+ * Prints the test's result line
+ *
+ * Output: 0 if every check held, 1 otherwise, for main to return
+ */
+static inline int testResults(void) {
+	if (failures != 0) {
+		printf("Test Results Failed\n");
+		return 1;
+	}
+	printf("Test Results Successful\n");
+	return 0;
+}
+
+#endif // __TESTING_H
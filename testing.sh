@@ -33,6 +33,11 @@ echo "-> Testing w/ 2 arguments"
 ./AMStartup -h flume.cs.dartmouth.edu -d 3
 echo -e "\n"
 
+# Test AMStartup with optional flags standing in for a required one
+echo "-> Testing w/ -n missing among other flags"
+./AMStartup -h flume.cs.dartmouth.edu -d 3 -s bfs -e -q
+echo -e "\n"
+
 # Test AMStartup with invalid difficulty
 echo "-> Testing w/ invalid difficulty"
 ./AMStartup -h flume.cs.dartmouth.edu -d 10 -n 3
@@ -43,6 +48,11 @@ echo "-> Testing w/ invalid numAvatars"
 ./AMStartup -h flume.cs.dartmouth.edu -d 5 -n 11
 echo -e "\n"
 
+# Test AMStartup with an unknown strategy
+echo "-> Testing w/ invalid strategy"
+./AMStartup -h flume.cs.dartmouth.edu -d 5 -n 3 -s bogus
+echo -e "\n"
+
 
 # -------NETWORK TESTING--------
 echo -e "TESTING NETWORK"
@@ -59,5 +69,108 @@ echo "-> Unit testing avatar.c and mazeSolver.c modules" >> testing.out
 ./designTest >> testing.out
 echo -e "\n" >> testing.out
 
+echo "-> Stress testing the shared wall map in mazeSolver.c"
+./mazetest
+echo -e "\n"
+
+echo "-> Testing incremental replanning in planner.c"
+./plannertest
+echo -e "\n"
+
+echo "-> Checking the table-driven leftHandRule against the old rule and the logged games"
+./kerneltest log.out/Amazing_*
+echo -e "\n"
+
+echo "-> Testing message framing in conn.c"
+./conntest
+echo -e "\n"
+
+echo "-> Testing the turn latency histograms in latency.c"
+./latencytest
+echo -e "\n"
+
+echo "-> Testing the log writer thread in logger.c"
+./loggertest
+echo -e "\n"
+
+echo "-> Playing games against the local amserver"
+./servertest
+echo -e "\n"
+
+echo "-> Headless games against the local amserver, with threads and with the event loop, then one traced and converted by amtrace"
+./amserver -p 17235 -s 7 -m 100000 > /dev/null 2>&1 &
+SERVER=$!
+sleep 0.5
+for ENGINE in "" "-e"; do
+	SUMMARY=$(USER=amtest ./AMStartup -h localhost -d 1 -n 3 -q $ENGINE)
+	echo "$SUMMARY"
+	if [[ "$SUMMARY" == result=solved* ]]; then
+		echo "Test Results Successful"
+	else
+		echo "Test Results Failed"
+	fi
+done
+USER=amtest ./AMStartup -h localhost -d 1 -n 3 -q -t > /dev/null
+./amtrace log.out/Amazing_amtest_3_1.trace
+if grep -q "^Solved!" log.out/Amazing_amtest_3_1; then
+	echo "Test Results Successful"
+else
+	echo "Test Results Failed"
+fi
+kill $SERVER
+rm -f log.out/Amazing_amtest_*
+echo -e "\n"
+
+echo "-> A captured game replayed by amreplay: the same strategy must make every recorded move, another must not"
+./amserver -p 17235 -s 7 -m 100000 > /dev/null 2>&1 &
+SERVER=$!
+sleep 0.5
+USER=amtest ./AMStartup -h localhost -d 2 -n 3 -q -e -c amtest.cap > /dev/null
+kill $SERVER
+if ./amreplay amtest.cap && ! ./amreplay -s bfs amtest.cap > /dev/null; then
+	echo "Test Results Successful"
+else
+	echo "Test Results Failed"
+fi
+rm -f amtest.cap log.out/Amazing_amtest_*
+echo -e "\n"
+
+echo "-> Unit testing sim.c module"
+./simtest
+echo -e "\n"
+
+for LOOPS in 0 10; do
+	echo "-> A game simulated by amsim must end as the same game played against amserver, with $LOOPS% loops"
+	./amserver -p 17235 -s 7 -m 100000 -l $LOOPS > /dev/null 2>&1 &
+	SERVER=$!
+	sleep 0.5
+	LIVE=$(USER=amtest ./AMStartup -h localhost -d 2 -n 3 -q -e | cut -d' ' -f1-5)
+	kill $SERVER
+	SIMULATED=$(./amsim -d 2 -n 3 -S 7 -l $LOOPS -m 100000 -v | head -1 | cut -d' ' -f1-5)
+	echo "$LIVE"
+	echo "$SIMULATED"
+	if [[ -n "$LIVE" && "$LIVE" == "$SIMULATED" ]]; then
+		echo "Test Results Successful"
+	else
+		echo "Test Results Failed"
+	fi
+	rm -f log.out/Amazing_amtest_*
+	echo -e "\n"
+done
+
+echo "-> Unit testing pool.c module"
+./pooltest
+echo -e "\n"
+
+echo "-> A small amtournament must report every game and name a default for every pair"
+OUT=$(./amtournament -s lefthand,tremaux -d 0-1 -n 2-3 -g 50 -j 4)
+echo "$OUT"
+if [[ $(echo "$OUT" | grep -c '^default ') -eq 4 && -n $(echo "$OUT" | grep '^Pool: 4 workers, 400 games') ]]; then
+	echo "Test Results Successful"
+else
+	echo "Test Results Failed"
+fi
+echo -e "\n"
+
 echo "-> Unit testing graphics.c module"
 ./graphicstest